@@ -7,284 +7,1353 @@
  * 3. 각 함수의 파라미터 (타입과 변수명) 추출
  * 4. (정의된 함수의 경우) 함수 본문 내 if 조건문의 개수 추출
  *
- * 참고: JSON 파싱은 제공된 json_c.c 라이브러리(헤더 포함)를 사용하며,
- *       json_create() 함수를 이용해 문자열을 JSON 객체로 변환합니다.
+ * 참고: 분석 자체는 ast_analyzer.c 라이브러리(출력 없이 결과 구조체를 채움)가 하고, 이 파일은 명령행 도구입니다.
+ *       JSON 파싱은 제공된 json_c.c 라이브러리(헤더 포함)를 사용하며,
+ *       재사용 가능한 json_parser 컨텍스트(json_parser_parse())로 문자열을 JSON 객체로 변환합니다.
+ *       여러 AST 파일을 인자로 주면 하나의 parser를 재사용하여 차례대로 분석합니다.
+ *
+ * --function 필터를 주면 ext 단계에서 이름을 먼저 확인하고, 맞지 않는 FuncDef의 본문(body)은
+ * 파서가 건너뛰어 원문 구간(JSON_RAW)으로만 남겨 두므로 객체로 만들어지지 않습니다.
+ *
+ * --emit-c 경로를 주면 같은 문서를 C 소스로 다시 씁니다 (ast_emit.c).
+ *
+ * 입력이 .c/.i/.h 파일이면 JSON을 거치지 않고 ast_cparse.c가 전처리된 C 소스를 같은 AST로 바로 파싱합니다.
+ * (pycparser → JSON 직렬화 → JSON 파싱 단계가 없어지며, 노드와 coord는 pycparser와 같습니다)
  *
  * 컴파일 예시:
- *   gcc analyzer.c json_c.c -o analyzer
+ *   gcc analyzer.c -o analyzer -pthread -lm
+ *
+ * 파일 크기와 인덱스는 64비트(off_t, size_t, json_index)로 다루므로
+ * 4GB 이상의 AST도 LP64 환경에서 그대로 처리할 수 있습니다.
  */
 
+#define _FILE_OFFSET_BITS 64
+
 #include <stdio.h>
+#include <sys/types.h>
 #include <memory.h>
 #include "json_c.c"
+#include "json_bp.c"
+#include "ast_analyzer.c"
+#include "ast_emit.c"
+#include "ast_cparse.c"
 #include <string.h>
+#include <fnmatch.h>
+#include <regex.h>
+#include <math.h>
 
 #define MAX_BUF 1024
 
-// --- 재귀적으로 AST를 순회하여 if 노드("_nodetype"가 "If") 개수를 셉니다 ---
-int count_if_nodes(json_value node)
+// --- 명령행 옵션 ---
+typedef struct analyzer_options_s
 {
-    int count = 0;
-    // 현재 노드가 객체인 경우
-    if (node.type == JSON_OBJECT && node.value != NULL)
+    const char *bp_path; // --write-bp: 파싱한 문서를 succinct(BP) 형식으로 보관할 경로
+    const char *emit_path; // --emit-c: 문서를 C 소스로 다시 써서 저장할 경로 ("-"이면 표준 출력)
+    bool use_index;      // --index: preorder/서브트리 크기 색인으로 서브트리 질의를 O(1)에 처리
+    int jobs;            // --jobs: 큰 함수 본문을 나누어 순회할 스레드 수
+    const struct function_filter_s *filter; // --function: 분석할 함수 이름 필터 (NULL이면 전부)
+    struct corpus_stats_s *stats;           // --stats: 배치 전체 집계 (NULL이면 집계하지 않음)
+    struct sample_stats_s *sample;          // --sample: 표본 추출 상태와 추정량 (NULL이면 전수 분석)
+} analyzer_options;
+
+// --- 함수명, 리턴타입, 파라미터 정보, if 조건문 개수를 출력합니다 ---
+void print_function(const function_record *rec)
+{
+    printf("Function: %s\n", rec->name);
+    printf("Return Type: %s\n", rec->return_type);
+    printf("Parameters:\n");
+    if (!rec->has_params)
+        printf("None");
+    for (int64_t i = 0; i < rec->metrics[METRIC_PARAMS]; i++)
+        printf("    %s %s\n", rec->params[i].type, rec->params[i].name);
+    if (rec->is_definition)
+        printf("if-condition count: %lld\n", (long long)rec->metrics[METRIC_IFS]);
+    printf("\n");
+}
+
+/*
+ * function_report: --where 조건 필터와 --top K 선택.
+ * top-K는 크기 K의 min-heap에 지금까지의 상위 K개만 유지하므로 코퍼스 크기와 무관하게 O(K) 메모리를 씁니다.
+ * 힙의 루트는 "가장 약한" 레코드이며, 새 레코드가 그보다 강할 때만 교체됩니다.
+ * (함수 단위 처리는 단일 스레드이므로 힙도 하나입니다.)
+ */
+typedef enum where_op_enum
+{
+    WHERE_NONE = 0,
+    WHERE_GT,
+    WHERE_GE,
+    WHERE_LT,
+    WHERE_LE,
+    WHERE_EQ
+} where_op;
+
+typedef struct function_report_s
+{
+    where_op op;
+    function_metric where_metric;
+    int64_t where_value;
+    int64_t top;        // 0이면 top-K 없이 조건에 맞는 함수를 바로 출력
+    function_metric by;
+    function_record *heap;
+    int64_t heap_count;
+    int64_t matched;
+    int64_t sequence;
+} function_report;
+
+static bool function_metric_parse(const char *name, size_t len, function_metric *out)
+{
+    for (int m = 0; m < METRIC_COUNT; m++)
     {
-        json_object *obj = (json_object *)node.value;
-        for (int i = 0; i <= obj->last_index; i++)
+        if (strlen(function_metric_names[m]) == len && strncmp(function_metric_names[m], name, len) == 0)
         {
-            if (obj->keys[i] != NULL && strcmp(obj->keys[i], "_nodetype") == 0)
-            {
-                json_value nodetype_val = obj->values[i];
-                if (nodetype_val.type == JSON_STRING)
-                {
-                    char *nodetype = json_to_string(nodetype_val);
-                    if (strcmp(nodetype, "If") == 0)
-                        count++;
-                }
-            }
-            count += count_if_nodes(obj->values[i]);
+            *out = (function_metric)m;
+            return true;
         }
     }
-    // 현재 노드가 배열인 경우
-    else if (node.type == JSON_ARRAY && node.value != NULL)
+    return false;
+}
+
+// "ifs>20", "params>=3", "nodes<100" 같은 조건을 해석합니다
+bool function_report_parse_where(function_report *report, const char *expr)
+{
+    size_t len = strcspn(expr, "<>=");
+    const char *op = expr + len;
+    const char *number;
+    if (strncmp(op, ">=", 2) == 0)
+        report->op = WHERE_GE, number = op + 2;
+    else if (strncmp(op, "<=", 2) == 0)
+        report->op = WHERE_LE, number = op + 2;
+    else if (strncmp(op, "==", 2) == 0)
+        report->op = WHERE_EQ, number = op + 2;
+    else if (*op == '>')
+        report->op = WHERE_GT, number = op + 1;
+    else if (*op == '<')
+        report->op = WHERE_LT, number = op + 1;
+    else if (*op == '=')
+        report->op = WHERE_EQ, number = op + 1;
+    else
+        return false;
+    char *end;
+    report->where_value = strtoll(number, &end, 10);
+    return end != number && *end == '\0' && function_metric_parse(expr, len, &report->where_metric);
+}
+
+static bool function_report_where(const function_report *report, const function_record *rec)
+{
+    int64_t v = rec->metrics[report->where_metric];
+    switch (report->op)
+    {
+    case WHERE_GT:
+        return v > report->where_value;
+    case WHERE_GE:
+        return v >= report->where_value;
+    case WHERE_LT:
+        return v < report->where_value;
+    case WHERE_LE:
+        return v <= report->where_value;
+    case WHERE_EQ:
+        return v == report->where_value;
+    default:
+        return true;
+    }
+}
+
+// a가 b보다 "강한"지: 메트릭이 크거나, 같으면 먼저 나온 함수
+static bool function_record_stronger(const function_report *report, const function_record *a, const function_record *b)
+{
+    if (a->metrics[report->by] != b->metrics[report->by])
+        return a->metrics[report->by] > b->metrics[report->by];
+    return a->sequence < b->sequence;
+}
+
+static void function_heap_sift_down(function_report *report, int64_t i)
+{
+    function_record *heap = report->heap;
+    while (true)
+    {
+        int64_t weakest = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < report->heap_count && function_record_stronger(report, &heap[weakest], &heap[l]))
+            weakest = l;
+        if (r < report->heap_count && function_record_stronger(report, &heap[weakest], &heap[r]))
+            weakest = r;
+        if (weakest == i)
+            return;
+        function_record tmp = heap[i];
+        heap[i] = heap[weakest];
+        heap[weakest] = tmp;
+        i = weakest;
+    }
+}
+
+static void function_heap_push(function_report *report, function_record *rec)
+{
+    if (report->heap_count == report->top)
     {
-        json_array *arr = (json_array *)node.value;
-        for (int i = 0; i <= arr->last_index; i++)
+        // 가득 찬 힙: 루트(가장 약한 레코드)보다 강할 때만 교체
+        if (!function_record_stronger(report, rec, &report->heap[0]))
+        {
+            function_record_release(rec);
+            return;
+        }
+        if (!function_record_detach(rec))
         {
-            count += count_if_nodes(arr->values[i]);
+            function_record_release(rec);
+            return;
         }
+        function_record_release(&report->heap[0]);
+        report->heap[0] = *rec;
+        function_heap_sift_down(report, 0);
+        return;
+    }
+    if (!function_record_detach(rec))
+    {
+        function_record_release(rec);
+        return;
+    }
+    int64_t i = report->heap_count++;
+    report->heap[i] = *rec;
+    while (i > 0)
+    {
+        int64_t parent = (i - 1) / 2;
+        if (!function_record_stronger(report, &report->heap[parent], &report->heap[i]))
+            break;
+        function_record tmp = report->heap[i];
+        report->heap[i] = report->heap[parent];
+        report->heap[parent] = tmp;
+        i = parent;
     }
-    return count;
 }
 
-// --- JSON 객체에서 문자열 값 추출 (타입이 JSON_STRING일 경우) ---
-char *get_json_string(json_value node)
+bool function_report_init(function_report *report)
 {
-    if (node.type == JSON_STRING && node.value != NULL)
-        return (char *)node.value;
-    return NULL;
+    if (report->top > 0)
+    {
+        report->heap = (function_record *)malloc(sizeof(function_record) * (size_t)report->top);
+        if (report->heap == NULL)
+        {
+            fprintf(stderr, "메모리 할당 에러\n");
+            return false;
+        }
+    }
+    return true;
 }
 
-/*
- * extract_type: 재귀적으로 AST 노드의 타입 정보를 추출하여 문자열로 반환.
- * 처리 방식:
- *   - IdentifierType: names 배열의 첫 번째 원소 반환
- *   - TypeDecl, Typename: 내부 "type" 필드를 재귀 호출
- *   - PtrDecl: 내부 "type"을 재귀 호출한 후, 앞에 "*"를 붙여 새 문자열을 반환 (동적 할당됨)
- *   - FuncDecl: 내부 "type"을 재귀 호출
- * 만약 올바른 타입 정보를 찾지 못하면 "unknown"을 반환합니다.
- */
-char *extract_type(json_value node)
+// 레코드 하나를 보고서에 넘깁니다. 소유권도 넘어갑니다.
+void function_report_submit(function_report *report, function_record *rec)
 {
-    if (node.type != JSON_OBJECT || node.value == NULL)
-        return "unknown";
+    rec->sequence = report->sequence++;
+    if (!function_report_where(report, rec))
+    {
+        function_record_release(rec);
+        return;
+    }
+    report->matched++;
+    if (report->top == 0)
+    {
+        print_function(rec);
+        function_record_release(rec);
+        return;
+    }
+    function_heap_push(report, rec);
+}
 
-    char *nt = get_json_string(json_get(node, "_nodetype"));
-    if (!nt)
-        return "unknown";
+static int function_report_cmp_by;
+static int function_record_cmp(const void *a, const void *b)
+{
+    const function_record *x = (const function_record *)a, *y = (const function_record *)b;
+    if (x->metrics[function_report_cmp_by] != y->metrics[function_report_cmp_by])
+        return x->metrics[function_report_cmp_by] > y->metrics[function_report_cmp_by] ? -1 : 1;
+    return x->sequence < y->sequence ? -1 : (x->sequence > y->sequence);
+}
 
-    if (strcmp(nt, "IdentifierType") == 0)
+// top-K 결과를 메트릭 내림차순으로 출력하고 힙을 비웁니다
+void function_report_finish(function_report *report)
+{
+    if (report->top > 0)
     {
-        json_value names = json_get(node, "names");
-        if (names.type == JSON_ARRAY && names.value != NULL)
+        function_report_cmp_by = report->by;
+        qsort(report->heap, (size_t)report->heap_count, sizeof(function_record), function_record_cmp);
+        for (int64_t i = 0; i < report->heap_count; i++)
         {
-            json_array *names_arr = (json_array *)names.value;
-            if (names_arr->last_index >= 0)
-            {
-                char *res = get_json_string(names_arr->values[0]);
-                return res ? res : "unknown";
-            }
+            print_function(&report->heap[i]);
+            function_record_release(&report->heap[i]);
         }
-        return "unknown";
+        report->heap_count = 0;
+    }
+    free(report->heap);
+    report->heap = NULL;
+}
+
+/*
+ * sample_stats: --sample 표본 추출과 추정.
+ * 파일은 경로의 해시로, 함수는 (경로, 함수명)의 해시로 선택하므로 같은 입력이면 항상 같은 표본이 나옵니다.
+ * 선택되지 않은 파일은 열지 않고, 선택되지 않은 함수의 본문은 지연 파싱으로 건너뜁니다.
+ * 추정은 2단계 Poisson 표본의 Horvitz-Thompson 합계이며, 분산은
+ *   V = Σ_i (1-f)/f² ŷ_i² + Σ_i 1/f Σ_j (1-g)/g² y_ij²
+ * (f: 파일 비율, g: 함수 비율, ŷ_i: 파일 i의 추정 합계)로 구해 95% 신뢰구간을 냅니다.
+ * 평균 if 개수는 비율 추정량이며 선형화한 분산을 씁니다.
+ */
+#define SAMPLE_Z95 1.959963984540054
+
+typedef enum sample_var_enum
+{
+    SAMPLE_FUNCTIONS = 0,
+    SAMPLE_DEFINITIONS,
+    SAMPLE_IFS,
+    SAMPLE_VARS
+} sample_var;
+static const char *const sample_var_names[SAMPLE_VARS] = {"functions", "definitions", "if_total"};
+
+typedef struct sample_stats_s
+{
+    double file_rate;
+    double function_rate;
+    uint64_t file_hash; // 현재 파일 경로의 해시 (함수 선택의 씨앗)
+    int64_t files_seen;
+    int64_t files_sampled;
+    int64_t functions_seen;
+    int64_t functions_sampled;
+    double total[SAMPLE_VARS];                  // Σ_i ŷ_i / f
+    double psu[SAMPLE_VARS][SAMPLE_VARS];       // Σ_i (1-f)/f² ŷ_i[a] ŷ_i[b]
+    double ssu[SAMPLE_VARS][SAMPLE_VARS];       // Σ_i 1/f Σ_j (1-g)/g² y_ij[a] y_ij[b]
+    double file_sum[SAMPLE_VARS];               // 현재 파일의 표본 합계
+    double file_cross[SAMPLE_VARS][SAMPLE_VARS]; // 현재 파일의 Σ_j y_ij[a] y_ij[b]
+} sample_stats;
+
+static uint64_t sample_hash(uint64_t h, const char *str)
+{
+    for (; *str; str++)
+        h = (h ^ (unsigned char)*str) * 1099511628211ULL;
+    // 하위 비트가 고르게 섞이도록 마무리 (splitmix64)
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+static bool sample_pick(uint64_t h, double rate)
+{
+    return (double)(h >> 11) * (1.0 / 9007199254740992.0) < rate;
+}
+
+// "RATE" 또는 "RATE,FUNCTION_RATE"를 해석합니다. 함수 비율을 생략하면 single_file일 때 RATE, 아니면 1입니다.
+bool sample_stats_parse(sample_stats *sample, const char *arg, bool single_file)
+{
+    char *end;
+    sample->file_rate = strtod(arg, &end);
+    sample->function_rate = 1.0;
+    if (*end == ',')
+    {
+        const char *next = end + 1;
+        sample->function_rate = strtod(next, &end);
+        if (end == next)
+            return false;
     }
-    else if (strcmp(nt, "TypeDecl") == 0 || strcmp(nt, "Typename") == 0)
+    else if (single_file)
     {
-        return extract_type(json_get(node, "type"));
+        sample->function_rate = sample->file_rate;
+        sample->file_rate = 1.0;
     }
-    else if (strcmp(nt, "PtrDecl") == 0)
+    return end != arg && *end == '\0' && sample->file_rate > 0.0 && sample->file_rate <= 1.0 &&
+           sample->function_rate > 0.0 && sample->function_rate <= 1.0;
+}
+
+// 파일을 표본에 넣을지 정합니다. 넣는다면 파일 단위 누적을 시작합니다.
+bool sample_begin_file(sample_stats *sample, const char *path)
+{
+    sample->files_seen++;
+    sample->file_hash = sample_hash(1469598103934665603ULL, path);
+    if (!sample_pick(sample->file_hash, sample->file_rate))
+        return false;
+    sample->files_sampled++;
+    memset(sample->file_sum, 0x00, sizeof(sample->file_sum));
+    memset(sample->file_cross, 0x00, sizeof(sample->file_cross));
+    return true;
+}
+
+// sample_begin_file()과 같은 결정을 상태를 바꾸지 않고 내립니다 (다른 스레드에서 파일을 미리 읽을 때)
+bool sample_wants_file(const sample_stats *sample, const char *path)
+{
+    return sample_pick(sample_hash(1469598103934665603ULL, path), sample->file_rate);
+}
+
+bool sample_pick_function(sample_stats *sample, const char *name)
+{
+    sample->functions_seen++;
+    return sample_pick(sample_hash(sample->file_hash, name), sample->function_rate);
+}
+
+void sample_add_function(sample_stats *sample, const function_record *rec)
+{
+    double y[SAMPLE_VARS] = {1.0, rec->is_definition ? 1.0 : 0.0, (double)rec->metrics[METRIC_IFS]};
+    sample->functions_sampled++;
+    for (int a = 0; a < SAMPLE_VARS; a++)
     {
-        char *inner = extract_type(json_get(node, "type"));
-        size_t len = strlen(inner);
-        char *result = malloc(len + 2); // 1 for '*' + 1 for '\0'
-        if (result)
-            sprintf(result, "*%s", inner);
-        return result;
+        sample->file_sum[a] += y[a];
+        for (int b = 0; b < SAMPLE_VARS; b++)
+            sample->file_cross[a][b] += y[a] * y[b];
     }
-    else if (strcmp(nt, "FuncDecl") == 0)
+}
+
+void sample_end_file(sample_stats *sample)
+{
+    double f = sample->file_rate, g = sample->function_rate;
+    double est[SAMPLE_VARS];
+    for (int a = 0; a < SAMPLE_VARS; a++)
     {
-        return extract_type(json_get(node, "type"));
+        est[a] = sample->file_sum[a] / g;
+        sample->total[a] += est[a] / f;
     }
-    else
+    for (int a = 0; a < SAMPLE_VARS; a++)
     {
-        return "unknown";
+        for (int b = 0; b < SAMPLE_VARS; b++)
+        {
+            sample->psu[a][b] += (1.0 - f) / (f * f) * est[a] * est[b];
+            sample->ssu[a][b] += (1.0 - g) / (f * g * g) * sample->file_cross[a][b];
+        }
     }
 }
 
-// --- 함수의 리턴타입 추출 (기존 extract_return_type()를 extract_type()으로 변경) ---
-char *extract_return_type(json_value decl_type)
+static double sample_variance(const sample_stats *sample, int a, int b)
 {
-    return extract_type(decl_type);
+    return sample->psu[a][b] + sample->ssu[a][b];
 }
 
-// --- 함수의 파라미터 정보를 추출합니다 ---
-// 함수 선언의 "type" 필드 내 "args" 항목의 "params" 배열을 읽음.
-// 각 파라미터는 { "_nodetype": "Typename", type: { ... } , name: ... } 형태입니다.
-void extract_params(json_value args_val, char *buf, size_t bufsize)
+static void sample_fprint_estimate(FILE *fp, const char *name, double value, double variance)
 {
-    buf[0] = '\0';
-    if (args_val.type != JSON_OBJECT)
+    double half = SAMPLE_Z95 * sqrt(variance > 0.0 ? variance : 0.0);
+    fprintf(fp, "\"%s\": {\"estimate\": %.6g, \"ci95\": [%.6g, %.6g]}", name, value,
+            value - half > 0.0 ? value - half : 0.0, value + half);
+}
+
+// 추정량과 95% 신뢰구간을 JSON 객체로 출력합니다
+void sample_stats_fprint(FILE *fp, const sample_stats *sample)
+{
+    fprintf(fp, "{\"file_rate\": %g, \"function_rate\": %g, ", sample->file_rate, sample->function_rate);
+    fprintf(fp, "\"files_seen\": %lld, \"files_sampled\": %lld, ", (long long)sample->files_seen,
+            (long long)sample->files_sampled);
+    fprintf(fp, "\"functions_seen\": %lld, \"functions_sampled\": %lld,\n", (long long)sample->functions_seen,
+            (long long)sample->functions_sampled);
+    fprintf(fp, "        \"estimates\": {");
+    for (int a = 0; a < SAMPLE_VARS; a++)
     {
-        strncat(buf, "None", bufsize - strlen(buf) - 1);
-        return;
+        fprintf(fp, a ? ",\n                      " : "");
+        sample_fprint_estimate(fp, sample_var_names[a], sample->total[a], sample_variance(sample, a, a));
+    }
+    // 정의당 평균 if 개수 R = Y_if / Y_def, Var(R) ≈ (V_if - 2R C + R² V_def) / Y_def²
+    double defs = sample->total[SAMPLE_DEFINITIONS];
+    if (defs > 0.0)
+    {
+        double r = sample->total[SAMPLE_IFS] / defs;
+        double v = sample_variance(sample, SAMPLE_IFS, SAMPLE_IFS) -
+                   2.0 * r * sample_variance(sample, SAMPLE_IFS, SAMPLE_DEFINITIONS) +
+                   r * r * sample_variance(sample, SAMPLE_DEFINITIONS, SAMPLE_DEFINITIONS);
+        fprintf(fp, ",\n                      ");
+        sample_fprint_estimate(fp, "if_mean", r, v / (defs * defs));
     }
-    json_value params_val = json_get(args_val, "params");
-    if (params_val.type != JSON_ARRAY)
+    fprintf(fp, "}}");
+}
+
+/*
+ * corpus_stats: --stats로 배치 실행 전체를 하나의 JSON 요약으로 냅니다.
+ * 함수 단위 집계(개수, if/파라미터 히스토그램, 리턴/파라미터 타입 빈도)는 레코드마다 더하고,
+ * nodetype 빈도는 분석한 함수 노드마다 ast_collect_metrics()의 스레드별 stat_counter를 join 시점에 합칩니다.
+ * (문서 전체가 아니라 분석한 함수만 세므로 --index 등 다른 옵션과 관계없이 같은 값이 나옵니다)
+ * 여러 집계를 합칠 때는 corpus_stats_merge()를 씁니다. 어느 경우에도 전역 잠금은 없습니다.
+ */
+#define STATS_IF_BUCKETS 64    // if 개수 히스토그램: 0, 1, 2-3, 4-7, ... (2의 거듭제곱 구간)
+#define STATS_PARAM_BUCKETS 17 // 파라미터 개수 히스토그램: 0 ~ 15, 16+
+#define STATS_TOP_TYPES 10     // 타입 빈도는 상위 몇 개만 출력
+
+typedef struct corpus_stats_s
+{
+    int64_t files;
+    int64_t definitions;
+    int64_t declarations;
+    int64_t if_total;
+    int64_t if_max;
+    int64_t if_histogram[STATS_IF_BUCKETS];
+    int64_t param_total;
+    int64_t param_histogram[STATS_PARAM_BUCKETS];
+    stat_counter return_types;
+    stat_counter param_types;
+    stat_counter nodetypes;
+} corpus_stats;
+
+static int stats_if_bucket(int64_t n)
+{
+    int bucket = 0;
+    while (n > 0 && bucket < STATS_IF_BUCKETS - 1)
     {
-        strncat(buf, "None", bufsize - strlen(buf) - 1);
+        n >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// 분석한 함수 하나를 집계에 더합니다 (레코드는 그대로 둠)
+void corpus_stats_add(corpus_stats *stats, const function_record *rec)
+{
+    stat_counter_add(&stats->return_types, rec->return_type, 1);
+    int64_t params = rec->metrics[METRIC_PARAMS];
+    stats->param_total += params;
+    stats->param_histogram[params < STATS_PARAM_BUCKETS - 1 ? params : STATS_PARAM_BUCKETS - 1]++;
+
+    for (int64_t i = 0; i < params; i++)
+        stat_counter_add(&stats->param_types, rec->params[i].type, 1);
+
+    if (!rec->is_definition)
+    {
+        stats->declarations++;
         return;
     }
-    json_array *params_arr = (json_array *)params_val.value;
-    for (int i = 0; i <= params_arr->last_index; i++)
+    int64_t ifs = rec->metrics[METRIC_IFS];
+    stats->definitions++;
+    stats->if_total += ifs;
+    if (ifs > stats->if_max)
+        stats->if_max = ifs;
+    stats->if_histogram[stats_if_bucket(ifs)]++;
+}
+
+void corpus_stats_merge(corpus_stats *dst, const corpus_stats *src)
+{
+    dst->files += src->files;
+    dst->definitions += src->definitions;
+    dst->declarations += src->declarations;
+    dst->if_total += src->if_total;
+    if (src->if_max > dst->if_max)
+        dst->if_max = src->if_max;
+    for (int i = 0; i < STATS_IF_BUCKETS; i++)
+        dst->if_histogram[i] += src->if_histogram[i];
+    dst->param_total += src->param_total;
+    for (int i = 0; i < STATS_PARAM_BUCKETS; i++)
+        dst->param_histogram[i] += src->param_histogram[i];
+    stat_counter_merge(&dst->return_types, &src->return_types);
+    stat_counter_merge(&dst->param_types, &src->param_types);
+    stat_counter_merge(&dst->nodetypes, &src->nodetypes);
+}
+
+void corpus_stats_free(corpus_stats *stats)
+{
+    stat_counter_free(&stats->return_types);
+    stat_counter_free(&stats->param_types);
+    stat_counter_free(&stats->nodetypes);
+}
+
+static void stats_fprint_string(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (; *str; str++)
+    {
+        if (*str == '"' || *str == '\\')
+            fputc('\\', fp);
+        if ((unsigned char)*str < 0x20)
+            fprintf(fp, "\\u%04x", (unsigned char)*str);
+        else
+            fputc(*str, fp);
+    }
+    fputc('"', fp);
+}
+
+static const stat_counter *stats_sort_counter;
+static int stats_slot_cmp(const void *a, const void *b)
+{
+    size_t x = *(const size_t *)a, y = *(const size_t *)b;
+    int64_t cx = stats_sort_counter->counts[x], cy = stats_sort_counter->counts[y];
+    if (cx != cy)
+        return cx > cy ? -1 : 1;
+    return strcmp(stats_sort_counter->keys[x], stats_sort_counter->keys[y]);
+}
+
+// 빈도 내림차순으로 limit개까지 {"키": 빈도, ...} 형태로 출력합니다 (limit < 0이면 전부)
+static void stats_fprint_counter(FILE *fp, const stat_counter *c, int64_t limit)
+{
+    size_t *order = (size_t *)malloc(sizeof(size_t) * (c->count ? c->count : 1));
+    size_t n = 0;
+    for (size_t i = 0; order != NULL && i < c->capacity; i++)
+        if (c->keys[i] != NULL)
+            order[n++] = i;
+    stats_sort_counter = c;
+    if (n > 0)
+        qsort(order, n, sizeof(size_t), stats_slot_cmp);
+    if (limit >= 0 && (size_t)limit < n)
+        n = (size_t)limit;
+    fprintf(fp, "{");
+    for (size_t i = 0; i < n; i++)
     {
-        json_value param = params_arr->values[i];
-        // 파라미터 이름 추출
-        json_value name_val = json_get(param, "name");
-        char *pname = get_json_string(name_val);
-        if (!pname)
-            pname = "anonymous";
+        fprintf(fp, i ? ", " : "");
+        stats_fprint_string(fp, c->keys[order[i]]);
+        fprintf(fp, ": %lld", (long long)c->counts[order[i]]);
+    }
+    fprintf(fp, "}");
+    free(order);
+}
 
-        // 파라미터 타입 추출: 파라미터 노드의 "type" 필드를 extract_type()으로 처리
-        char *ptype = extract_type(json_get(param, "type"));
-        if (!ptype)
-            ptype = "unknown";
+void corpus_stats_fprint(FILE *fp, const corpus_stats *stats, const sample_stats *sample)
+{
+    fprintf(fp, "{\n");
+    fprintf(fp, "    \"files\": %lld,\n", (long long)stats->files);
+    fprintf(fp, "    \"functions\": %lld,\n", (long long)(stats->definitions + stats->declarations));
+    fprintf(fp, "    \"definitions\": %lld,\n", (long long)stats->definitions);
+    fprintf(fp, "    \"declarations\": %lld,\n", (long long)stats->declarations);
 
-        char param_info[128];
-        snprintf(param_info, sizeof(param_info), "    %s %s\n", ptype, pname);
-        strncat(buf, param_info, bufsize - strlen(buf) - 1);
+    fprintf(fp, "    \"if_count\": {\"total\": %lld, \"max\": %lld, \"histogram\": {",
+            (long long)stats->if_total, (long long)stats->if_max);
+    int last = 0;
+    for (int i = 0; i < STATS_IF_BUCKETS; i++)
+        if (stats->if_histogram[i] != 0)
+            last = i;
+    for (int i = 0; i <= last; i++)
+    {
+        if (i <= 1)
+            fprintf(fp, "%s\"%d\": %lld", i ? ", " : "", i, (long long)stats->if_histogram[i]);
+        else
+            fprintf(fp, ", \"%lld-%lld\": %lld", 1LL << (i - 1), (1LL << i) - 1, (long long)stats->if_histogram[i]);
+    }
+    fprintf(fp, "}},\n");
 
-        // 만약 ptype가 PtrDecl 처리로 동적할당되었다면 free() (문자열의 첫 문자가 '*'이면)
-        if (ptype[0] == '*')
-            free(ptype);
+    fprintf(fp, "    \"param_count\": {\"total\": %lld, \"histogram\": {", (long long)stats->param_total);
+    last = 0;
+    for (int i = 0; i < STATS_PARAM_BUCKETS; i++)
+        if (stats->param_histogram[i] != 0)
+            last = i;
+    for (int i = 0; i <= last; i++)
+        fprintf(fp, "%s\"%d%s\": %lld", i ? ", " : "", i, i == STATS_PARAM_BUCKETS - 1 ? "+" : "",
+                (long long)stats->param_histogram[i]);
+    fprintf(fp, "}},\n");
+
+    fprintf(fp, "    \"return_types\": ");
+    stats_fprint_counter(fp, &stats->return_types, STATS_TOP_TYPES);
+    fprintf(fp, ",\n    \"param_types\": ");
+    stats_fprint_counter(fp, &stats->param_types, STATS_TOP_TYPES);
+    fprintf(fp, ",\n    \"nodetypes\": ");
+    stats_fprint_counter(fp, &stats->nodetypes, -1);
+    if (sample != NULL)
+    {
+        // 위의 값은 표본에서 센 그대로이고, 모집단 추정은 여기에 있습니다
+        fprintf(fp, ",\n    \"sample\": ");
+        sample_stats_fprint(fp, sample);
     }
+    fprintf(fp, "\n}\n");
 }
 
-// --- 함수 노드를 분석하여 함수명, 리턴타입, 파라미터 정보, if 조건문 개수를 출력합니다 ---
-// 함수 노드는 두 가지 유형: 함수 정의(FuncDef)와 함수 선언(Decl) 중 내부 type._nodetype가 FuncDecl인 경우.
-void process_function(json_value func_node)
+/*
+ * function_filter: --function 패턴들을 미리 컴파일해 둔 이름 필터.
+ * 정확한 이름은 해시 집합에, 와일드카드(*?[)가 있는 패턴은 glob으로, "re:"로 시작하는 패턴은
+ * POSIX 확장 정규식(regcomp)으로 한 번만 컴파일합니다. 하나라도 맞으면 통과입니다.
+ * glob은 첫 와일드카드 앞의 고정 접두사를 따로 기억하여 대부분의 이름을 fnmatch() 없이 걸러냅니다.
+ */
+typedef struct function_glob_s
 {
-    json_value decl;
-    char *nodetype = get_json_string(json_get(func_node, "_nodetype"));
-    if (nodetype && strcmp(nodetype, "FuncDef") == 0)
-        decl = json_get(func_node, "decl"); // 함수 정의의 경우
-    else
-        decl = func_node; // 함수 선언의 경우
+    char *pattern;
+    size_t prefix_len; // 와일드카드 앞 고정 접두사 길이
+} function_glob;
 
-    // 함수 이름 추출
-    json_value name_val = json_get(decl, "name");
-    char *func_name = get_json_string(name_val);
-    if (!func_name)
-        func_name = "unknown";
+typedef struct function_filter_s
+{
+    char **names; // 정확한 이름의 open addressing 해시 집합 (NULL = 빈 칸)
+    size_t name_count;
+    size_t name_capacity;
+    function_glob *globs;
+    size_t glob_count;
+    regex_t *regexes;
+    size_t regex_count;
+} function_filter;
 
-    // 함수 리턴 타입 추출 (decl.type 내부)
-    json_value type_val = json_get(decl, "type");
-    char *return_type = extract_return_type(type_val);
+static uint64_t function_name_hash(const char *name)
+{
+    uint64_t h = 1469598103934665603ULL; // FNV-1a
+    for (; *name; name++)
+        h = (h ^ (unsigned char)*name) * 1099511628211ULL;
+    return h;
+}
 
-    // 함수 파라미터 추출 (decl.type.args)
-    json_value args_val = json_get(type_val, "args");
-    char params_info[MAX_BUF];
-    extract_params(args_val, params_info, sizeof(params_info));
+static bool function_filter_add_name(function_filter *filter, const char *name)
+{
+    if ((filter->name_count + 1) * 2 > filter->name_capacity)
+    {
+        size_t capacity = filter->name_capacity ? filter->name_capacity * 2 : 64;
+        char **names = (char **)calloc(capacity, sizeof(char *));
+        if (names == NULL)
+            return false;
+        for (size_t i = 0; i < filter->name_capacity; i++)
+        {
+            if (filter->names[i] == NULL)
+                continue;
+            size_t j = function_name_hash(filter->names[i]) & (capacity - 1);
+            while (names[j] != NULL)
+                j = (j + 1) & (capacity - 1);
+            names[j] = filter->names[i];
+        }
+        free(filter->names);
+        filter->names = names;
+        filter->name_capacity = capacity;
+    }
+    size_t j = function_name_hash(name) & (filter->name_capacity - 1);
+    for (; filter->names[j] != NULL; j = (j + 1) & (filter->name_capacity - 1))
+        if (strcmp(filter->names[j], name) == 0)
+            return true;
+    filter->names[j] = strdup(name);
+    if (filter->names[j] == NULL)
+        return false;
+    filter->name_count++;
+    return true;
+}
 
-    // 함수 본문 내 if 조건문 개수 (함수 정의인 경우)
-    int if_count = 0;
-    if (nodetype && strcmp(nodetype, "FuncDef") == 0)
+// 패턴 하나를 종류에 맞게 컴파일하여 추가합니다
+static bool function_filter_add_pattern(function_filter *filter, const char *pattern)
+{
+    if (strncmp(pattern, "re:", 3) == 0)
     {
-        json_value body_val = json_get(func_node, "body");
-        if_count = count_if_nodes(body_val);
+        regex_t *regexes = (regex_t *)realloc(filter->regexes, sizeof(regex_t) * (filter->regex_count + 1));
+        if (regexes == NULL)
+            return false;
+        filter->regexes = regexes;
+        int err = regcomp(&regexes[filter->regex_count], pattern + 3, REG_EXTENDED | REG_NOSUB);
+        if (err != 0)
+        {
+            char msg[256];
+            regerror(err, &regexes[filter->regex_count], msg, sizeof(msg));
+            fprintf(stderr, "잘못된 정규식입니다: %s (%s)\n", pattern + 3, msg);
+            return false;
+        }
+        filter->regex_count++;
+        return true;
     }
+    size_t prefix_len = strcspn(pattern, "*?[\\");
+    if (pattern[prefix_len] == '\0')
+        return function_filter_add_name(filter, pattern);
+    function_glob *globs = (function_glob *)realloc(filter->globs, sizeof(function_glob) * (filter->glob_count + 1));
+    if (globs == NULL)
+        return false;
+    filter->globs = globs;
+    globs[filter->glob_count].pattern = strdup(pattern);
+    globs[filter->glob_count].prefix_len = prefix_len;
+    if (globs[filter->glob_count].pattern == NULL)
+        return false;
+    filter->glob_count++;
+    return true;
+}
 
-    printf("Function: %s\n", func_name);
-    printf("Return Type: %s\n", return_type);
-    printf("Parameters:\n%s", params_info);
-    if (nodetype && strcmp(nodetype, "FuncDef") == 0)
-        printf("if-condition count: %d\n", if_count);
-    printf("\n");
+// --function 인자 하나를 추가합니다. 쉼표로 여러 패턴을 구분하고, "@경로"는 한 줄에 패턴 하나인 파일입니다.
+bool function_filter_add(function_filter *filter, const char *arg)
+{
+    if (arg[0] == '@')
+    {
+        FILE *fp = fopen(arg + 1, "r");
+        if (fp == NULL)
+        {
+            fprintf(stderr, "%s 파일을 열 수 없습니다.\n", arg + 1);
+            return false;
+        }
+        char line[MAX_BUF];
+        bool ok = true;
+        while (ok && fgets(line, sizeof(line), fp) != NULL)
+        {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] != '\0')
+                ok = function_filter_add_pattern(filter, line);
+        }
+        fclose(fp);
+        return ok;
+    }
+    char pattern[MAX_BUF];
+    while (*arg)
+    {
+        size_t len = strcspn(arg, ",");
+        if (len >= sizeof(pattern))
+        {
+            fprintf(stderr, "패턴이 너무 깁니다: %s\n", arg);
+            return false;
+        }
+        memcpy(pattern, arg, len);
+        pattern[len] = '\0';
+        if (len > 0 && !function_filter_add_pattern(filter, pattern))
+            return false;
+        arg += len;
+        if (*arg == ',')
+            arg++;
+    }
+    return true;
+}
 
-    // 만약 return_type가 PtrDecl 처리로 동적할당되었다면 free()
-    if (return_type[0] == '*')
-        free(return_type);
+bool function_filter_match(const function_filter *filter, const char *name)
+{
+    if (filter->name_count > 0)
+    {
+        size_t j = function_name_hash(name) & (filter->name_capacity - 1);
+        for (; filter->names[j] != NULL; j = (j + 1) & (filter->name_capacity - 1))
+            if (strcmp(filter->names[j], name) == 0)
+                return true;
+    }
+    for (size_t i = 0; i < filter->glob_count; i++)
+    {
+        const function_glob *g = &filter->globs[i];
+        if (strncmp(name, g->pattern, g->prefix_len) == 0 && fnmatch(g->pattern, name, 0) == 0)
+            return true;
+    }
+    for (size_t i = 0; i < filter->regex_count; i++)
+        if (regexec(&filter->regexes[i], name, 0, NULL, 0) == 0)
+            return true;
+    return false;
 }
 
-int main(void)
+bool function_filter_empty(const function_filter *filter)
 {
-    // ast.json 파일을 fopen()을 사용하여 읽어 들임
-    FILE *fp = fopen("ast.json", "r");
+    return filter->name_count == 0 && filter->glob_count == 0 && filter->regex_count == 0;
+}
+
+void function_filter_free(function_filter *filter)
+{
+    for (size_t i = 0; i < filter->name_capacity; i++)
+        free(filter->names[i]);
+    free(filter->names);
+    for (size_t i = 0; i < filter->glob_count; i++)
+        free(filter->globs[i].pattern);
+    free(filter->globs);
+    for (size_t i = 0; i < filter->regex_count; i++)
+        regfree(&filter->regexes[i]);
+    free(filter->regexes);
+    memset(filter, 0x00, sizeof(function_filter));
+}
+
+// --- 지연 파싱된(JSON_RAW) 함수 본문을 그 자리에서 객체로 만듭니다 ---
+static bool materialize_body(json_parser *parser, json_value func_node)
+{
+    json_object *obj = (json_object *)func_node.value;
+    for (json_index k = 0; k <= obj->last_index; k++)
+    {
+        if (obj->values[k].type != JSON_RAW || strcmp(obj->keys[k], "body") != 0)
+            continue;
+        obj->values[k] = json_parser_materialize(parser, obj->values[k]);
+        return obj->values[k].type != JSON_UNDEFINED;
+    }
+    return true;
+}
+
+// --- 파싱한 문서를 balanced-parentheses 인코딩으로 저장합니다 ---
+int write_bp_archive(json_value ast, const char *path)
+{
+    json_bp bp;
+    if (!json_bp_build(&bp, ast))
+        return 1;
+    FILE *fp = fopen(path, "wb");
     if (fp == NULL)
     {
-        fprintf(stderr, "ast.json 파일을 열 수 없습니다.\n");
+        fprintf(stderr, "%s 파일을 열 수 없습니다.\n", path);
+        json_bp_free(&bp);
         return 1;
     }
+    bool ok = json_bp_write(&bp, fp);
+    fclose(fp);
+    json_bp_free(&bp);
+    return ok ? 0 : 1;
+}
 
-    fseek(fp, 0, SEEK_END);
-    long filesize = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
+// --- 문서를 C 소스로 다시 씁니다 ---
+// 버퍼 하나에 전부 만든 뒤 fwrite 한 번으로 내보냅니다
+int write_c_source(json_value ast, const char *path)
+{
+    ast_emit_buffer out;
+    ast_emit_init(&out);
+    if (!ast_emit_c(&out, ast))
+    {
+        if (out.unsupported != NULL)
+            fprintf(stderr, "%s 노드는 C 소스로 쓸 수 없습니다.\n", out.unsupported);
+        else
+            fprintf(stderr, "메모리 할당 에러\n");
+        ast_emit_free(&out);
+        return 1;
+    }
+    bool to_stdout = strcmp(path, "-") == 0;
+    FILE *fp = to_stdout ? stdout : fopen(path, "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "%s 파일을 열 수 없습니다.\n", path);
+        ast_emit_free(&out);
+        return 1;
+    }
+    bool ok = fwrite(out.data, 1, out.size, fp) == out.size;
+    if (!to_stdout)
+        ok = fclose(fp) == 0 && ok;
+    ast_emit_free(&out);
+    return ok ? 0 : 1;
+}
+
+// 전처리된 C 소스로 다룰 입력인지 (확장자로 판단. 나머지는 AST JSON)
+static bool is_c_source_path(const char *path)
+{
+    const char *ext = strrchr(path, '.');
+    return ext != NULL && (strcmp(ext, ".c") == 0 || strcmp(ext, ".i") == 0 || strcmp(ext, ".h") == 0);
+}
+
+// --- 파일 하나를 읽어 파싱합니다 ---
+// parser와 입력 버퍼는 호출자가 소유하며 파일 사이에서 재사용되므로,
+// 여러 파일을 연달아 읽을 때 정상 상태에서는 malloc이 일어나지 않습니다.
+// 함수 본문을 원문 구간으로 남겼으면 *lazy가 true가 됩니다. 실패하면 JSON_UNDEFINED
+json_value load_file(const analyzer_options *opts, json_parser *parser, const char *path, char **buffer, size_t *buffer_size, bool *lazy)
+{
+    json_value failed = {JSON_UNDEFINED, NULL};
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "%s 파일을 열 수 없습니다.\n", path);
+        return failed;
+    }
 
-    char *buffer = (char *)malloc(filesize + 1);
-    if (buffer == NULL)
+    // 2GB 이상의 파일에서도 잘리지 않도록 off_t 기반의 fseeko/ftello 사용
+    fseeko(fp, 0, SEEK_END);
+    off_t filesize = ftello(fp);
+    fseeko(fp, 0, SEEK_SET);
+    if (filesize < 0 || (uint64_t)filesize >= SIZE_MAX)
     {
-        fprintf(stderr, "메모리 할당 에러\n");
+        fprintf(stderr, "%s 파일의 크기를 확인할 수 없습니다.\n", path);
         fclose(fp);
-        return 1;
+        return failed;
+    }
+
+    // 입력 버퍼는 더 큰 파일을 만났을 때만 늘립니다
+    if (*buffer == NULL || *buffer_size < (size_t)filesize + 1)
+    {
+        char *grown = (char *)realloc(*buffer, (size_t)filesize + 1);
+        if (grown == NULL)
+        {
+            fprintf(stderr, "메모리 할당 에러\n");
+            fclose(fp);
+            return failed;
+        }
+        *buffer = grown;
+        *buffer_size = (size_t)filesize + 1;
     }
 
-    size_t read_size = fread(buffer, 1, filesize, fp);
-    buffer[read_size] = '\0';
+    size_t read_size = fread(*buffer, 1, (size_t)filesize, fp);
+    (*buffer)[read_size] = '\0';
     fclose(fp);
 
-    // json_create() 함수를 이용하여 문자열을 JSON 객체로 변환
-    json_value ast = json_create(buffer);
-    free(buffer);
+    // 재사용 가능한 parser 컨텍스트로 문자열을 JSON 객체로 변환 (이전 문서의 메모리는 재활용됨)
+    // 이름 필터나 표본 추출이 있으면 함수 본문은 필요할 때만 만들도록 원문 구간으로 남겨 둡니다.
+    // (색인, BP 보관, C 생성은 문서 전체가 필요하므로 그때는 지연 파싱을 쓰지 않습니다)
+    // C 소스는 JSON 텍스트가 없으므로 원문 구간을 남길 수 없고, 곧바로 AST를 만듭니다.
+    bool c_source = is_c_source_path(path);
+    *lazy = (opts->filter != NULL || opts->sample != NULL) && !opts->use_index && opts->bp_path == NULL &&
+            opts->emit_path == NULL && !c_source;
+    parser->lazy_key = *lazy ? "body" : NULL;
+    json_value ast = c_source ? ast_cparse(parser, *buffer, path) : json_parser_parse(parser, *buffer);
+    parser->lazy_key = NULL;
 
     if (ast.type == JSON_UNDEFINED)
-    {
-        fprintf(stderr, "ast.json 파일을 파싱하지 못했습니다.\n");
+        fprintf(stderr, "%s 파일을 파싱하지 못했습니다.\n", path);
+    return ast;
+}
+
+// --- 파싱한 문서에서 함수 정보를 출력합니다 ---
+// 원문 구간으로 남긴(lazy) 함수 본문은 분석할 때 parser의 현재 문서에 만듭니다.
+int analyze_ast(const analyzer_options *opts, function_report *report, json_parser *parser, const char *path, json_value ast, bool lazy)
+{
+    if (opts->bp_path != NULL && write_bp_archive(ast, opts->bp_path) != 0)
+        return 1;
+    if (opts->emit_path != NULL && write_c_source(ast, opts->emit_path) != 0)
         return 1;
-    }
 
     // AST 최상위 노드 배열은 "ext" 필드에 위치
     json_value ext = json_get(ast, "ext");
     if (ext.type != JSON_ARRAY)
     {
-        fprintf(stderr, "ast.json의 ext 필드가 배열 형식이 아닙니다.\n");
+        fprintf(stderr, "%s의 ext 필드가 배열 형식이 아닙니다.\n", path);
         return 1;
     }
 
-    int total_functions = 0;
+    // 같은 문서에 여러 질의를 할 때는 색인을 한 번 만들어 두는 편이 순회를 반복하는 것보다 빠릅니다
+    ast_index index_storage;
+    ast_index *index = NULL;
+    if (opts->use_index)
+    {
+        if (!ast_index_build(&index_storage, ast))
+        {
+            fprintf(stderr, "색인을 만드는 중 메모리 할당 에러\n");
+            return 1;
+        }
+        index = &index_storage;
+    }
+
+    int64_t total_functions = 0;
+    function_record rec;
     json_array *ext_arr = (json_array *)ext.value;
-    for (int i = 0; i <= ext_arr->last_index; i++)
+    for (json_index i = 0; i <= ext_arr->last_index; i++)
     {
+        // 함수 정의(FuncDef)와 함수 선언(Decl + FuncDecl)만 분석합니다
         json_value node = ext_arr->values[i];
-        json_value nodetype_val = json_get(node, "_nodetype");
-        if (nodetype_val.type != JSON_STRING)
+        bool is_definition;
+        if (!ast_is_function_node(node, &is_definition))
+            continue;
+        // 이름 필터와 표본 추출은 본문을 만들기 전에 적용합니다
+        if (opts->filter != NULL && !function_filter_match(opts->filter, function_node_name(node, is_definition)))
             continue;
-        char *nodetype = get_json_string(nodetype_val);
-        // 함수 정의: FuncDef
-        if (strcmp(nodetype, "FuncDef") == 0)
+        if (opts->sample != NULL && !sample_pick_function(opts->sample, function_node_name(node, is_definition)))
+            continue;
+        if (is_definition && lazy && !materialize_body(parser, node))
+            continue;
+        total_functions++;
+        if (!analyze_function(node, index, opts->jobs, &rec))
         {
-            total_functions++;
-            process_function(node);
+            fprintf(stderr, "메모리 할당 에러\n");
+            continue;
         }
-        // 함수 선언: Decl이고 내부 type._nodetype가 FuncDecl인 경우
-        else if (strcmp(nodetype, "Decl") == 0)
+        if (opts->stats != NULL)
         {
-            json_value type_val = json_get(node, "type");
-            json_value funcdecl_val = json_get(type_val, "_nodetype");
-            if (funcdecl_val.type == JSON_STRING &&
-                strcmp(get_json_string(funcdecl_val), "FuncDecl") == 0)
+            corpus_stats_add(opts->stats, &rec);
+            ast_collect_metrics(node, opts->jobs, &opts->stats->nodetypes);
+        }
+        if (opts->sample != NULL)
+            sample_add_function(opts->sample, &rec);
+        function_report_submit(report, &rec);
+    }
+    printf("Total number of functions: %lld\n", (long long)total_functions);
+    if (opts->stats != NULL)
+        opts->stats->files++;
+    if (index != NULL)
+        ast_index_free(index);
+    return 0;
+}
+
+// --- 파일 하나를 읽어 파싱한 뒤 함수 정보를 출력합니다 ---
+int analyze_file(const analyzer_options *opts, function_report *report, json_parser *parser, const char *path, char **buffer, size_t *buffer_size)
+{
+    bool lazy = false;
+    json_value ast = load_file(opts, parser, path, buffer, buffer_size, &lazy);
+    if (ast.type == JSON_UNDEFINED)
+        return 1;
+    return analyze_ast(opts, report, parser, path, ast, lazy);
+}
+
+/*
+ * file_pipeline: --jobs가 2 이상이고 입력 파일이 여럿이면 로더 스레드가 다음 파일을 읽고 파싱하는 동안
+ * 메인 스레드는 앞 파일의 문서를 분석합니다.
+ * 로더는 문서를 json_parser_detach()로 떼어 넘기고, 메인 스레드가 분석을 마치면 json_document_free()가
+ * 청크를 로더의 json_arena_pool로 돌려주므로 정상 상태에서는 두 스레드 모두 청크를 malloc하지 않습니다.
+ * 출력 순서는 파일 순서 그대로입니다.
+ */
+#define PIPELINE_DEPTH 2 // 분석을 기다릴 수 있는 파싱된 문서 수
+
+typedef struct loaded_file_s
+{
+    int file;               // files[]의 색인
+    json_document document; // root가 JSON_UNDEFINED면 읽기나 파싱에 실패한 것
+    bool lazy;              // 함수 본문을 원문 구간으로 남겼는지
+    char *buffer;           // 원문 (지연 숫자와 JSON_RAW 구간이 가리키므로 분석이 끝날 때까지 유지)
+    size_t buffer_size;
+} loaded_file;
+
+typedef struct file_pipeline_s
+{
+    const analyzer_options *opts;
+    const char **files;
+    int file_count;
+    json_parser parser;   // 로더 스레드 전용
+    json_arena_pool pool; // 로더 스레드의 청크 풀
+    loaded_file slots[PIPELINE_DEPTH];
+    int64_t produced;     // 채운 슬롯 수 (누적, 로더만 늘림)
+    int64_t consumed;     // 분석을 마친 슬롯 수 (누적, 메인 스레드만 늘림)
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    pthread_t thread;
+} file_pipeline;
+
+static void *file_pipeline_run(void *arg)
+{
+    file_pipeline *pl = (file_pipeline *)arg;
+    for (int i = 0; i < pl->file_count; i++)
+    {
+        // 메인 스레드의 sample_begin_file()과 같은 결정이므로 건너뛴 파일은 양쪽에서 빠집니다
+        if (pl->opts->sample != NULL && !sample_wants_file(pl->opts->sample, pl->files[i]))
+            continue;
+        pthread_mutex_lock(&pl->lock);
+        while (pl->produced - pl->consumed == PIPELINE_DEPTH)
+            pthread_cond_wait(&pl->changed, &pl->lock);
+        pthread_mutex_unlock(&pl->lock);
+
+        loaded_file *slot = &pl->slots[pl->produced % PIPELINE_DEPTH];
+        slot->file = i;
+        json_value ast = load_file(pl->opts, &pl->parser, pl->files[i], &slot->buffer, &slot->buffer_size, &slot->lazy);
+        slot->document = json_parser_detach(&pl->parser, ast);
+
+        pthread_mutex_lock(&pl->lock);
+        pl->produced++;
+        pthread_cond_broadcast(&pl->changed);
+        pthread_mutex_unlock(&pl->lock);
+    }
+    // 풀은 이 스레드의 것이므로 넘긴 문서가 모두 돌아온 뒤 여기서 닫습니다
+    pthread_mutex_lock(&pl->lock);
+    while (pl->consumed < pl->produced)
+        pthread_cond_wait(&pl->changed, &pl->lock);
+    pthread_mutex_unlock(&pl->lock);
+    json_parser_free(&pl->parser);
+    json_arena_pool_free(&pl->pool);
+    return NULL;
+}
+
+// 로더 스레드를 시작합니다. parser의 설정(hash_cons, inline_strings 등)으로 파싱합니다. 실패하면 false
+bool file_pipeline_start(file_pipeline *pl, const analyzer_options *opts, const json_parser *parser, const char **files, int file_count)
+{
+    memset(pl, 0x00, sizeof(file_pipeline));
+    pl->opts = opts;
+    pl->files = files;
+    pl->file_count = file_count;
+    json_parser_init(&pl->parser);
+    pl->parser.hash_cons = parser->hash_cons;
+    pl->parser.inline_strings = parser->inline_strings;
+    pl->parser.lazy_numbers = parser->lazy_numbers;
+    pl->parser.huge_page_threshold = parser->huge_page_threshold;
+    json_arena_pool_init(&pl->pool);
+    pl->parser.pool = &pl->pool;
+    pthread_mutex_init(&pl->lock, NULL);
+    pthread_cond_init(&pl->changed, NULL);
+    if (pthread_create(&pl->thread, NULL, file_pipeline_run, pl) == 0)
+        return true;
+    pthread_cond_destroy(&pl->changed);
+    pthread_mutex_destroy(&pl->lock);
+    json_parser_free(&pl->parser);
+    json_arena_pool_free(&pl->pool);
+    return false;
+}
+
+// files[file]의 문서를 받아 분석하고, 문서의 청크를 로더의 풀로 돌려줍니다
+// 지연 파싱된 본문은 메인 스레드의 parser에 만듭니다
+int file_pipeline_analyze(file_pipeline *pl, function_report *report, json_parser *parser, int file)
+{
+    pthread_mutex_lock(&pl->lock);
+    while (pl->produced == pl->consumed)
+        pthread_cond_wait(&pl->changed, &pl->lock);
+    pthread_mutex_unlock(&pl->lock);
+
+    loaded_file *slot = &pl->slots[pl->consumed % PIPELINE_DEPTH];
+    int status = 1;
+    if (slot->file == file && slot->document.root.type != JSON_UNDEFINED)
+    {
+        json_parser_reset(parser);
+        status = analyze_ast(pl->opts, report, parser, pl->files[file], slot->document.root, slot->lazy);
+    }
+    json_document_free(&slot->document);
+
+    pthread_mutex_lock(&pl->lock);
+    pl->consumed++;
+    pthread_cond_broadcast(&pl->changed);
+    pthread_mutex_unlock(&pl->lock);
+    return status;
+}
+
+// 모든 파일을 분석한 뒤 로더 스레드를 기다려 정리합니다
+void file_pipeline_finish(file_pipeline *pl)
+{
+    pthread_join(pl->thread, NULL);
+    for (int i = 0; i < PIPELINE_DEPTH; i++)
+        free(pl->slots[i].buffer);
+    pthread_cond_destroy(&pl->changed);
+    pthread_mutex_destroy(&pl->lock);
+}
+
+// 사용법: analyzer [--hash-cons] [--index] [--jobs N] [--write-bp 경로] [--emit-c 경로]
+//                 [--top K] [--by 메트릭] [--where 조건] [--function 패턴]
+//                 [--stats 경로] [--sample 비율] [AST파일 ...]  (파일 인자가 없으면 ast.json을 분석)
+//   --hash-cons      : 동일한 서브트리를 한 번만 저장하여(DAG) 메모리 사용량을 줄입니다
+//   --index          : preorder 색인을 만들어 함수별 if 개수를 O(1) 질의로 구합니다
+//   --jobs N         : 큰 함수 본문(노드 AST_PARALLEL_THRESHOLD개 이상)을 N개 스레드로 나누어 순회합니다.
+//                      N이 2 이상이고 입력 파일이 여럿이면 다음 파일의 파싱도 로더 스레드에서 겹쳐 합니다
+//   --write-bp 경로  : 문서를 succinct balanced-parentheses 형식(json_bp.c)으로 보관합니다 (입력 파일 1개)
+//   --emit-c 경로    : 문서를 C 소스로 다시 씁니다 ("-"이면 표준 출력, 입력 파일 1개)
+//   --top K          : 모든 입력 파일을 통틀어 메트릭 상위 K개 함수만 마지막에 출력합니다
+//   --by 메트릭      : --top의 기준 (ifs, params, nodes; 기본값 ifs)
+//   --where 조건     : 조건에 맞는 함수만 출력합니다 (예: ifs>20, params>=3)
+//   --function 패턴  : 이름이 맞는 함수만 분석합니다 (반복 가능). 정확한 이름, glob(handle_*),
+//                      re:정규식, 쉼표 목록, @파일(한 줄에 패턴 하나)을 받습니다
+//   --stats 경로     : 모든 입력 파일의 집계를 JSON으로 저장합니다 ("-"이면 표준 출력 끝에 출력)
+//   --sample 비율[,함수비율] : 해시로 고른 일부 파일(과 함수)만 분석하고 전체 값을 95% 신뢰구간과 함께 추정합니다.
+//                      입력 파일이 하나면 비율은 함수에 적용됩니다
+//   AST파일          : AST JSON, 또는 확장자가 .c/.i/.h인 전처리된 C 소스 (ast_cparse.c로 바로 파싱)
+int main(int argc, char *argv[])
+{
+    json_parser parser;
+    json_parser_init(&parser);
+    // 분석·출력 코드는 문자열을 문서 안의 값 칸에서 읽으므로 짧은 문자열은 값 안에 둡니다
+    parser.inline_strings = true;
+    // 숫자는 분석에 쓰이지 않으므로 읽을 때까지 원문 토큰으로 둡니다 (파일 버퍼는 문서를 다 쓸 때까지 유지됨)
+    parser.lazy_numbers = true;
+    // 수백 MB짜리 AST는 순회할 때 TLB 미스가 잦으므로 큰 문서의 청크는 2MB 대형 페이지(THP)로 받습니다
+    parser.huge_page_threshold = JSON_ARENA_HUGE_PAGE_THRESHOLD;
+    analyzer_options opts = {.jobs = 1};
+    function_report report;
+    memset(&report, 0x00, sizeof(report));
+    function_filter filter;
+    memset(&filter, 0x00, sizeof(filter));
+    corpus_stats stats;
+    memset(&stats, 0x00, sizeof(stats));
+    const char *stats_path = NULL;
+    sample_stats sample;
+    memset(&sample, 0x00, sizeof(sample));
+    const char *sample_arg = NULL;
+
+    const char **files = (const char **)malloc(sizeof(char *) * (argc > 1 ? argc : 1));
+    int file_count = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--hash-cons") == 0)
+            parser.hash_cons = true;
+        else if (strcmp(argv[i], "--index") == 0)
+            opts.use_index = true;
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+        {
+            opts.jobs = atoi(argv[++i]);
+            if (opts.jobs < 1)
+                opts.jobs = 1;
+        }
+        else if (strcmp(argv[i], "--write-bp") == 0 && i + 1 < argc)
+            opts.bp_path = argv[++i];
+        else if (strcmp(argv[i], "--emit-c") == 0 && i + 1 < argc)
+            opts.emit_path = argv[++i];
+        else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc)
+        {
+            report.top = atoll(argv[++i]);
+            if (report.top < 0)
+                report.top = 0;
+        }
+        else if (strcmp(argv[i], "--by") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (!function_metric_parse(argv[i], strlen(argv[i]), &report.by))
             {
-                total_functions++;
-                process_function(node);
+                fprintf(stderr, "알 수 없는 메트릭입니다: %s\n", argv[i]);
+                free(files);
+                return 1;
             }
         }
+        else if (strcmp(argv[i], "--where") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (!function_report_parse_where(&report, argv[i]))
+            {
+                fprintf(stderr, "잘못된 조건입니다: %s\n", argv[i]);
+                free(files);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc)
+            stats_path = argv[++i];
+        else if (strcmp(argv[i], "--sample") == 0 && i + 1 < argc)
+            sample_arg = argv[++i];
+        else if (strcmp(argv[i], "--function") == 0 && i + 1 < argc)
+        {
+            if (!function_filter_add(&filter, argv[++i]))
+            {
+                function_filter_free(&filter);
+                free(files);
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--", 2) == 0)
+        {
+            fprintf(stderr, "알 수 없는 옵션입니다: %s\n", argv[i]);
+            free(files);
+            return 1;
+        }
+        else
+            files[file_count++] = argv[i];
     }
-    printf("Total number of functions: %d\n", total_functions);
-    return 0;
+    if (file_count == 0)
+        files[file_count++] = "ast.json";
+    if (opts.bp_path != NULL && file_count > 1)
+    {
+        fprintf(stderr, "--write-bp는 입력 파일이 하나일 때만 사용할 수 있습니다.\n");
+        free(files);
+        return 1;
+    }
+    if (opts.emit_path != NULL && file_count > 1)
+    {
+        fprintf(stderr, "--emit-c는 입력 파일이 하나일 때만 사용할 수 있습니다.\n");
+        free(files);
+        return 1;
+    }
+
+    if (!function_filter_empty(&filter))
+        opts.filter = &filter;
+    if (stats_path != NULL)
+        opts.stats = &stats;
+    if (sample_arg != NULL)
+    {
+        if (!sample_stats_parse(&sample, sample_arg, file_count == 1))
+        {
+            fprintf(stderr, "잘못된 표본 비율입니다: %s\n", sample_arg);
+            function_filter_free(&filter);
+            free(files);
+            return 1;
+        }
+        opts.sample = &sample;
+    }
+    if (!function_report_init(&report))
+    {
+        function_filter_free(&filter);
+        free(files);
+        return 1;
+    }
+
+    char *buffer = NULL;
+    size_t buffer_size = 0;
+
+    int status = 0;
+    int printed = 0;
+    // 스레드를 만들지 못하면 파일을 차례로 읽으며 분석합니다
+    file_pipeline pipeline;
+    bool pipelined = opts.jobs > 1 && file_count > 1 && file_pipeline_start(&pipeline, &opts, &parser, files, file_count);
+    for (int i = 0; i < file_count; i++)
+    {
+        // 표본에 들지 않은 파일은 열지도 않습니다
+        if (opts.sample != NULL && !sample_begin_file(opts.sample, files[i]))
+            continue;
+        if (file_count > 1)
+            printf("%sFile: %s\n\n", printed++ ? "\n" : "", files[i]);
+        int result = pipelined ? file_pipeline_analyze(&pipeline, &report, &parser, i)
+                               : analyze_file(&opts, &report, &parser, files[i], &buffer, &buffer_size);
+        if (result != 0)
+            status = 1;
+        else if (opts.sample != NULL)
+            sample_end_file(opts.sample);
+    }
+    if (pipelined)
+        file_pipeline_finish(&pipeline);
+    if (opts.sample != NULL)
+    {
+        printf("\nSampled %lld of %lld files, %lld of %lld functions\n", (long long)sample.files_sampled,
+               (long long)sample.files_seen, (long long)sample.functions_sampled, (long long)sample.functions_seen);
+        printf("Estimated totals: ");
+        sample_stats_fprint(stdout, &sample);
+        printf("\n");
+    }
+    if (report.top > 0)
+        printf("\nTop %lld functions by %s (%lld matched):\n\n", (long long)report.top,
+               function_metric_names[report.by], (long long)report.matched);
+    function_report_finish(&report);
+    function_filter_free(&filter);
+    if (stats_path != NULL)
+    {
+        FILE *stats_fp = strcmp(stats_path, "-") == 0 ? stdout : fopen(stats_path, "w");
+        if (stats_fp == NULL)
+        {
+            fprintf(stderr, "%s 파일을 열 수 없습니다.\n", stats_path);
+            status = 1;
+        }
+        else
+        {
+            if (stats_fp == stdout)
+                printf("\n");
+            corpus_stats_fprint(stats_fp, &stats, opts.sample);
+            if (stats_fp != stdout)
+                fclose(stats_fp);
+        }
+        corpus_stats_free(&stats);
+    }
+
+    free(buffer);
+    free(files);
+    json_parser_free(&parser);
+    return status;
 }
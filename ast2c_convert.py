@@ -1,6 +1,15 @@
 import json
 import sys
 
+try:
+    import json_c  # json_py.c로 빌드한 확장 모듈: C 파서 위의 지연 dict/list 뷰
+except ImportError:
+    json_c = None
+
+# 노드 판별에 쓰는 타입들. 확장 모듈이 있으면 그 뷰 타입도 dict/list처럼 취급합니다.
+MAPPING_TYPES = (dict,) + ((json_c.Object,) if json_c else ())
+SEQUENCE_TYPES = (list,) + ((json_c.Array,) if json_c else ())
+
 def indent_str(level):
     """주어진 들여쓰기(level, 네 칸 기준)에 따른 공백 문자열 반환"""
     return "    " * level
@@ -10,14 +19,14 @@ def get_declname(node):
     노드(또는 노드 트리) 내에 'declname' 필드가 있다면 그 값을 반환합니다.
     없으면 None을 반환.
     """
-    if isinstance(node, dict):
+    if isinstance(node, MAPPING_TYPES):
         if 'declname' in node and node['declname']:
             return node['declname']
         for key, value in node.items():
             result = get_declname(value)
             if result:
                 return result
-    elif isinstance(node, list):
+    elif isinstance(node, SEQUENCE_TYPES):
         for item in node:
             result = get_declname(item)
             if result:
@@ -27,7 +36,7 @@ def get_declname(node):
 def generate_code(node, level=0, in_param=False):
     """AST 노드를 재귀적으로 순회하여 C 코드 문자열로 변환합니다.
     in_param이 True이면 파라미터 목록 형식으로 처리(세미콜론 제거 등)"""
-    if isinstance(node, dict):
+    if isinstance(node, MAPPING_TYPES):
         nodetype = node.get('_nodetype', '')
         # 각 노드별 분기 처리
         if nodetype == 'FileAST':
@@ -164,17 +173,30 @@ def generate_code(node, level=0, in_param=False):
         # 처리하지 않은 노드의 자식들을 순회
         code = ""
         for key, value in node.items():
-            if isinstance(value, dict):
+            if isinstance(value, MAPPING_TYPES):
                 code += generate_code(value, level, in_param)
-            elif isinstance(value, list):
+            elif isinstance(value, SEQUENCE_TYPES):
                 for item in value:
                     code += generate_code(item, level, in_param)
         return code
-    elif isinstance(node, list):
+    elif isinstance(node, SEQUENCE_TYPES):
         return "\n".join(generate_code(item, level, in_param) for item in node)
     else:
         return str(node)
 
+def load_ast(filename):
+    """AST를 읽습니다. json_c 확장 모듈이 있으면 C 파서(또는 .bp 보관 파일)를 쓰고,
+    없거나 C 파서가 읽지 못하면 표준 json 모듈로 읽습니다."""
+    if json_c is not None:
+        if filename.endswith('.bp'):
+            return json_c.load_bp(filename)
+        try:
+            return json_c.load(filename)
+        except ValueError:
+            pass
+    with open(filename, 'r', encoding='utf-8') as f:
+        return json.load(f)
+
 def main():
     if len(sys.argv) < 2:
         print("Usage: python ast_to_c_pretty.py ast.json")
@@ -182,8 +204,7 @@ def main():
 
     filename = sys.argv[1]
     try:
-        with open(filename, 'r', encoding='utf-8') as f:
-            ast = json.load(f)
+        ast = load_ast(filename)
     except Exception as e:
         print("Error reading AST file:", e)
         return
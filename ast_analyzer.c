@@ -0,0 +1,1133 @@
+#ifndef __AST_ANALYZER_HEADER__
+#define __AST_ANALYZER_HEADER__
+
+/*
+ * ast_analyzer.c
+ *
+ * pycparser AST(JSON) 분석 라이브러리. 출력 없이 결과를 구조체로 돌려주므로
+ * 다른 프로그램에 그대로 포함해 쓸 수 있습니다 (analyzer.c는 이 파일을 쓰는 명령행 도구입니다).
+ *   - ast_walk()            : 명시적 스택을 쓰는 비재귀 순회
+ *   - ast_collect_metrics() : 서브트리 메트릭 (큰 본문은 여러 스레드로 나누어 순회)
+ *   - ast_index_*()         : preorder/서브트리 크기 색인과 O(1) 서브트리 질의
+ *   - analyze_function()    : 함수 노드 하나 → function_record
+ *   - analyze_document()    : 문서 전체의 함수들 → analyzer_results
+ *
+ * 사용 예:
+ *   json_parser parser;
+ *   json_parser_init(&parser);
+ *   json_value doc = json_parser_parse(&parser, text);
+ *   analyzer_results results;
+ *   analyzer_results_init(&results);
+ *   if (analyze_document(&doc, &results) == 0)
+ *       ... results.functions[0 .. results.count) ...
+ *   analyzer_results_free(&results);   // 문서(parser)보다 먼저 정리하거나 analyzer_results_detach()
+ *   json_parser_free(&parser);
+ *
+ * 컴파일 시 -pthread가 필요합니다.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "json_c.c"
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+//ast_walk() 콜백: pre가 false를 돌려주면 그 노드의 자식을 건너뜁니다
+typedef bool (*ast_pre_fn)(json_value node, const char *nodetype, json_index preorder, void *ctx);
+typedef void (*ast_post_fn)(json_value node, json_index preorder, json_index subtree_size, void *ctx);
+
+//문자열 → 빈도 해시 맵. 스레드마다 하나씩 두고 stat_counter_merge()로 합칩니다
+typedef struct stat_counter_s
+{
+    char **keys;
+    int64_t *counts;
+    size_t count;
+    size_t capacity;
+} stat_counter;
+
+typedef struct ast_metrics_s
+{
+    int64_t node_count; // 객체/배열 노드 수
+    int64_t if_count;   // "If" 노드 수
+    stat_counter *kinds; // NULL이 아니면 _nodetype별 빈도도 셉니다
+} ast_metrics;
+
+//preorder 번호와 서브트리 크기 색인 (ast_index_build())
+typedef struct ast_index_s
+{
+    json_index node_count;
+    json_index node_capacity;
+    const void **nodes;        // preorder -> json_object* / json_array*
+    json_index *subtree_size;  // preorder -> 자신을 포함한 서브트리의 노드 수
+    int32_t *kinds;            // preorder -> 노드 종류(_nodetype) 번호, 배열 등은 -1
+    char **kind_names;
+    int32_t kind_count;
+    int32_t kind_capacity;
+    json_index **prefix;       // 종류별 prefix 개수: prefix[k][i] = preorder < i 인 종류 k 노드 수
+    const void **map_keys;     // 노드 포인터 -> preorder (open addressing)
+    json_index *map_values;
+    size_t map_capacity;
+} ast_index;
+
+/*
+ * 함수 하나의 분석 결과.
+ * 문자열(name, return_type, 파라미터 이름/타입)은 보통 문서 안의 문자열을 빌려 쓰므로 문서가 살아 있는 동안만 유효합니다.
+ * 문서가 재사용된 뒤에도 남겨야 하는 레코드(top-K 힙 등)는 function_record_detach()로 복사본을 소유합니다.
+ * 어느 경우든 다 쓴 레코드는 function_record_release()로 정리합니다.
+ */
+typedef enum function_metric_enum
+{
+    METRIC_IFS = 0, // 본문 내 if 조건문 수
+    METRIC_PARAMS,  // 파라미터 수
+    METRIC_NODES,   // 본문의 AST 노드(객체/배열) 수
+    METRIC_COUNT
+} function_metric;
+static const char *const function_metric_names[METRIC_COUNT] = {"ifs", "params", "nodes"};
+
+typedef struct function_param_s
+{
+    char *name; // 이름이 없으면 "anonymous"
+    char *type; // extract_type() 결과 (빌린 경우 '*'로 시작하면 동적할당된 문자열)
+} function_param;
+
+typedef struct function_record_s
+{
+    char *name;
+    char *return_type;
+    bool owned; // 문자열들을 직접 소유하는지
+    bool is_definition;
+    bool has_params;        // 파라미터 목록(args.params)이 있는지. 없으면 "None"으로 출력
+    function_param *params; // metrics[METRIC_PARAMS]개
+    int64_t metrics[METRIC_COUNT];
+    int64_t sequence; // 입력 순서 (동점일 때 먼저 나온 함수를 우선)
+} function_record;
+
+// --- analyze_document()의 입력 설정과 결과 ---
+typedef struct analyzer_results_s
+{
+    // 입력
+    int jobs;          // 큰 함수 본문을 순회할 스레드 수 (analyzer_results_init()이 1로 설정)
+    ast_index *index;  // NULL이 아니면 이 색인으로 if 개수를 O(1)에 구합니다 (같은 문서로 만든 색인)
+    // 결과: analyze_document()를 부를 때마다 뒤에 덧붙습니다
+    function_record *functions;
+    json_index count;
+    json_index capacity;
+    int64_t definitions;  // 함수 정의(FuncDef) 수
+    int64_t declarations; // 함수 선언(Decl + FuncDecl) 수
+    int64_t if_total;     // 함수 정의들의 if 조건문 수 합계
+} analyzer_results;
+
+const char *ast_nodetype(const json_object *obj);
+json_index ast_walk(json_value root, ast_pre_fn pre, ast_post_fn post, void *ctx);
+int64_t count_if_nodes(json_value node);
+char *get_json_string(const json_value *node);
+
+bool stat_counter_add(stat_counter *c, const char *key, int64_t n);
+void stat_counter_merge(stat_counter *dst, const stat_counter *src);
+void stat_counter_free(stat_counter *c);
+
+ast_metrics ast_collect_metrics(json_value root, int jobs, stat_counter *kinds);
+
+bool ast_index_build(ast_index *idx, json_value root);
+void ast_index_free(ast_index *idx);
+json_index ast_index_preorder(const ast_index *idx, json_value node);
+bool ast_index_contains(const ast_index *idx, json_index ancestor, json_index node);
+int64_t ast_index_count_kind(ast_index *idx, json_index pre, const char *kind_name);
+
+char *extract_type(json_value node);
+char *extract_return_type(json_value decl_type);
+bool extract_params(json_value args_val, function_record *rec);
+
+bool ast_is_function_node(json_value node, bool *is_definition);
+const char *function_node_name(json_value func_node, bool is_definition);
+bool analyze_function(json_value func_node, ast_index *index, int jobs, function_record *rec);
+void function_record_release(function_record *rec);
+bool function_record_detach(function_record *rec);
+
+void analyzer_results_init(analyzer_results *results);
+void analyzer_results_free(analyzer_results *results);
+bool analyzer_results_detach(analyzer_results *results);
+int analyze_document(const json_value *doc, analyzer_results *results);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#ifndef __AST_ANALYZER_BODY__
+#define __AST_ANALYZER_BODY__
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*
+ * ast_walk: 명시적 스택을 사용하는 비재귀 순회 엔진.
+ * JSON 레벨은 AST 레벨의 약 두 배이므로, 재귀 순회는 깊은 else-if 사슬에서 스택이 넘칠 수 있습니다.
+ * 컨테이너(객체/배열) 노드마다 preorder 번호를 매기며
+ *   - pre(node, nodetype, preorder, ctx) : 자식 방문 전 호출, false를 돌려주면 자식을 건너뜁니다
+ *   - post(node, preorder, subtree_size, ctx) : 서브트리 방문이 끝난 뒤 호출 (NULL 가능)
+ * 다음에 방문할 형제 노드는 미리 prefetch 합니다.
+ */
+#if defined(__GNUC__)
+#define AST_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define AST_PREFETCH(p) ((void)(p))
+#endif
+#define AST_WALK_INLINE_DEPTH 64
+
+typedef struct ast_walk_frame_s
+{
+    json_value node;
+    const json_value *children;
+    json_index count;
+    json_index next;
+    json_index preorder;
+} ast_walk_frame;
+
+// --- 객체의 "_nodetype" 값을 찾습니다 ---
+// pycparser는 키를 정렬해 내보내므로 "_nodetype"은 거의 항상 첫 슬롯에 있습니다.
+// 첫 슬롯을 먼저 확인하고, 아닐 때만 전체 키를 훑습니다.
+const char *ast_nodetype(const json_object *obj)
+{
+    if (obj->last_index < 0)
+        return NULL;
+    json_index slot = 0;
+    if (strcmp(obj->keys[0], "_nodetype") != 0)
+    {
+        for (slot = 1; slot <= obj->last_index; slot++)
+            if (strcmp(obj->keys[slot], "_nodetype") == 0)
+                break;
+        if (slot > obj->last_index)
+            return NULL;
+    }
+    return json_string_of(&obj->values[slot]);
+}
+
+static void ast_walk_enter(ast_walk_frame *frame, json_value node, json_index preorder)
+{
+    frame->node = node;
+    frame->preorder = preorder;
+    frame->next = 0;
+    if (node.type == JSON_OBJECT)
+    {
+        frame->children = ((json_object *)node.value)->values;
+        frame->count = ((json_object *)node.value)->last_index + 1;
+    }
+    else
+    {
+        frame->children = ((json_array *)node.value)->values;
+        frame->count = ((json_array *)node.value)->last_index + 1;
+    }
+    if (frame->count > 0)
+        AST_PREFETCH(frame->children[0].value);
+}
+
+// root 아래의 모든 컨테이너 노드를 preorder로 방문합니다. 방문한 노드 수를 돌려주며, 메모리 부족 시 -1
+json_index ast_walk(json_value root, ast_pre_fn pre, ast_post_fn post, void *ctx)
+{
+    if ((root.type != JSON_OBJECT && root.type != JSON_ARRAY) || root.value == NULL)
+        return 0;
+
+    ast_walk_frame inline_frames[AST_WALK_INLINE_DEPTH];
+    ast_walk_frame *stack = inline_frames;
+    size_t capacity = AST_WALK_INLINE_DEPTH;
+    size_t top = 0;
+    json_index visited = 0;
+
+    const char *nodetype = root.type == JSON_OBJECT ? ast_nodetype((json_object *)root.value) : NULL;
+    if (pre != NULL && !pre(root, nodetype, visited++, ctx))
+    {
+        if (post != NULL)
+            post(root, 0, 1, ctx);
+        return visited;
+    }
+    ast_walk_enter(&stack[top++], root, 0);
+
+    while (top > 0)
+    {
+        ast_walk_frame *frame = &stack[top - 1];
+        if (frame->next == frame->count)
+        {
+            if (post != NULL)
+                post(frame->node, frame->preorder, visited - frame->preorder, ctx);
+            top--;
+            continue;
+        }
+        json_value child = frame->children[frame->next++];
+        if (frame->next < frame->count)
+            AST_PREFETCH(frame->children[frame->next].value);
+        if ((child.type != JSON_OBJECT && child.type != JSON_ARRAY) || child.value == NULL)
+            continue;
+
+        json_index preorder = visited++;
+        nodetype = child.type == JSON_OBJECT ? ast_nodetype((json_object *)child.value) : NULL;
+        if (pre != NULL && !pre(child, nodetype, preorder, ctx))
+        {
+            if (post != NULL)
+                post(child, preorder, 1, ctx);
+            continue;
+        }
+        if (top == capacity)
+        {
+            size_t grown = capacity * 2;
+            ast_walk_frame *frames = (ast_walk_frame *)malloc(sizeof(ast_walk_frame) * grown);
+            if (frames == NULL)
+            {
+                if (stack != inline_frames)
+                    free(stack);
+                return -1;
+            }
+            memcpy(frames, stack, sizeof(ast_walk_frame) * top);
+            if (stack != inline_frames)
+                free(stack);
+            stack = frames;
+            capacity = grown;
+        }
+        ast_walk_enter(&stack[top++], child, preorder);
+    }
+
+    if (stack != inline_frames)
+        free(stack);
+    return visited;
+}
+
+// --- AST를 순회하여 if 노드("_nodetype"가 "If") 개수를 셉니다 ---
+static bool count_if_visit(json_value node, const char *nodetype, json_index preorder, void *ctx)
+{
+    (void)node;
+    (void)preorder;
+    if (nodetype != NULL && strcmp(nodetype, "If") == 0)
+        (*(int64_t *)ctx)++;
+    return true;
+}
+
+int64_t count_if_nodes(json_value node)
+{
+    int64_t count = 0;
+    ast_walk(node, count_if_visit, NULL, &count);
+    return count;
+}
+
+/*
+ * stat_counter: 문자열 → 빈도 해시 맵 (open addressing).
+ * 키는 문서가 재사용된 뒤에도 남아야 하므로 처음 볼 때 복사해 둡니다.
+ * 스레드마다 하나씩 두고 끝에서 stat_counter_merge()로 합치면 잠금이 필요 없습니다.
+ */
+static size_t stat_counter_slot(const stat_counter *c, const char *key)
+{
+    uint64_t h = 1469598103934665603ULL; // FNV-1a
+    for (const char *k = key; *k; k++)
+        h = (h ^ (unsigned char)*k) * 1099511628211ULL;
+    size_t i = h & (c->capacity - 1);
+    while (c->keys[i] != NULL && strcmp(c->keys[i], key) != 0)
+        i = (i + 1) & (c->capacity - 1);
+    return i;
+}
+
+bool stat_counter_add(stat_counter *c, const char *key, int64_t n)
+{
+    if ((c->count + 1) * 2 > c->capacity)
+    {
+        stat_counter grown;
+        grown.capacity = c->capacity ? c->capacity * 2 : 32;
+        grown.count = c->count;
+        grown.keys = (char **)calloc(grown.capacity, sizeof(char *));
+        grown.counts = (int64_t *)calloc(grown.capacity, sizeof(int64_t));
+        if (grown.keys == NULL || grown.counts == NULL)
+        {
+            free(grown.keys);
+            free(grown.counts);
+            return false;
+        }
+        for (size_t i = 0; i < c->capacity; i++)
+        {
+            if (c->keys[i] == NULL)
+                continue;
+            size_t j = stat_counter_slot(&grown, c->keys[i]);
+            grown.keys[j] = c->keys[i];
+            grown.counts[j] = c->counts[i];
+        }
+        free(c->keys);
+        free(c->counts);
+        *c = grown;
+    }
+    size_t i = stat_counter_slot(c, key);
+    if (c->keys[i] == NULL)
+    {
+        c->keys[i] = strdup(key);
+        if (c->keys[i] == NULL)
+            return false;
+        c->count++;
+    }
+    c->counts[i] += n;
+    return true;
+}
+
+void stat_counter_merge(stat_counter *dst, const stat_counter *src)
+{
+    for (size_t i = 0; i < src->capacity; i++)
+        if (src->keys[i] != NULL)
+            stat_counter_add(dst, src->keys[i], src->counts[i]);
+}
+
+void stat_counter_free(stat_counter *c)
+{
+    for (size_t i = 0; i < c->capacity; i++)
+        free(c->keys[i]);
+    free(c->keys);
+    free(c->counts);
+    memset(c, 0x00, sizeof(stat_counter));
+}
+
+/*
+ * 함수 본문 메트릭과 task 병렬 순회.
+ * 상태 머신처럼 노드가 수십만 개인 함수 하나가 전체 분석의 꼬리를 잡지 않도록,
+ * 큰 본문은 Compound.block_items 등을 따라 너비 우선으로 쪼개 task 목록을 만들고
+ * 여러 스레드가 원자적 카운터로 task를 가져가 각자의 누적기에 더한 뒤 마지막에 합칩니다 (fork-join).
+ * 본문이 작은지는 AST_PARALLEL_THRESHOLD 노드까지만 순차로 세어 보고 판단합니다.
+ */
+#define AST_PARALLEL_THRESHOLD 50000
+#define AST_TASKS_PER_JOB 16
+
+static void ast_metrics_add(ast_metrics *dst, const ast_metrics *src)
+{
+    dst->node_count += src->node_count;
+    dst->if_count += src->if_count;
+    if (dst->kinds != NULL && src->kinds != NULL)
+        stat_counter_merge(dst->kinds, src->kinds);
+}
+
+static void ast_metrics_count(ast_metrics *m, const char *nodetype)
+{
+    m->node_count++;
+    if (nodetype != NULL && strcmp(nodetype, "If") == 0)
+        m->if_count++;
+    if (nodetype != NULL && m->kinds != NULL)
+        stat_counter_add(m->kinds, nodetype, 1);
+}
+
+static bool ast_metrics_visit(json_value node, const char *nodetype, json_index preorder, void *ctx)
+{
+    (void)node;
+    (void)preorder;
+    ast_metrics_count((ast_metrics *)ctx, nodetype);
+    return true;
+}
+
+// 예산까지만 세고, 넘으면 나머지 자식을 모두 건너뜁니다
+typedef struct ast_probe_s
+{
+    ast_metrics metrics;
+    int64_t budget;
+} ast_probe;
+
+static bool ast_probe_visit(json_value node, const char *nodetype, json_index preorder, void *ctx)
+{
+    (void)node;
+    (void)preorder;
+    ast_probe *probe = (ast_probe *)ctx;
+    if (probe->metrics.node_count >= probe->budget)
+        return false;
+    ast_metrics_count(&probe->metrics, nodetype);
+    return true;
+}
+
+typedef struct ast_task_pool_s
+{
+    const json_value *tasks;
+    size_t task_count;
+    atomic_size_t next;
+} ast_task_pool;
+
+typedef struct ast_worker_s
+{
+    ast_task_pool *pool;
+    ast_metrics metrics; // 스레드별 누적기: 잠금 없이 더하고 join 후에 합칩니다
+    stat_counter kinds;  // metrics.kinds가 가리키는 스레드별 nodetype 빈도
+    pthread_t thread;
+    bool started;
+} ast_worker;
+
+static void *ast_worker_run(void *arg)
+{
+    ast_worker *worker = (ast_worker *)arg;
+    size_t i;
+    while ((i = atomic_fetch_add(&worker->pool->next, 1)) < worker->pool->task_count)
+        ast_walk(worker->pool->tasks[i], ast_metrics_visit, NULL, &worker->metrics);
+    return NULL;
+}
+
+static bool ast_task_push(json_value **tasks, size_t *count, size_t *capacity, json_value v)
+{
+    if (*count == *capacity)
+    {
+        size_t grown = *capacity ? *capacity * 2 : 64;
+        json_value *next = (json_value *)realloc(*tasks, sizeof(json_value) * grown);
+        if (next == NULL)
+            return false;
+        *tasks = next;
+        *capacity = grown;
+    }
+    (*tasks)[(*count)++] = v;
+    return true;
+}
+
+// 컨테이너를 자식 컨테이너들로 한 단계씩 펼쳐 task를 wanted개 이상 만듭니다.
+// 펼쳐진 노드 자신은 shell 누적기에 더합니다.
+static json_value *ast_split_tasks(json_value root, size_t wanted, size_t *out_count, ast_metrics *shell)
+{
+    json_value *tasks = NULL;
+    size_t count = 0, capacity = 0;
+    if (!ast_task_push(&tasks, &count, &capacity, root))
+        return NULL;
+    bool changed = true;
+    while (count < wanted && changed)
+    {
+        changed = false;
+        json_value *next = NULL;
+        size_t next_count = 0, next_capacity = 0;
+        for (size_t t = 0; t < count; t++)
+        {
+            json_value task = tasks[t];
+            const json_value *children;
+            json_index child_count;
+            if (task.type == JSON_OBJECT)
+            {
+                children = ((json_object *)task.value)->values;
+                child_count = ((json_object *)task.value)->last_index + 1;
+            }
+            else
+            {
+                children = ((json_array *)task.value)->values;
+                child_count = ((json_array *)task.value)->last_index + 1;
+            }
+            bool has_container = false;
+            for (json_index i = 0; i < child_count; i++)
+                if ((children[i].type == JSON_OBJECT || children[i].type == JSON_ARRAY) && children[i].value != NULL)
+                    has_container = true;
+            bool ok = true;
+            if (!has_container)
+                ok = ast_task_push(&next, &next_count, &next_capacity, task);
+            else
+            {
+                ast_metrics_count(shell, task.type == JSON_OBJECT ? ast_nodetype((json_object *)task.value) : NULL);
+                for (json_index i = 0; i < child_count && ok; i++)
+                    if ((children[i].type == JSON_OBJECT || children[i].type == JSON_ARRAY) && children[i].value != NULL)
+                        ok = ast_task_push(&next, &next_count, &next_capacity, children[i]);
+                changed = true;
+            }
+            if (!ok)
+            {
+                free(next);
+                free(tasks);
+                return NULL;
+            }
+        }
+        free(tasks);
+        tasks = next;
+        count = next_count;
+    }
+    *out_count = count;
+    return tasks;
+}
+
+// 서브트리의 메트릭을 구합니다. jobs > 1이고 본문이 크면 task 병렬로 순회합니다.
+// kinds가 주어지면 _nodetype별 빈도를 그곳에 더합니다.
+ast_metrics ast_collect_metrics(json_value root, int jobs, stat_counter *kinds)
+{
+    ast_metrics result = {0, 0, kinds};
+    if (jobs <= 1)
+    {
+        ast_walk(root, ast_metrics_visit, NULL, &result);
+        return result;
+    }
+
+    ast_probe probe = {{0, 0, NULL}, AST_PARALLEL_THRESHOLD};
+    ast_walk(root, ast_probe_visit, NULL, &probe);
+    if (probe.metrics.node_count < probe.budget)
+    {
+        if (kinds == NULL)
+            return probe.metrics;
+        ast_walk(root, ast_metrics_visit, NULL, &result); // 작은 본문은 빈도까지 다시 셉니다
+        return result;
+    }
+
+    size_t task_count = 0;
+    json_value *tasks = ast_split_tasks(root, (size_t)jobs * AST_TASKS_PER_JOB, &task_count, &result);
+    ast_worker *workers = (ast_worker *)calloc((size_t)jobs, sizeof(ast_worker));
+    if (tasks == NULL || workers == NULL)
+    {
+        free(tasks);
+        free(workers);
+        result.node_count = result.if_count = 0;
+        ast_walk(root, ast_metrics_visit, NULL, &result);
+        return result;
+    }
+
+    ast_task_pool pool;
+    pool.tasks = tasks;
+    pool.task_count = task_count;
+    atomic_init(&pool.next, 0);
+    // 스레드 생성에 실패하면 호출한 스레드가 남은 task를 처리합니다
+    for (int j = 0; j < jobs; j++)
+    {
+        workers[j].pool = &pool;
+        if (kinds != NULL)
+            workers[j].metrics.kinds = &workers[j].kinds;
+        if (j > 0)
+            workers[j].started = pthread_create(&workers[j].thread, NULL, ast_worker_run, &workers[j]) == 0;
+    }
+    ast_worker_run(&workers[0]);
+    for (int j = 0; j < jobs; j++)
+    {
+        if (workers[j].started)
+            pthread_join(workers[j].thread, NULL);
+        ast_metrics_add(&result, &workers[j].metrics);
+        stat_counter_free(&workers[j].kinds);
+    }
+
+    free(tasks);
+    free(workers);
+    return result;
+}
+
+// --- JSON 객체에서 문자열 값 추출 (타입이 JSON_STRING일 경우) ---
+// 짧은 문자열은 값 칸 안에 들어 있을 수 있으므로(JSON_INLINE) 문서 안의 칸을 가리키는 포인터를 받습니다.
+char *get_json_string(const json_value *node)
+{
+    return (char *)json_string_of(node);
+}
+
+// --- 호출 위치마다 둔 인라인 캐시로 키를 찾습니다 ---
+// pycparser는 노드 종류마다 같은 순서로 키를 내보내므로 대부분 캐시된 슬롯 하나만 비교하고 끝납니다.
+// 문서 안의 값 칸을 돌려주고, 키가 없으면 오류 메시지 없이 undefined를 가리킵니다.
+// 모양(shape)이 맞으면 슬롯을 다시 확인하지 않으므로, 캐시를 공유하다 다른 스레드가 반쯤 고쳐 쓴
+// 항목을 읽으면 엉뚱한 값이 나옵니다. 그래서 호출 위치의 캐시는 스레드마다 따로 둡니다 (JSON_THREAD_LOCAL).
+static const json_value *ast_get(json_value node, const char *key, json_inline_cache *ic)
+{
+    const json_value *v = json_get_ic(node, key, ic);
+    return v != NULL ? v : &undefined_json;
+}
+
+/*
+ * ast_index: 파싱 직후 한 번의 순회로 모든 컨테이너(객체/배열) 노드에
+ * preorder 번호와 서브트리 크기를 붙입니다.
+ *   - 노드 N의 서브트리는 preorder 구간 [pre(N), pre(N) + size(N)) 입니다.
+ *   - "N 아래에 종류 X인 노드가 몇 개인가"는 X의 prefix 합 배열에서 두 값을 빼는 O(1) 연산입니다.
+ *   - "A가 B의 조상인가"는 구간 포함 검사입니다.
+ * prefix 배열은 종류별로 처음 질의될 때 만들어지고 원자적으로 게시되므로, 다 만든 색인은 여러 스레드가 함께 질의할 수 있습니다.
+ * 이 파일의 함수들은 출력을 하지 않습니다. 실패는 반환값으로만 알리며 메시지는 호출한 쪽이 냅니다.
+ * hash-cons(DAG) 문서에서 공유된 노드는 첫 번째 위치로 기록되며, 서브트리가 동일하므로 개수 질의 결과도 같습니다.
+ */
+static size_t ast_index_hash(const void *ptr, size_t capacity)
+{
+    uint64_t h = (uint64_t)(uintptr_t)ptr * 0x9e3779b97f4a7c15ULL;
+    return (size_t)(h >> 17) & (capacity - 1);
+}
+
+// _nodetype 문자열을 종류 번호로 바꿉니다 (종류는 수십 개뿐이라 선형 탐색으로 충분)
+static int32_t ast_index_kind(ast_index *idx, const char *name, bool create)
+{
+    for (int32_t k = 0; k < idx->kind_count; k++)
+        if (strcmp(idx->kind_names[k], name) == 0)
+            return k;
+    if (!create)
+        return -1;
+    if (idx->kind_count == idx->kind_capacity)
+    {
+        int32_t capacity = idx->kind_capacity ? idx->kind_capacity * 2 : 64;
+        char **names = (char **)realloc(idx->kind_names, sizeof(char *) * capacity);
+        json_index **prefix = (json_index **)realloc(idx->prefix, sizeof(json_index *) * capacity);
+        if (names == NULL || prefix == NULL)
+        {
+            if (names != NULL)
+                idx->kind_names = names;
+            if (prefix != NULL)
+                idx->prefix = prefix;
+            return -1;
+        }
+        idx->kind_names = names;
+        idx->prefix = prefix;
+        idx->kind_capacity = capacity;
+    }
+    idx->kind_names[idx->kind_count] = strdup(name);
+    idx->prefix[idx->kind_count] = NULL;
+    return idx->kind_count++;
+}
+
+static bool ast_index_grow(ast_index *idx)
+{
+    json_index capacity = idx->node_capacity ? idx->node_capacity * 2 : 1024;
+    const void **nodes = (const void **)realloc(idx->nodes, sizeof(void *) * (size_t)capacity);
+    if (nodes == NULL)
+        return false;
+    idx->nodes = nodes;
+    json_index *sizes = (json_index *)realloc(idx->subtree_size, sizeof(json_index) * (size_t)capacity);
+    if (sizes == NULL)
+        return false;
+    idx->subtree_size = sizes;
+    int32_t *kinds = (int32_t *)realloc(idx->kinds, sizeof(int32_t) * (size_t)capacity);
+    if (kinds == NULL)
+        return false;
+    idx->kinds = kinds;
+    idx->node_capacity = capacity;
+    return true;
+}
+
+// ast_walk가 매긴 preorder 번호를 그대로 색인 번호로 사용합니다
+static bool ast_index_label(json_value node, const char *nodetype, json_index preorder, void *ctx)
+{
+    ast_index *idx = (ast_index *)ctx;
+    if (idx->node_count == idx->node_capacity && !ast_index_grow(idx))
+        return false;
+    idx->node_count++;
+    idx->nodes[preorder] = node.value;
+    idx->kinds[preorder] = nodetype != NULL ? ast_index_kind(idx, nodetype, true) : -1;
+    idx->subtree_size[preorder] = 1;
+    return true;
+}
+
+static void ast_index_close(json_value node, json_index preorder, json_index subtree_size, void *ctx)
+{
+    (void)node;
+    ast_index *idx = (ast_index *)ctx;
+    if (preorder < idx->node_count)
+        idx->subtree_size[preorder] = subtree_size;
+}
+
+void ast_index_free(ast_index *idx)
+{
+    for (int32_t k = 0; k < idx->kind_count; k++)
+    {
+        free(idx->kind_names[k]);
+        free(idx->prefix[k]);
+    }
+    free(idx->kind_names);
+    free(idx->prefix);
+    free(idx->nodes);
+    free(idx->subtree_size);
+    free(idx->kinds);
+    free(idx->map_keys);
+    free(idx->map_values);
+    memset(idx, 0x00, sizeof(ast_index));
+}
+
+bool ast_index_build(ast_index *idx, json_value root)
+{
+    memset(idx, 0x00, sizeof(ast_index));
+    json_index visited = ast_walk(root, ast_index_label, ast_index_close, idx);
+    if (visited < 0 || visited != idx->node_count)
+    {
+        ast_index_free(idx);
+        return false;
+    }
+    // 노드 포인터 -> preorder 맵 (부하율 50% 이하)
+    idx->map_capacity = 16;
+    while (idx->map_capacity < (size_t)idx->node_count * 2)
+        idx->map_capacity *= 2;
+    idx->map_keys = (const void **)calloc(idx->map_capacity, sizeof(void *));
+    idx->map_values = (json_index *)malloc(sizeof(json_index) * idx->map_capacity);
+    if (idx->map_keys == NULL || idx->map_values == NULL)
+    {
+        ast_index_free(idx);
+        return false;
+    }
+    for (json_index pre = 0; pre < idx->node_count; pre++)
+    {
+        size_t slot = ast_index_hash(idx->nodes[pre], idx->map_capacity);
+        while (idx->map_keys[slot] != NULL && idx->map_keys[slot] != idx->nodes[pre])
+            slot = (slot + 1) & (idx->map_capacity - 1);
+        if (idx->map_keys[slot] == NULL)
+        {
+            idx->map_keys[slot] = idx->nodes[pre];
+            idx->map_values[slot] = pre;
+        }
+    }
+    return true;
+}
+
+// 노드의 preorder 번호 (색인되지 않은 노드는 -1)
+json_index ast_index_preorder(const ast_index *idx, json_value node)
+{
+    if ((node.type != JSON_OBJECT && node.type != JSON_ARRAY) || node.value == NULL || idx->map_capacity == 0)
+        return -1;
+    size_t slot = ast_index_hash(node.value, idx->map_capacity);
+    while (idx->map_keys[slot] != NULL)
+    {
+        if (idx->map_keys[slot] == node.value)
+            return idx->map_values[slot];
+        slot = (slot + 1) & (idx->map_capacity - 1);
+    }
+    return -1;
+}
+
+// ancestor가 node의 조상(또는 자신)인지: preorder 구간 포함 검사
+bool ast_index_contains(const ast_index *idx, json_index ancestor, json_index node)
+{
+    return ancestor >= 0 && node >= ancestor && node < ancestor + idx->subtree_size[ancestor];
+}
+
+// 서브트리 [pre, pre + size) 안의 종류 kind_name 노드 수 (자신 포함). 메모리가 부족하면 -1
+int64_t ast_index_count_kind(ast_index *idx, json_index pre, const char *kind_name)
+{
+    int32_t k = ast_index_kind(idx, kind_name, false);
+    if (pre < 0 || k < 0)
+        return 0;
+    // 여러 스레드가 같은 색인에 질의할 수 있으므로 다 만든 배열만 CAS로 게시하고(release),
+    // 읽을 때는 acquire로 읽습니다. 경쟁에서 진 스레드는 자기 배열을 버리고 게시된 배열을 씁니다.
+    json_index *prefix = __atomic_load_n(&idx->prefix[k], __ATOMIC_ACQUIRE);
+    if (prefix == NULL)
+    {
+        json_index *built = (json_index *)malloc(sizeof(json_index) * (size_t)(idx->node_count + 1));
+        if (built == NULL)
+            return -1;
+        built[0] = 0;
+        for (json_index i = 0; i < idx->node_count; i++)
+            built[i + 1] = built[i] + (idx->kinds[i] == k);
+        if (__atomic_compare_exchange_n(&idx->prefix[k], &prefix, built, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            prefix = built;
+        else
+            free(built);
+    }
+    return prefix[pre + idx->subtree_size[pre]] - prefix[pre];
+}
+
+/*
+ * extract_type: AST 노드의 "type" 사슬을 따라가며 타입 정보를 추출하여 문자열로 반환.
+ * 처리 방식:
+ *   - IdentifierType: names 배열의 첫 번째 원소 반환
+ *   - TypeDecl, Typename, FuncDecl: 내부 "type" 필드로 이동
+ *   - PtrDecl: 내부 "type"으로 이동하며 "*"를 하나씩 앞에 붙임 (이 경우 결과는 동적 할당됨)
+ * 만약 올바른 타입 정보를 찾지 못하면 "unknown"을 반환합니다.
+ * 재귀 대신 반복문으로 사슬을 따라가므로 포인터 단계가 깊어도 스택을 쓰지 않습니다.
+ */
+char *extract_type(json_value node)
+{
+    static JSON_THREAD_LOCAL json_inline_cache names_ic, type_ic;
+    size_t stars = 0;
+    char *base = "unknown";
+    while (node.type == JSON_OBJECT && node.value != NULL)
+    {
+        const char *nt = ast_nodetype((json_object *)node.value);
+        if (!nt)
+            break;
+
+        if (strcmp(nt, "IdentifierType") == 0)
+        {
+            json_value names = *ast_get(node, "names", &names_ic);
+            if (names.type == JSON_ARRAY && names.value != NULL)
+            {
+                json_array *names_arr = (json_array *)names.value;
+                if (names_arr->last_index >= 0)
+                {
+                    char *res = get_json_string(&names_arr->values[0]);
+                    if (res)
+                        base = res;
+                }
+            }
+            break;
+        }
+        else if (strcmp(nt, "PtrDecl") == 0)
+            stars++;
+        else if (strcmp(nt, "TypeDecl") != 0 && strcmp(nt, "Typename") != 0 && strcmp(nt, "FuncDecl") != 0)
+            break;
+        node = *ast_get(node, "type", &type_ic);
+    }
+    if (stars == 0)
+        return base;
+
+    size_t len = strlen(base);
+    char *result = malloc(stars + len + 1);
+    if (result)
+    {
+        memset(result, '*', stars);
+        memcpy(result + stars, base, len + 1);
+    }
+    return result;
+}
+
+// --- 함수의 리턴타입 추출 (기존 extract_return_type()를 extract_type()으로 변경) ---
+char *extract_return_type(json_value decl_type)
+{
+    return extract_type(decl_type);
+}
+
+// --- 함수의 파라미터 정보를 추출합니다 ---
+// 함수 선언의 "type" 필드 내 "args" 항목의 "params" 배열을 읽음.
+// 각 파라미터는 { "_nodetype": "Typename", type: { ... } , name: ... } 형태입니다.
+bool extract_params(json_value args_val, function_record *rec)
+{
+    static JSON_THREAD_LOCAL json_inline_cache params_ic, name_ic, type_ic;
+    rec->has_params = false;
+    rec->params = NULL;
+    rec->metrics[METRIC_PARAMS] = 0;
+    if (args_val.type != JSON_OBJECT)
+        return true;
+    json_value params_val = *ast_get(args_val, "params", &params_ic);
+    if (params_val.type != JSON_ARRAY)
+        return true;
+    rec->has_params = true;
+    json_array *params_arr = (json_array *)params_val.value;
+    if (params_arr->last_index < 0)
+        return true;
+    rec->params = (function_param *)malloc(sizeof(function_param) * (size_t)(params_arr->last_index + 1));
+    if (rec->params == NULL)
+        return false;
+    for (json_index i = 0; i <= params_arr->last_index; i++)
+    {
+        json_value param = params_arr->values[i];
+        function_param *fp = &rec->params[i];
+        // 파라미터 이름 추출
+        fp->name = get_json_string(ast_get(param, "name", &name_ic));
+        if (!fp->name)
+            fp->name = "anonymous";
+
+        // 파라미터 타입 추출: 파라미터 노드의 "type" 필드를 extract_type()으로 처리
+        fp->type = extract_type(*ast_get(param, "type", &type_ic));
+        if (!fp->type)
+            fp->type = "unknown";
+        rec->metrics[METRIC_PARAMS]++;
+    }
+    return true;
+}
+
+void function_record_release(function_record *rec)
+{
+    for (int64_t i = 0; i < rec->metrics[METRIC_PARAMS]; i++)
+    {
+        if (rec->owned)
+            free(rec->params[i].name);
+        if (rec->owned || rec->params[i].type[0] == '*')
+            free(rec->params[i].type);
+    }
+    free(rec->params);
+    rec->params = NULL;
+    rec->metrics[METRIC_PARAMS] = 0;
+    if (rec->owned)
+        free(rec->name);
+    if (rec->owned || rec->return_type[0] == '*')
+        free(rec->return_type); // PtrDecl 처리로 동적할당된 리턴 타입
+    rec->name = rec->return_type = "unknown";
+    rec->owned = false;
+}
+
+// 빌린 문자열을 복사합니다. '*'로 시작하는 타입은 이미 레코드가 소유하므로 그대로 씁니다.
+static char *function_record_own(char *str)
+{
+    return str[0] == '*' ? str : strdup(str);
+}
+
+bool function_record_detach(function_record *rec)
+{
+    if (rec->owned)
+        return true;
+    char *name = strdup(rec->name);
+    char *return_type = function_record_own(rec->return_type);
+    bool ok = name != NULL && return_type != NULL;
+    function_param *copies = NULL;
+    if (ok && rec->metrics[METRIC_PARAMS] > 0)
+    {
+        copies = (function_param *)calloc((size_t)rec->metrics[METRIC_PARAMS], sizeof(function_param));
+        ok = copies != NULL;
+        for (int64_t i = 0; ok && i < rec->metrics[METRIC_PARAMS]; i++)
+        {
+            copies[i].name = strdup(rec->params[i].name);
+            copies[i].type = function_record_own(rec->params[i].type);
+            ok = copies[i].name != NULL && copies[i].type != NULL;
+        }
+    }
+    if (!ok)
+    {
+        // 실패하면 복사본만 버리고 레코드는 그대로 둡니다
+        for (int64_t i = 0; copies != NULL && i < rec->metrics[METRIC_PARAMS]; i++)
+        {
+            free(copies[i].name);
+            if (copies[i].type != rec->params[i].type)
+                free(copies[i].type);
+        }
+        free(copies);
+        free(name);
+        if (return_type != rec->return_type)
+            free(return_type);
+        return false;
+    }
+    if (copies != NULL)
+    {
+        free(rec->params);
+        rec->params = copies;
+    }
+    rec->name = name;
+    rec->return_type = return_type;
+    rec->owned = true;
+    return true;
+}
+
+// --- 함수 노드를 분석하여 함수명, 리턴타입, 파라미터 정보, 메트릭을 rec에 채웁니다 ---
+// 함수 노드는 두 가지 유형: 함수 정의(FuncDef)와 함수 선언(Decl) 중 내부 type._nodetype가 FuncDecl인 경우.
+// index가 주어지면 if 개수를 prefix 합 차이로 구하고, 없으면 본문을 (jobs > 1이면 병렬로) 순회합니다.
+bool analyze_function(json_value func_node, ast_index *index, int jobs, function_record *rec)
+{
+    static JSON_THREAD_LOCAL json_inline_cache nodetype_ic, decl_ic, name_ic, type_ic, args_ic, body_ic;
+    memset(rec->metrics, 0x00, sizeof(rec->metrics));
+    rec->owned = false;
+    rec->params = NULL;
+
+    json_value decl;
+    char *nodetype = get_json_string(ast_get(func_node, "_nodetype", &nodetype_ic));
+    rec->is_definition = nodetype && strcmp(nodetype, "FuncDef") == 0;
+    if (rec->is_definition)
+        decl = *ast_get(func_node, "decl", &decl_ic); // 함수 정의의 경우
+    else
+        decl = func_node; // 함수 선언의 경우
+
+    // 함수 이름 추출
+    rec->name = get_json_string(ast_get(decl, "name", &name_ic));
+    if (!rec->name)
+        rec->name = "unknown";
+
+    // 함수 리턴 타입 추출 (decl.type 내부)
+    json_value type_val = *ast_get(decl, "type", &type_ic);
+    rec->return_type = extract_return_type(type_val);
+    if (!rec->return_type)
+        rec->return_type = "unknown";
+
+    // 함수 파라미터 추출 (decl.type.args)
+    if (!extract_params(*ast_get(type_val, "args", &args_ic), rec))
+    {
+        function_record_release(rec);
+        return false;
+    }
+
+    // 함수 본문 메트릭 (함수 정의인 경우)
+    if (rec->is_definition)
+    {
+        json_value body_val = *ast_get(func_node, "body", &body_ic);
+        if (index != NULL)
+        {
+            json_index pre = ast_index_preorder(index, body_val);
+            rec->metrics[METRIC_IFS] = ast_index_count_kind(index, pre, "If");
+            if (rec->metrics[METRIC_IFS] < 0)
+            {
+                function_record_release(rec);
+                return false;
+            }
+            rec->metrics[METRIC_NODES] = pre >= 0 ? index->subtree_size[pre] : 0;
+        }
+        else
+        {
+            ast_metrics m = ast_collect_metrics(body_val, jobs, NULL);
+            rec->metrics[METRIC_IFS] = m.if_count;
+            rec->metrics[METRIC_NODES] = m.node_count;
+        }
+    }
+    return true;
+}
+
+// --- ext의 함수 노드에서 이름만 꺼냅니다 (본문은 건드리지 않음) ---
+const char *function_node_name(json_value func_node, bool is_definition)
+{
+    static JSON_THREAD_LOCAL json_inline_cache decl_ic, name_ic;
+    json_value decl = is_definition ? *ast_get(func_node, "decl", &decl_ic) : func_node;
+    const char *name = get_json_string(ast_get(decl, "name", &name_ic));
+    return name ? name : "unknown";
+}
+
+// --- ext 원소가 함수 노드인지 판별합니다 ---
+// 함수 정의(FuncDef)이거나, 내부 type._nodetype가 FuncDecl인 Decl(함수 선언)이면 true
+bool ast_is_function_node(json_value node, bool *is_definition)
+{
+    static JSON_THREAD_LOCAL json_inline_cache type_ic;
+    if (node.type != JSON_OBJECT || node.value == NULL)
+        return false;
+    const char *nodetype = ast_nodetype((json_object *)node.value);
+    if (nodetype == NULL)
+        return false;
+    *is_definition = strcmp(nodetype, "FuncDef") == 0;
+    if (*is_definition)
+        return true;
+    if (strcmp(nodetype, "Decl") != 0)
+        return false;
+    json_value type_val = *ast_get(node, "type", &type_ic);
+    if (type_val.type != JSON_OBJECT || type_val.value == NULL)
+        return false;
+    const char *decl_type = ast_nodetype((json_object *)type_val.value);
+    return decl_type != NULL && strcmp(decl_type, "FuncDecl") == 0;
+}
+
+void analyzer_results_init(analyzer_results *results)
+{
+    memset(results, 0x00, sizeof(analyzer_results));
+    results->jobs = 1;
+}
+
+void analyzer_results_free(analyzer_results *results)
+{
+    for (json_index i = 0; i < results->count; i++)
+        function_record_release(&results->functions[i]);
+    free(results->functions);
+    results->functions = NULL;
+    results->count = results->capacity = 0;
+    results->definitions = results->declarations = results->if_total = 0;
+}
+
+// 모든 레코드가 문자열을 소유하도록 복사합니다. 이후에는 문서를 해제해도 결과를 쓸 수 있습니다.
+bool analyzer_results_detach(analyzer_results *results)
+{
+    for (json_index i = 0; i < results->count; i++)
+        if (!function_record_detach(&results->functions[i]))
+            return false;
+    return true;
+}
+
+// --- 문서(FileAST)의 ext에 있는 모든 함수 정의/선언을 분석해 results에 덧붙입니다 ---
+// 출력은 하지 않습니다. 성공하면 0, 문서 형식이 맞지 않거나 메모리가 부족하면 1을 돌려줍니다.
+int analyze_document(const json_value *doc, analyzer_results *results)
+{
+    if (doc->type != JSON_OBJECT || doc->value == NULL)
+        return 1;
+    // 없는 키를 찾을 때 json_get()이 남기는 오류 메시지를 피하려고 직접 찾습니다
+    const json_object *root = (const json_object *)doc->value;
+    const json_array *ext_arr = NULL;
+    for (json_index k = 0; k <= root->last_index; k++)
+        if (strcmp(root->keys[k], "ext") == 0 && root->values[k].type == JSON_ARRAY)
+            ext_arr = (const json_array *)root->values[k].value;
+    if (ext_arr == NULL)
+        return 1;
+
+    for (json_index i = 0; i <= ext_arr->last_index; i++)
+    {
+        bool is_definition;
+        if (!ast_is_function_node(ext_arr->values[i], &is_definition))
+            continue;
+        if (results->count == results->capacity)
+        {
+            json_index capacity = results->capacity ? results->capacity * 2 : 64;
+            function_record *functions =
+                (function_record *)realloc(results->functions, sizeof(function_record) * (size_t)capacity);
+            if (functions == NULL)
+                return 1;
+            results->functions = functions;
+            results->capacity = capacity;
+        }
+        function_record *rec = &results->functions[results->count];
+        if (!analyze_function(ext_arr->values[i], results->index, results->jobs, rec))
+            return 1;
+        rec->sequence = results->count++;
+        if (rec->is_definition)
+        {
+            results->definitions++;
+            results->if_total += rec->metrics[METRIC_IFS];
+        }
+        else
+            results->declarations++;
+    }
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
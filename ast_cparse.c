@@ -0,0 +1,2101 @@
+#ifndef __AST_CPARSE_HEADER__
+#define __AST_CPARSE_HEADER__
+
+/*
+ * ast_cparse.c
+ *
+ * 전처리된 C 소스를 pycparser와 같은 AST 문서(json_value)로 바로 파싱합니다.
+ * C 소스 → pycparser → 들여쓴 JSON 텍스트 → json_parser_parse() 단계를 거치지 않고,
+ * 토큰화와 재귀 하강 파싱으로 노드를 json_parser의 arena에 곧바로 만듭니다 (json_parser_open/append/close).
+ *
+ * 결과 문서는 pycparser(2.x)와 ast2c_convert.py의 JSON 변환이 만드는 것과 같은 모양입니다.
+ *   - 노드 종류와 멤버 이름, 키 순서(사전순), 빈 자식 목록은 null
+ *   - coord는 "파일:줄:열" (line marker "# 12 \"a.c\""를 따름). pycparser처럼 중괄호로 시작하는
+ *     노드(Compound, 이름 없는 struct, 빈 InitList)는 열이 1이고, Typename은 "파일:0:1"입니다
+ *   - switch 본문의 case/default 아래로 뒤따르는 문장을 모으는 변환(fix_switch_cases)도 같게 적용합니다
+ * 그래서 JSON을 거친 문서와 분석 결과가 같습니다.
+ *
+ * 다루는 범위는 pycparser가 받아들이는 C99입니다 (GNU 확장인 __attribute__, asm 등은 구문 오류).
+ * _Alignas와 _Atomic(type) 지정자는 지원하지 않습니다.
+ * #pragma 등 line marker가 아닌 지시문과 주석은 건너뜁니다 (Pragma 노드를 만들지 않음).
+ *
+ * 사용 예:
+ *   json_parser parser;
+ *   json_parser_init(&parser);
+ *   json_value ast = ast_cparse(&parser, source, "target.c");
+ *   if (ast.type != JSON_UNDEFINED) ...   // 문서는 다음 파싱 전까지 parser가 소유
+ */
+
+#include "json_c.c"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+// source를 파싱하여 FileAST 노드를 돌려줍니다. 구문 오류면 위치를 stderr에 출력하고 JSON_UNDEFINED
+// (json_parser_parse()처럼 parser의 이전 문서는 재활용되고, source는 파싱하는 동안만 살아 있으면 됩니다)
+json_value ast_cparse(json_parser *parser, const char *source, const char *filename);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#ifndef __AST_CPARSE_BODY__
+#define __AST_CPARSE_BODY__
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#define CPARSE_MAX_SPECIFIERS 16
+
+/*
+ * 토큰
+ * 키워드는 종류별 비트(cparse_keyword)로 분류해 둡니다. 텍스트는 source를 가리킵니다.
+ */
+typedef enum cparse_token_kind_enum
+{
+    CTOK_EOF = 0,
+    CTOK_ID,      // 식별자와 키워드
+    CTOK_INT,     // 정수 상수 (여러 글자 문자 상수 'ab' 포함)
+    CTOK_FLOAT,
+    CTOK_CHAR,
+    CTOK_STRING,
+    CTOK_WSTRING, // L"", u"", U"", u8""
+    CTOK_PUNCT
+} cparse_token_kind;
+
+typedef enum cparse_keyword_enum
+{
+    CKW_NONE = 0,
+    CKW_TYPE = 0x1,     // void, int, unsigned ...
+    CKW_STORAGE = 0x2,  // static, extern, typedef ...
+    CKW_QUAL = 0x4,     // const, volatile, restrict, _Atomic
+    CKW_FUNCSPEC = 0x8, // inline, _Noreturn
+    CKW_TAG = 0x10,     // struct, union, enum
+    CKW_OTHER = 0x20    // 문장 키워드, sizeof 등
+} cparse_keyword;
+
+typedef struct cparse_token_s
+{
+    cparse_token_kind kind;
+    int keyword;
+    const char *text;
+    size_t length;
+    int line;
+    int column;
+    const char *file; // 좌표의 파일 이름 (line marker가 바꿉니다)
+    size_t file_length;
+} cparse_token;
+
+static const struct
+{
+    const char *word;
+    size_t length;
+    int keyword;
+} cparse_keywords[] = {
+    {"void", 4, CKW_TYPE}, {"char", 4, CKW_TYPE}, {"short", 5, CKW_TYPE}, {"int", 3, CKW_TYPE}, {"long", 4, CKW_TYPE},
+    {"float", 5, CKW_TYPE}, {"double", 6, CKW_TYPE}, {"signed", 6, CKW_TYPE}, {"unsigned", 8, CKW_TYPE}, {"_Bool", 5, CKW_TYPE},
+    {"_Complex", 8, CKW_TYPE}, {"__int128", 8, CKW_TYPE},
+    {"auto", 4, CKW_STORAGE}, {"register", 8, CKW_STORAGE}, {"static", 6, CKW_STORAGE}, {"extern", 6, CKW_STORAGE},
+    {"typedef", 7, CKW_STORAGE}, {"_Thread_local", 13, CKW_STORAGE},
+    {"const", 5, CKW_QUAL}, {"restrict", 8, CKW_QUAL}, {"volatile", 8, CKW_QUAL}, {"_Atomic", 7, CKW_QUAL},
+    {"inline", 6, CKW_FUNCSPEC}, {"_Noreturn", 9, CKW_FUNCSPEC},
+    {"struct", 6, CKW_TAG}, {"union", 5, CKW_TAG}, {"enum", 4, CKW_TAG},
+    {"if", 2, CKW_OTHER}, {"else", 4, CKW_OTHER}, {"while", 5, CKW_OTHER}, {"do", 2, CKW_OTHER}, {"for", 3, CKW_OTHER},
+    {"switch", 6, CKW_OTHER}, {"case", 4, CKW_OTHER}, {"default", 7, CKW_OTHER}, {"break", 5, CKW_OTHER},
+    {"continue", 8, CKW_OTHER}, {"return", 6, CKW_OTHER}, {"goto", 4, CKW_OTHER}, {"sizeof", 6, CKW_OTHER},
+    {"_Alignof", 8, CKW_OTHER}, {"_Alignas", 8, CKW_OTHER}, {"_Static_assert", 14, CKW_OTHER}, {"offsetof", 8, CKW_OTHER},
+};
+
+// 긴 것부터 비교해야 가장 긴 연산자가 선택됩니다
+static const char *const cparse_puncts[] = {
+    "...", "<<=", ">>=", "->", "++", "--", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||",
+    "*=", "/=", "%=", "+=", "-=", "&=", "^=", "|=",
+    "+", "-", "*", "/", "%", "&", "|", "^", "!", "~", "<", ">", "=", "?", ":", ";", ",", ".",
+    "(", ")", "[", "]", "{", "}",
+};
+
+/*
+ * 선언자
+ * pycparser처럼 선언자를 먼저 PtrDecl/ArrayDecl/FuncDecl 사슬로 만들고(_type_modify_decl), 선언 지정자를 다 읽은 뒤
+ * 맨 안쪽 TypeDecl에 기본 타입을 붙여 노드로 내립니다. 사슬은 풀의 인덱스로 연결합니다.
+ */
+typedef enum cparse_declarator_kind_enum
+{
+    CDECL_TYPE = 0, // TypeDecl (name이 NULL이면 추상 선언자의 빈 TypeDecl)
+    CDECL_PTR,
+    CDECL_ARRAY,
+    CDECL_FUNC
+} cparse_declarator_kind;
+
+typedef struct cparse_chain_s
+{
+    cparse_declarator_kind kind;
+    int64_t type; // 안쪽 선언자 (-1이면 없음)
+    json_value coord;
+    const cparse_token *name;
+    json_value quals; // PtrDecl quals, ArrayDecl dim_quals
+    json_value dim;   // ArrayDecl
+    json_value args;  // FuncDecl: ParamList 또는 null
+} cparse_chain;
+
+// 선언자 종류: 이름이 꼭 있어야 하는 선언, 이름 없는 타입(형 변환, sizeof), 둘 다 되는 파라미터
+typedef enum cparse_declarator_mode_enum
+{
+    CPARSE_NAMED = 0,
+    CPARSE_ABSTRACT,
+    CPARSE_EITHER
+} cparse_declarator_mode;
+
+// 선언 지정자 (pycparser의 spec 사전)
+typedef struct cparse_spec_s
+{
+    const cparse_token *qual[CPARSE_MAX_SPECIFIERS];
+    const cparse_token *storage[CPARSE_MAX_SPECIFIERS];
+    const cparse_token *funcspec[CPARSE_MAX_SPECIFIERS];
+    const cparse_token *type[CPARSE_MAX_SPECIFIERS]; // IdentifierType으로 모일 이름들
+    int qual_count;
+    int storage_count;
+    int funcspec_count;
+    int type_count;
+    json_value tagged; // struct/union/enum 노드 (없으면 JSON_UNDEFINED)
+} cparse_spec;
+
+/*
+ * typedef 이름 스코프
+ * 식별자가 타입 이름인지는 가장 안쪽 선언이 정합니다. 이름마다 해시 슬롯이 가장 최근 항목을 가리키고,
+ * 항목은 같은 이름의 바깥 항목(prev)을 가리키므로 스코프를 닫을 때 되돌리기만 하면 됩니다.
+ * 일반 식별자는 같은 이름의 typedef가 있을 때만(가릴 수 있을 때만) 기록합니다.
+ */
+typedef struct cparse_symbol_s
+{
+    size_t slot;
+    int64_t prev;
+    bool is_type;
+} cparse_symbol;
+
+typedef struct cparse_slot_s
+{
+    const char *name; // NULL이면 빈 슬롯
+    size_t length;
+    int64_t top; // 가장 최근 항목 (-1이면 현재 스코프들에 없음)
+} cparse_slot;
+
+typedef struct cparse_s
+{
+    json_parser *json;
+    const char *filename;
+    cparse_token *tokens;
+    size_t count;
+    size_t capacity;
+    size_t pos;
+    cparse_chain *decls;
+    size_t decl_count;
+    size_t decl_capacity;
+    cparse_symbol *symbols;
+    size_t symbol_count;
+    size_t symbol_capacity;
+    cparse_slot *slots;
+    size_t slot_count;
+    size_t slot_capacity;
+    char *text; // 좌표 문자열과 이어 붙인 문자열 상수를 만드는 작업 버퍼
+    size_t text_capacity;
+    json_value last_params; // 마지막으로 읽은 함수 선언자의 ParamList (함수 본문 스코프에 등록)
+    bool failed;
+} cparse;
+
+static const json_value cparse_null = {JSON_NULL, NULL};
+static const json_value cparse_undefined = {JSON_UNDEFINED, NULL};
+
+// --- 토큰화 ---
+
+static bool cparse_add_token(cparse *cp, cparse_token_kind kind, const char *text, size_t length, int line,
+                             const char *line_start, const char *file, size_t file_length)
+{
+    if (cp->count == cp->capacity)
+    {
+        size_t capacity = cp->capacity ? cp->capacity * 2 : 1024;
+        cparse_token *tokens = (cparse_token *)realloc(cp->tokens, sizeof(cparse_token) * capacity);
+        if (tokens == NULL)
+        {
+            fprintf(stderr, "ast_cparse: 메모리 할당 에러\n");
+            return false;
+        }
+        cp->tokens = tokens;
+        cp->capacity = capacity;
+    }
+    cparse_token *t = &cp->tokens[cp->count++];
+    t->kind = kind;
+    t->keyword = CKW_NONE;
+    t->text = text;
+    t->length = length;
+    t->line = line;
+    t->column = (int)(text - line_start) + 1;
+    t->file = file;
+    t->file_length = file_length;
+    if (kind == CTOK_ID)
+    {
+        for (size_t i = 0; i < sizeof(cparse_keywords) / sizeof(cparse_keywords[0]); i++)
+        {
+            if (cparse_keywords[i].length == length && cparse_keywords[i].word[0] == text[0] &&
+                memcmp(cparse_keywords[i].word, text, length) == 0)
+            {
+                t->keyword = cparse_keywords[i].keyword;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+static bool cparse_is_ident_char(char c)
+{
+    return isalnum((unsigned char)c) || c == '_' || c == '$';
+}
+
+// 따옴표로 둘러싼 문자/문자열 상수의 끝(닫는 따옴표 다음)을 찾습니다. 줄이 끝나면 NULL
+static const char *cparse_scan_quoted(const char *s, char quote, int *chars)
+{
+    *chars = 0;
+    for (s++; *s != quote; s++)
+    {
+        if (*s == '\0' || *s == '\n')
+            return NULL;
+        if (*s == '\\' && s[1] != '\0' && s[1] != '\n')
+        {
+            // 이스케이프 하나가 한 글자: \x41, \101
+            s++;
+            if (*s == 'x')
+                while (isxdigit((unsigned char)s[1]))
+                    s++;
+            else
+                for (int i = 0; i < 2 && *s >= '0' && *s <= '7' && s[1] >= '0' && s[1] <= '7'; i++)
+                    s++;
+        }
+        (*chars)++;
+    }
+    return s + 1;
+}
+
+static bool cparse_tokenize(cparse *cp, const char *source)
+{
+    const char *s = source;
+    const char *line_start = source;
+    int line = 1;
+    const char *file = cp->filename;
+    size_t file_length = strlen(cp->filename);
+    while (true)
+    {
+        char c = *s;
+        if (c == '\0')
+            return cparse_add_token(cp, CTOK_EOF, s, 0, line, line_start, file, file_length);
+        if (c == '\n')
+        {
+            line++;
+            line_start = ++s;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f')
+        {
+            s++;
+            continue;
+        }
+        if (c == '/' && s[1] == '*')
+        {
+            for (s += 2; *s != '\0' && !(s[0] == '*' && s[1] == '/'); s++)
+                if (*s == '\n')
+                {
+                    line++;
+                    line_start = s + 1;
+                }
+            s += *s ? 2 : 0;
+            continue;
+        }
+        if (c == '/' && s[1] == '/')
+        {
+            while (*s != '\0' && *s != '\n')
+                s++;
+            continue;
+        }
+        if (c == '#')
+        {
+            // line marker: "# 12 "file.c" 1" 또는 "#line 12 "file.c"" → 다음 줄이 12번 줄
+            const char *p = s + 1;
+            while (*p == ' ' || *p == '\t')
+                p++;
+            if (strncmp(p, "line", 4) == 0 && !cparse_is_ident_char(p[4]))
+                for (p += 4; *p == ' ' || *p == '\t'; p++)
+                    ;
+            int next_line = -1;
+            if (isdigit((unsigned char)*p))
+            {
+                next_line = atoi(p);
+                while (isdigit((unsigned char)*p))
+                    p++;
+                while (*p == ' ' || *p == '\t')
+                    p++;
+                if (*p == '\"')
+                {
+                    const char *end = strchr(p + 1, '\"');
+                    const char *eol = strchr(p + 1, '\n');
+                    if (end != NULL && (eol == NULL || end < eol))
+                    {
+                        file = p + 1;
+                        file_length = (size_t)(end - file);
+                    }
+                }
+            }
+            // 지시문 줄은 통째로 건너뜁니다 (#pragma 등 line marker가 아닌 지시문 포함)
+            while (*s != '\0' && *s != '\n')
+                s++;
+            if (next_line >= 0 && *s == '\n')
+            {
+                line = next_line;
+                line_start = ++s;
+            }
+            continue;
+        }
+
+        const char *start = s;
+        cparse_token_kind kind;
+        if (isalpha((unsigned char)c) || c == '_' || c == '$')
+        {
+            while (cparse_is_ident_char(*s))
+                s++;
+            // L'x', u"..." 처럼 접두사가 붙은 문자/문자열 상수
+            size_t n = (size_t)(s - start);
+            bool prefix = (n == 1 && (c == 'L' || c == 'u' || c == 'U')) || (n == 2 && c == 'u' && start[1] == '8');
+            if (prefix && (*s == '\'' || *s == '\"'))
+            {
+                int chars;
+                const char *end = cparse_scan_quoted(s, *s, &chars);
+                if (end == NULL)
+                    goto bad_token;
+                kind = *s == '\'' ? CTOK_CHAR : CTOK_WSTRING;
+                s = end;
+            }
+            else
+                kind = CTOK_ID;
+        }
+        else if (isdigit((unsigned char)c) || (c == '.' && isdigit((unsigned char)s[1])))
+        {
+            // pp-number: 숫자, 문자, '.', 지수 부호까지 한 덩어리
+            bool hex = c == '0' && (s[1] == 'x' || s[1] == 'X');
+            bool is_float = false;
+            while (cparse_is_ident_char(*s) || *s == '.' ||
+                   ((*s == '+' || *s == '-') && (hex ? (s[-1] == 'p' || s[-1] == 'P') : (s[-1] == 'e' || s[-1] == 'E'))))
+            {
+                if (*s == '.' || (hex ? (*s == 'p' || *s == 'P') : (*s == 'e' || *s == 'E')))
+                    is_float = true;
+                s++;
+            }
+            kind = is_float ? CTOK_FLOAT : CTOK_INT;
+        }
+        else if (c == '\'' || c == '\"')
+        {
+            int chars;
+            const char *end = cparse_scan_quoted(s, c, &chars);
+            if (end == NULL)
+                goto bad_token;
+            // 두 글자 이상의 문자 상수('ab')는 pycparser에서 정수 상수입니다
+            kind = c == '\"' ? CTOK_STRING : (chars >= 2 && chars <= 4 ? CTOK_INT : CTOK_CHAR);
+            s = end;
+        }
+        else
+        {
+            // 긴 연산자부터 놓인 표에서 첫 글자가 같은 것만 나머지를 비교합니다
+            size_t length = 0;
+            for (size_t i = 0; i < sizeof(cparse_puncts) / sizeof(cparse_puncts[0]) && length == 0; i++)
+            {
+                const char *p = cparse_puncts[i];
+                if (p[0] == c && (p[1] == '\0' || (p[1] == s[1] && (p[2] == '\0' || p[2] == s[2]))))
+                    length = p[1] == '\0' ? 1 : p[2] == '\0' ? 2 : 3;
+            }
+            if (length == 0)
+                goto bad_token;
+            s += length;
+            kind = CTOK_PUNCT;
+        }
+        if (!cparse_add_token(cp, kind, start, (size_t)(s - start), line, line_start, file, file_length))
+            return false;
+        continue;
+
+    bad_token:
+        fprintf(stderr, "%.*s:%d:%d: 잘못된 토큰입니다 ('%c')\n", (int)file_length, file, line, (int)(start - line_start) + 1, *start);
+        return false;
+    }
+}
+
+// --- 토큰 읽기 ---
+// 오류가 난 뒤에는 항상 EOF를 돌려주므로 모든 반복문이 곧바로 끝납니다
+
+static const cparse_token *cparse_peek(const cparse *cp, size_t ahead)
+{
+    if (cp->failed)
+        return &cp->tokens[cp->count - 1];
+    size_t i = cp->pos + ahead;
+    return &cp->tokens[i < cp->count ? i : cp->count - 1];
+}
+
+static const cparse_token *cparse_next(cparse *cp)
+{
+    const cparse_token *t = cparse_peek(cp, 0);
+    if (t->kind != CTOK_EOF)
+        cp->pos++;
+    return t;
+}
+
+static bool cparse_is(const cparse_token *t, const char *text)
+{
+    // 대부분 첫 글자에서 갈리므로 길이 비교보다 먼저 봅니다
+    if (t->text[0] != text[0] || (t->kind != CTOK_ID && t->kind != CTOK_PUNCT))
+        return false;
+    size_t n = strlen(text);
+    return t->length == n && memcmp(t->text, text, n) == 0;
+}
+
+static void cparse_error(cparse *cp, const cparse_token *t, const char *message)
+{
+    if (cp->failed)
+        return;
+    if (t->kind == CTOK_EOF)
+        fprintf(stderr, "%.*s:%d:%d: 구문 오류: %s (입력 끝)\n", (int)t->file_length, t->file, t->line, t->column, message);
+    else
+        fprintf(stderr, "%.*s:%d:%d: 구문 오류: %s ('%.*s' 앞)\n", (int)t->file_length, t->file, t->line, t->column, message,
+                (int)t->length, t->text);
+    cp->failed = true;
+}
+
+static bool cparse_accept(cparse *cp, const char *text)
+{
+    if (!cparse_is(cparse_peek(cp, 0), text))
+        return false;
+    cp->pos++;
+    return true;
+}
+
+static const cparse_token *cparse_expect(cparse *cp, const char *text)
+{
+    const cparse_token *t = cparse_peek(cp, 0);
+    if (cparse_is(t, text))
+    {
+        cp->pos++;
+        return t;
+    }
+    char message[64];
+    snprintf(message, sizeof(message), "'%s'가 필요합니다", text);
+    cparse_error(cp, t, message);
+    return t;
+}
+
+// 키워드가 아닌 식별자
+static bool cparse_is_name(const cparse_token *t)
+{
+    return t->kind == CTOK_ID && t->keyword == CKW_NONE;
+}
+
+// --- 노드 만들기 ---
+
+static void cparse_push(cparse *cp, const char *key, json_value v)
+{
+    if (!cp->failed && !json_parser_append(cp->json, key, v))
+        cp->failed = true;
+}
+
+static json_value cparse_string(cparse *cp, const char *str, size_t length)
+{
+    json_value v = json_parser_string(cp->json, str, length);
+    if (v.type == JSON_UNDEFINED)
+        cp->failed = true;
+    return v;
+}
+
+static json_value cparse_token_string(cparse *cp, const cparse_token *t)
+{
+    return cparse_string(cp, t->text, t->length);
+}
+
+// 작업 버퍼를 size바이트 이상으로 늘립니다
+static bool cparse_reserve(cparse *cp, size_t size)
+{
+    if (size <= cp->text_capacity)
+        return true;
+    char *text = (char *)realloc(cp->text, size);
+    if (text == NULL)
+    {
+        cp->failed = true;
+        return false;
+    }
+    cp->text = text;
+    cp->text_capacity = size;
+    return true;
+}
+
+// ":정수"를 dst에 쓰고 쓴 길이를 돌려줍니다 (노드마다 만드는 좌표라 snprintf를 쓰지 않음)
+static size_t cparse_format_number(char *dst, int value)
+{
+    char digits[16];
+    size_t n = 0;
+    unsigned int v = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do
+    {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    size_t length = 0;
+    dst[length++] = ':';
+    if (value < 0)
+        dst[length++] = '-';
+    while (n > 0)
+        dst[length++] = digits[--n];
+    return length;
+}
+
+static json_value cparse_coord_at(cparse *cp, const cparse_token *t, int line, int column)
+{
+    if (!cparse_reserve(cp, t->file_length + 32))
+        return cparse_undefined;
+    memcpy(cp->text, t->file, t->file_length);
+    size_t length = t->file_length;
+    length += cparse_format_number(cp->text + length, line);
+    length += cparse_format_number(cp->text + length, column);
+    return cparse_string(cp, cp->text, length);
+}
+
+// 토큰의 좌표 "파일:줄:열"
+static json_value cparse_coord(cparse *cp, const cparse_token *t)
+{
+    return cparse_coord_at(cp, t, t->line, t->column);
+}
+
+/*
+ * 중괄호 비단말(brace_open)의 좌표: pycparser는 줄 번호만 옮겨 오므로 열이 항상 1입니다.
+ * 파일 이름은 노드가 만들어질 때(닫는 '}' 다음 토큰을 미리 읽은 뒤) 렉서의 파일이므로,
+ * '}'를 읽은 다음에 불러 다음 토큰의 파일을 씁니다 (헤더 끝의 함수 본문 등 line marker 경계에서 달라짐).
+ */
+static json_value cparse_coord_brace(cparse *cp, const cparse_token *brace)
+{
+    const cparse_token *next = cparse_peek(cp, 0);
+    cparse_token at = *brace;
+    at.file = next->file;
+    at.file_length = next->file_length;
+    return cparse_coord_at(cp, &at, brace->line, 1);
+}
+
+// 위치 정보가 없는 비단말의 좌표 (Typename 등): "파일:0:1"
+static json_value cparse_coord_none(cparse *cp, const cparse_token *t)
+{
+    return cparse_coord_at(cp, t, 0, 1);
+}
+
+// 이미 만든 노드의 coord (pycparser의 p[1].coord)
+static json_value cparse_coord_of(json_value node)
+{
+    if (node.type != JSON_OBJECT || node.value == NULL)
+        return cparse_null;
+    const json_object *obj = (const json_object *)node.value;
+    for (json_index i = 0; i <= obj->last_index; i++)
+        if (strcmp(obj->keys[i], "coord") == 0)
+            return obj->values[i];
+    return cparse_null;
+}
+
+/*
+ * 노드 객체를 만듭니다.
+ * 멤버는 (키, 값) 쌍을 키 이름 순서대로 넘기고 NULL로 끝냅니다. "_nodetype"은 맨 앞에,
+ * "coord"는 사전순 자리에 끼워 넣으므로 pycparser JSON(sort_keys)과 키 순서가 같습니다.
+ */
+static json_value cparse_node(cparse *cp, const char *kind, json_value coord, ...)
+{
+    if (cp->failed)
+        return cparse_undefined;
+    size_t base = json_parser_open(cp->json);
+    cparse_push(cp, "_nodetype", cparse_string(cp, kind, strlen(kind)));
+    bool coord_done = false;
+    va_list ap;
+    va_start(ap, coord);
+    const char *key;
+    while ((key = va_arg(ap, const char *)) != NULL)
+    {
+        json_value v = va_arg(ap, json_value);
+        if (!coord_done && strcmp(key, "coord") > 0)
+        {
+            cparse_push(cp, "coord", coord);
+            coord_done = true;
+        }
+        cparse_push(cp, key, v);
+    }
+    va_end(ap);
+    if (!coord_done)
+        cparse_push(cp, "coord", coord);
+    if (cp->failed)
+        return cparse_undefined;
+    json_value v = json_parser_close(cp->json, JSON_OBJECT, base);
+    if (v.type == JSON_UNDEFINED)
+        cp->failed = true;
+    return v;
+}
+
+// base 이후에 쌓인 자식들을 배열로 닫습니다. 자식 목록이 비면 pycparser JSON처럼 null
+static json_value cparse_list(cparse *cp, size_t base)
+{
+    if (cp->failed)
+        return cparse_undefined;
+    if (json_parser_open(cp->json) == base)
+        return cparse_null;
+    json_value v = json_parser_close(cp->json, JSON_ARRAY, base);
+    if (v.type == JSON_UNDEFINED)
+        cp->failed = true;
+    return v;
+}
+
+// quals, storage 같은 문자열 목록 (비어 있어도 [])
+static json_value cparse_words(cparse *cp, const cparse_token *const *words, int count)
+{
+    if (cp->failed)
+        return cparse_undefined;
+    size_t base = json_parser_open(cp->json);
+    for (int i = 0; i < count; i++)
+        cparse_push(cp, NULL, cparse_token_string(cp, words[i]));
+    if (cp->failed)
+        return cparse_undefined;
+    return json_parser_close(cp->json, JSON_ARRAY, base);
+}
+
+static json_value cparse_id(cparse *cp, const cparse_token *t)
+{
+    return cparse_node(cp, "ID", cparse_coord(cp, t), "name", cparse_token_string(cp, t), NULL);
+}
+
+// --- typedef 이름 스코프 ---
+
+static cparse_slot *cparse_find_slot(cparse *cp, const char *name, size_t length, bool insert)
+{
+    if (insert && (cp->slot_count + 1) * 2 > cp->slot_capacity)
+    {
+        size_t capacity = cp->slot_capacity ? cp->slot_capacity * 2 : 256;
+        cparse_slot *slots = (cparse_slot *)calloc(capacity, sizeof(cparse_slot));
+        if (slots == NULL)
+        {
+            cp->failed = true;
+            return NULL;
+        }
+        for (size_t i = 0; i < cp->slot_capacity; i++)
+        {
+            if (cp->slots[i].name == NULL)
+                continue;
+            size_t j = json_hash_string(cp->slots[i].name, cp->slots[i].length) & (capacity - 1);
+            while (slots[j].name != NULL)
+                j = (j + 1) & (capacity - 1);
+            slots[j] = cp->slots[i];
+            // 항목들이 가리키는 슬롯 번호를 옮깁니다
+            for (int64_t e = slots[j].top; e >= 0; e = cp->symbols[e].prev)
+                cp->symbols[e].slot = j;
+        }
+        free(cp->slots);
+        cp->slots = slots;
+        cp->slot_capacity = capacity;
+    }
+    if (cp->slot_capacity == 0)
+        return NULL;
+    size_t i = json_hash_string(name, length) & (cp->slot_capacity - 1);
+    while (cp->slots[i].name != NULL)
+    {
+        if (cp->slots[i].length == length && memcmp(cp->slots[i].name, name, length) == 0)
+            return &cp->slots[i];
+        i = (i + 1) & (cp->slot_capacity - 1);
+    }
+    if (!insert)
+        return NULL;
+    cp->slots[i].name = name;
+    cp->slots[i].length = length;
+    cp->slots[i].top = -1;
+    cp->slot_count++;
+    return &cp->slots[i];
+}
+
+static void cparse_declare(cparse *cp, const char *name, size_t length, bool is_type)
+{
+    if (name == NULL || cp->failed)
+        return;
+    cparse_slot *slot = cparse_find_slot(cp, name, length, is_type);
+    if (slot == NULL)
+        return; // 같은 이름의 typedef가 없으면 가릴 것도 없습니다
+    if (cp->symbol_count == cp->symbol_capacity)
+    {
+        size_t capacity = cp->symbol_capacity ? cp->symbol_capacity * 2 : 256;
+        cparse_symbol *symbols = (cparse_symbol *)realloc(cp->symbols, sizeof(cparse_symbol) * capacity);
+        if (symbols == NULL)
+        {
+            cp->failed = true;
+            return;
+        }
+        cp->symbols = symbols;
+        cp->symbol_capacity = capacity;
+    }
+    cparse_symbol *sym = &cp->symbols[cp->symbol_count];
+    sym->slot = (size_t)(slot - cp->slots);
+    sym->prev = slot->top;
+    sym->is_type = is_type;
+    slot->top = (int64_t)cp->symbol_count++;
+}
+
+static void cparse_close_scope(cparse *cp, size_t mark)
+{
+    while (cp->symbol_count > mark)
+    {
+        cparse_symbol *sym = &cp->symbols[--cp->symbol_count];
+        cp->slots[sym->slot].top = sym->prev;
+    }
+}
+
+static bool cparse_is_typedef_name(cparse *cp, const cparse_token *t)
+{
+    if (!cparse_is_name(t) || cp->slot_count == 0)
+        return false;
+    cparse_slot *slot = cparse_find_slot(cp, t->text, t->length, false);
+    return slot != NULL && slot->top >= 0 && cp->symbols[slot->top].is_type;
+}
+
+// 선언 지정자로 시작하는 토큰인지 (선언과 문장, 형 변환과 괄호 식을 가릅니다)
+static bool cparse_is_type_start(cparse *cp, const cparse_token *t)
+{
+    if (t->kind != CTOK_ID)
+        return false;
+    if (t->keyword & (CKW_TYPE | CKW_STORAGE | CKW_QUAL | CKW_FUNCSPEC | CKW_TAG))
+        return true;
+    return cparse_is_typedef_name(cp, t);
+}
+
+// --- 선언자 사슬 ---
+
+static int64_t cparse_new_declarator(cparse *cp, cparse_declarator_kind kind, json_value coord)
+{
+    if (cp->decl_count == cp->decl_capacity)
+    {
+        size_t capacity = cp->decl_capacity ? cp->decl_capacity * 2 : 256;
+        cparse_chain *decls = (cparse_chain *)realloc(cp->decls, sizeof(cparse_chain) * capacity);
+        if (decls == NULL)
+        {
+            cp->failed = true;
+            return -1;
+        }
+        cp->decls = decls;
+        cp->decl_capacity = capacity;
+    }
+    cparse_chain *d = &cp->decls[cp->decl_count];
+    d->kind = kind;
+    d->type = -1;
+    d->coord = coord;
+    d->name = NULL;
+    d->quals = cparse_undefined;
+    d->dim = cparse_null;
+    d->args = cparse_null;
+    return (int64_t)cp->decl_count++;
+}
+
+// pycparser의 _type_modify_decl: modifier 사슬을 decl의 TypeDecl 바로 위에 끼워 넣습니다
+static int64_t cparse_modify(cparse *cp, int64_t decl, int64_t modifier)
+{
+    int64_t tail = modifier;
+    while (cp->decls[tail].type >= 0)
+        tail = cp->decls[tail].type;
+    if (cp->decls[decl].kind == CDECL_TYPE)
+    {
+        cp->decls[tail].type = decl;
+        return modifier;
+    }
+    int64_t decl_tail = decl;
+    while (cp->decls[cp->decls[decl_tail].type].kind != CDECL_TYPE)
+        decl_tail = cp->decls[decl_tail].type;
+    cp->decls[tail].type = cp->decls[decl_tail].type;
+    cp->decls[decl_tail].type = modifier;
+    return decl;
+}
+
+static int64_t cparse_typedecl_of(const cparse *cp, int64_t d)
+{
+    while (d >= 0 && cp->decls[d].kind != CDECL_TYPE)
+        d = cp->decls[d].type;
+    return d;
+}
+
+// 추상 선언자에 쓰이는 이름 없는 TypeDecl (좌표 없음)
+static int64_t cparse_dummy_typedecl(cparse *cp)
+{
+    return cparse_new_declarator(cp, CDECL_TYPE, cparse_null);
+}
+
+static json_value cparse_expression(cparse *cp);
+static json_value cparse_assignment(cparse *cp);
+static json_value cparse_conditional(cparse *cp);
+static json_value cparse_cast(cparse *cp);
+static json_value cparse_initializer(cparse *cp);
+static json_value cparse_statement(cparse *cp);
+static json_value cparse_compound(cparse *cp, json_value params);
+static json_value cparse_type_name(cparse *cp);
+static void cparse_block_item(cparse *cp);
+static void cparse_declaration(cparse *cp, bool external);
+static bool cparse_specifiers(cparse *cp, cparse_spec *spec, bool declaration);
+static int64_t cparse_declarator(cparse *cp, cparse_declarator_mode mode);
+static json_value cparse_decl_node(cparse *cp, const cparse_spec *spec, int64_t d, json_value init, json_value bitsize,
+                                   json_value int_coord);
+static json_value cparse_typename_node(cparse *cp, const cparse_spec *spec, int64_t d);
+
+// pointer : '*' type_qualifier_list_opt pointer_opt  (왼쪽 '*'가 가장 안쪽 PtrDecl)
+static int64_t cparse_pointer(cparse *cp)
+{
+    const cparse_token *star = cparse_next(cp);
+    const cparse_token *quals[CPARSE_MAX_SPECIFIERS];
+    int count = 0;
+    while (cparse_peek(cp, 0)->keyword == CKW_QUAL)
+    {
+        if (count == CPARSE_MAX_SPECIFIERS)
+        {
+            cparse_error(cp, cparse_peek(cp, 0), "한정자가 너무 많습니다");
+            return -1;
+        }
+        quals[count++] = cparse_next(cp);
+    }
+    json_value coord = cparse_coord(cp, star);
+    json_value words = cparse_words(cp, quals, count);
+    int64_t nested = cparse_new_declarator(cp, CDECL_PTR, coord);
+    if (nested < 0)
+        return -1;
+    cp->decls[nested].quals = words;
+    if (!cparse_is(cparse_peek(cp, 0), "*"))
+        return nested;
+    int64_t rest = cparse_pointer(cp);
+    if (rest < 0)
+        return -1;
+    int64_t tail = rest;
+    while (cp->decls[tail].type >= 0)
+        tail = cp->decls[tail].type;
+    cp->decls[tail].type = nested;
+    return rest;
+}
+
+// 파라미터 하나: 이름이 있으면 Decl, 없으면 Typename
+static json_value cparse_parameter(cparse *cp)
+{
+    const cparse_token *at = cparse_peek(cp, 0);
+    cparse_spec spec;
+    if (!cparse_specifiers(cp, &spec, true))
+    {
+        cparse_error(cp, at, "파라미터 선언이 필요합니다");
+        return cparse_undefined;
+    }
+    int64_t d = cparse_declarator(cp, CPARSE_EITHER);
+    if (cp->failed)
+        return cparse_undefined;
+    int64_t type = cparse_typedecl_of(cp, d);
+    if (type >= 0 && cp->decls[type].name != NULL)
+        return cparse_decl_node(cp, &spec, d, cparse_null, cparse_null, cparse_coord_none(cp, at));
+    return cparse_typename_node(cp, &spec, d);
+}
+
+// 함수 선언자의 괄호 안: parameter_type_list 또는 identifier_list (K&R), 비어 있으면 null
+static json_value cparse_parameters(cparse *cp)
+{
+    const cparse_token *t = cparse_peek(cp, 0);
+    if (cparse_is(t, ")"))
+        return cparse_null;
+    size_t base = json_parser_open(cp->json);
+    if (cparse_is_name(t) && !cparse_is_typedef_name(cp, t))
+    {
+        // identifier_list: f(a, b)
+        do
+        {
+            const cparse_token *name = cparse_next(cp);
+            if (!cparse_is_name(name))
+                cparse_error(cp, name, "파라미터 이름이 필요합니다");
+            cparse_push(cp, NULL, cparse_id(cp, name));
+        } while (cparse_accept(cp, ","));
+    }
+    else
+    {
+        do
+        {
+            const cparse_token *at = cparse_peek(cp, 0);
+            if (cparse_is(at, "..."))
+            {
+                cparse_next(cp);
+                cparse_push(cp, NULL, cparse_node(cp, "EllipsisParam", cparse_coord(cp, at), NULL));
+                break;
+            }
+            cparse_push(cp, NULL, cparse_parameter(cp));
+        } while (cparse_accept(cp, ","));
+    }
+    json_value params = cparse_list(cp, base);
+    if (params.type != JSON_ARRAY)
+        return cparse_undefined;
+    json_array *arr = (json_array *)params.value;
+    return cparse_node(cp, "ParamList", cparse_coord_of(arr->values[0]), "params", params, NULL);
+}
+
+// 괄호가 선언자를 묶는지(int (*p)[3]), 추상 함수 선언자의 파라미터인지(int (int)) 구분합니다
+static bool cparse_is_grouping(cparse *cp, cparse_declarator_mode mode)
+{
+    if (mode == CPARSE_NAMED)
+        return true;
+    const cparse_token *t = cparse_peek(cp, 1);
+    if (cparse_is(t, "*") || cparse_is(t, "(") || cparse_is(t, "["))
+        return true;
+    return mode == CPARSE_EITHER && cparse_is_name(t) && !cparse_is_typedef_name(cp, t);
+}
+
+// direct_declarator: 이름 또는 괄호로 묶인 선언자 뒤에 [..], (..)가 이어집니다
+static int64_t cparse_direct_declarator(cparse *cp, cparse_declarator_mode mode)
+{
+    const cparse_token *t = cparse_peek(cp, 0);
+    int64_t head = -1;
+    if (mode != CPARSE_ABSTRACT && cparse_is_name(t))
+    {
+        cparse_next(cp);
+        head = cparse_new_declarator(cp, CDECL_TYPE, cparse_coord(cp, t));
+        if (head < 0)
+            return -1;
+        cp->decls[head].name = t;
+    }
+    else if (cparse_is(t, "(") && cparse_is_grouping(cp, mode))
+    {
+        cparse_next(cp);
+        head = cparse_declarator(cp, mode);
+        cparse_expect(cp, ")");
+        if (head < 0)
+        {
+            cparse_error(cp, t, "선언자가 필요합니다");
+            return -1;
+        }
+    }
+    else if (mode == CPARSE_NAMED)
+    {
+        cparse_error(cp, t, "선언자가 필요합니다");
+        return -1;
+    }
+
+    while (!cp->failed)
+    {
+        const cparse_token *open = cparse_peek(cp, 0);
+        int64_t modifier;
+        if (cparse_is(open, "["))
+        {
+            // [type_qualifier_list_opt static_opt assignment_expression_opt], [*]
+            cparse_next(cp);
+            const cparse_token *quals[CPARSE_MAX_SPECIFIERS];
+            int count = 0;
+            while ((cparse_peek(cp, 0)->keyword == CKW_QUAL || cparse_is(cparse_peek(cp, 0), "static")) &&
+                   count < CPARSE_MAX_SPECIFIERS)
+                quals[count++] = cparse_next(cp);
+            json_value dim = cparse_null;
+            const cparse_token *star = cparse_peek(cp, 0);
+            if (cparse_is(star, "*") && cparse_is(cparse_peek(cp, 1), "]"))
+            {
+                cparse_next(cp);
+                dim = cparse_id(cp, star);
+            }
+            else if (!cparse_is(star, "]"))
+                dim = cparse_assignment(cp);
+            cparse_expect(cp, "]");
+            json_value dim_quals = cparse_words(cp, quals, count);
+            modifier = cparse_new_declarator(cp, CDECL_ARRAY, head >= 0 ? cp->decls[head].coord : cparse_coord(cp, open));
+            if (modifier < 0)
+                return -1;
+            cp->decls[modifier].dim = dim;
+            cp->decls[modifier].quals = dim_quals;
+        }
+        else if (cparse_is(open, "("))
+        {
+            cparse_next(cp);
+            json_value args = cparse_parameters(cp);
+            cparse_expect(cp, ")");
+            // 함수 본문이 이어지면 파라미터 이름을 본문 스코프에 등록합니다
+            if (cparse_is(cparse_peek(cp, 0), "{"))
+                cp->last_params = args;
+            modifier = cparse_new_declarator(cp, CDECL_FUNC, head >= 0 ? cp->decls[head].coord : cparse_coord(cp, open));
+            if (modifier < 0)
+                return -1;
+            cp->decls[modifier].args = args;
+        }
+        else
+            break;
+        if (head < 0)
+        {
+            // 추상 선언자의 맨 앞 [..], (..)는 빈 TypeDecl을 감쌉니다
+            int64_t dummy = cparse_dummy_typedecl(cp);
+            if (dummy < 0)
+                return -1;
+            cp->decls[modifier].type = dummy;
+            head = modifier;
+        }
+        else
+            head = cparse_modify(cp, head, modifier);
+    }
+    return cp->failed ? -1 : head;
+}
+
+// declarator : pointer_opt direct_declarator. 추상 선언자가 비어 있으면 -1
+static int64_t cparse_declarator(cparse *cp, cparse_declarator_mode mode)
+{
+    int64_t pointer = -1;
+    if (cparse_is(cparse_peek(cp, 0), "*"))
+    {
+        pointer = cparse_pointer(cp);
+        if (pointer < 0)
+            return -1;
+    }
+    int64_t head = cparse_direct_declarator(cp, mode);
+    if (pointer < 0 || cp->failed)
+        return head;
+    if (head < 0)
+    {
+        head = cparse_dummy_typedecl(cp);
+        if (head < 0)
+            return -1;
+    }
+    return cparse_modify(cp, head, pointer);
+}
+
+// --- 선언 지정자 ---
+
+static void cparse_spec_add(cparse *cp, const cparse_token **list, int *count, const cparse_token *t)
+{
+    if (*count == CPARSE_MAX_SPECIFIERS)
+    {
+        cparse_error(cp, t, "선언 지정자가 너무 많습니다");
+        return;
+    }
+    list[(*count)++] = t;
+}
+
+static json_value cparse_struct(cparse *cp);
+static json_value cparse_enum(cparse *cp);
+
+// declaration_specifiers (declaration이 false면 specifier_qualifier_list). 하나도 없으면 false
+static bool cparse_specifiers(cparse *cp, cparse_spec *spec, bool declaration)
+{
+    memset(spec, 0x00, sizeof(cparse_spec));
+    spec->tagged = cparse_undefined;
+    bool any = false;
+    while (!cp->failed)
+    {
+        const cparse_token *t = cparse_peek(cp, 0);
+        if (t->kind != CTOK_ID)
+            break;
+        if (t->keyword == CKW_QUAL)
+        {
+            if (cparse_is(t, "_Atomic") && cparse_is(cparse_peek(cp, 1), "("))
+            {
+                cparse_error(cp, t, "_Atomic(type) 지정자는 지원하지 않습니다");
+                break;
+            }
+            cparse_spec_add(cp, spec->qual, &spec->qual_count, cparse_next(cp));
+        }
+        else if (t->keyword == CKW_STORAGE && declaration)
+            cparse_spec_add(cp, spec->storage, &spec->storage_count, cparse_next(cp));
+        else if (t->keyword == CKW_FUNCSPEC && declaration)
+            cparse_spec_add(cp, spec->funcspec, &spec->funcspec_count, cparse_next(cp));
+        else if (t->keyword == CKW_TYPE)
+        {
+            if (spec->tagged.type != JSON_UNDEFINED)
+                cparse_error(cp, t, "타입이 여러 개 지정되었습니다");
+            cparse_spec_add(cp, spec->type, &spec->type_count, cparse_next(cp));
+        }
+        else if (t->keyword == CKW_TAG)
+        {
+            if (spec->tagged.type != JSON_UNDEFINED || spec->type_count > 0)
+                cparse_error(cp, t, "타입이 여러 개 지정되었습니다");
+            spec->tagged = cparse_is(t, "enum") ? cparse_enum(cp) : cparse_struct(cp);
+        }
+        else if (cparse_is(t, "_Alignas"))
+        {
+            cparse_error(cp, t, "_Alignas는 지원하지 않습니다");
+            break;
+        }
+        // typedef 이름은 아직 타입이 없을 때만 타입입니다 (int T;에서 T는 새로 선언하는 이름)
+        else if (spec->type_count == 0 && spec->tagged.type == JSON_UNDEFINED && cparse_is_typedef_name(cp, t))
+            cparse_spec_add(cp, spec->type, &spec->type_count, cparse_next(cp));
+        else
+            break;
+        any = true;
+    }
+    return any;
+}
+
+static bool cparse_spec_is_typedef(const cparse_spec *spec)
+{
+    for (int i = 0; i < spec->storage_count; i++)
+        if (cparse_is(spec->storage[i], "typedef"))
+            return true;
+    return false;
+}
+
+// 기본 타입: struct/union/enum 노드, 또는 타입 이름들을 모은 IdentifierType (없으면 int_coord 좌표의 int)
+static json_value cparse_base_type(cparse *cp, const cparse_spec *spec, json_value int_coord)
+{
+    if (spec->tagged.type != JSON_UNDEFINED)
+        return spec->tagged;
+    if (spec->type_count == 0)
+    {
+        size_t base = json_parser_open(cp->json);
+        cparse_push(cp, NULL, cparse_string(cp, "int", 3));
+        return cparse_node(cp, "IdentifierType", int_coord, "names", cparse_list(cp, base), NULL);
+    }
+    return cparse_node(cp, "IdentifierType", cparse_coord(cp, spec->type[0]), "names",
+                       cparse_words(cp, spec->type, spec->type_count), NULL);
+}
+
+// 선언자 사슬을 노드로 내립니다 (_fix_decl_name_type: 맨 안쪽 TypeDecl이 기본 타입과 한정자를 받음)
+static json_value cparse_lower(cparse *cp, int64_t d, json_value base, const cparse_spec *spec)
+{
+    if (cp->failed)
+        return cparse_undefined;
+    cparse_chain decl = cp->decls[d];
+    if (decl.kind == CDECL_TYPE)
+        return cparse_node(cp, "TypeDecl", decl.coord, "align", cparse_null, "declname",
+                           decl.name != NULL ? cparse_token_string(cp, decl.name) : cparse_null, "quals",
+                           cparse_words(cp, spec->qual, spec->qual_count), "type", base, NULL);
+    json_value type = cparse_lower(cp, decl.type, base, spec);
+    if (decl.kind == CDECL_PTR)
+        return cparse_node(cp, "PtrDecl", decl.coord, "quals", decl.quals, "type", type, NULL);
+    if (decl.kind == CDECL_ARRAY)
+        return cparse_node(cp, "ArrayDecl", decl.coord, "dim", decl.dim, "dim_quals", decl.quals, "type", type, NULL);
+    return cparse_node(cp, "FuncDecl", decl.coord, "args", decl.args, "type", type, NULL);
+}
+
+/*
+ * 선언자 하나의 Decl(또는 typedef면 Typedef) 노드
+ * 타입 지정자가 없으면 함수 선언만 int를 돌려준다고 봅니다. int_coord가 JSON_UNDEFINED면 그 int의 좌표는 선언의 좌표입니다.
+ */
+static json_value cparse_decl_node(cparse *cp, const cparse_spec *spec, int64_t d, json_value init, json_value bitsize,
+                                   json_value int_coord)
+{
+    if (cp->failed)
+        return cparse_undefined;
+    json_value coord = cp->decls[d].coord;
+    if (spec->type_count == 0 && spec->tagged.type == JSON_UNDEFINED && int_coord.type == JSON_UNDEFINED)
+    {
+        if (cp->decls[d].kind != CDECL_FUNC)
+        {
+            cparse_error(cp, cparse_peek(cp, 0), "타입이 없는 선언입니다");
+            return cparse_undefined;
+        }
+        int_coord = coord;
+    }
+    json_value base = cparse_base_type(cp, spec, int_coord);
+    int64_t type_decl = cparse_typedecl_of(cp, d);
+    const cparse_token *name = type_decl >= 0 ? cp->decls[type_decl].name : NULL;
+    json_value name_value = name != NULL ? cparse_token_string(cp, name) : cparse_null;
+    json_value type = cparse_lower(cp, d, base, spec);
+    json_value quals = cparse_words(cp, spec->qual, spec->qual_count);
+    json_value storage = cparse_words(cp, spec->storage, spec->storage_count);
+    if (cparse_spec_is_typedef(spec))
+        return cparse_node(cp, "Typedef", coord, "name", name_value, "quals", quals, "storage", storage, "type", type, NULL);
+    return cparse_node(cp, "Decl", coord, "align", cparse_words(cp, NULL, 0), "bitsize", bitsize, "funcspec",
+                       cparse_words(cp, spec->funcspec, spec->funcspec_count), "init", init, "name", name_value, "quals",
+                       quals, "storage", storage, "type", type, NULL);
+}
+
+// 선언자 없이 struct/union/enum만 선언한 경우 (struct pt { ... };)
+static json_value cparse_tag_decl(cparse *cp, const cparse_spec *spec, const cparse_token *at)
+{
+    if (spec->tagged.type == JSON_UNDEFINED || spec->type_count > 0)
+    {
+        cparse_error(cp, at, "선언자가 필요합니다");
+        return cparse_undefined;
+    }
+    return cparse_node(cp, "Decl", cparse_coord_of(spec->tagged), "align", cparse_words(cp, NULL, 0), "bitsize",
+                       cparse_null, "funcspec", cparse_words(cp, spec->funcspec, spec->funcspec_count), "init",
+                       cparse_null, "name", cparse_null, "quals", cparse_words(cp, spec->qual, spec->qual_count),
+                       "storage", cparse_words(cp, spec->storage, spec->storage_count), "type", spec->tagged, NULL);
+}
+
+// 이름 없는 파라미터나 형 변환의 타입. pycparser처럼 좌표는 "파일:0:1"입니다
+static json_value cparse_typename_node(cparse *cp, const cparse_spec *spec, int64_t d)
+{
+    if (cp->failed)
+        return cparse_undefined;
+    if (d < 0 && (d = cparse_dummy_typedecl(cp)) < 0)
+        return cparse_undefined;
+    const cparse_token *at = cparse_peek(cp, 0);
+    json_value coord = cparse_coord_none(cp, at);
+    json_value type = cparse_lower(cp, d, cparse_base_type(cp, spec, coord), spec);
+    return cparse_node(cp, "Typename", coord, "align", cparse_null, "name", cparse_null, "quals",
+                       cparse_words(cp, spec->qual, spec->qual_count), "type", type, NULL);
+}
+
+// type_name : specifier_qualifier_list abstract_declarator_opt
+static json_value cparse_type_name(cparse *cp)
+{
+    const cparse_token *at = cparse_peek(cp, 0);
+    cparse_spec spec;
+    if (!cparse_specifiers(cp, &spec, false) || (spec.type_count == 0 && spec.tagged.type == JSON_UNDEFINED))
+    {
+        cparse_error(cp, at, "타입 이름이 필요합니다");
+        return cparse_undefined;
+    }
+    int64_t d = cparse_declarator(cp, CPARSE_ABSTRACT);
+    return cparse_typename_node(cp, &spec, d);
+}
+
+// --- struct / union / enum ---
+
+static void cparse_struct_declaration(cparse *cp)
+{
+    const cparse_token *at = cparse_peek(cp, 0);
+    cparse_spec spec;
+    if (!cparse_specifiers(cp, &spec, false))
+    {
+        cparse_error(cp, at, "멤버 선언이 필요합니다");
+        return;
+    }
+    if (cparse_accept(cp, ";"))
+    {
+        cparse_push(cp, NULL, cparse_tag_decl(cp, &spec, at));
+        return;
+    }
+    do
+    {
+        // 이름 없는 비트 필드(int : 3)는 좌표 없는 빈 TypeDecl
+        int64_t d = cparse_is(cparse_peek(cp, 0), ":") ? cparse_dummy_typedecl(cp) : cparse_declarator(cp, CPARSE_NAMED);
+        if (d < 0)
+            return;
+        json_value bitsize = cparse_null;
+        if (cparse_accept(cp, ":"))
+            bitsize = cparse_conditional(cp);
+        cparse_push(cp, NULL, cparse_decl_node(cp, &spec, d, cparse_null, bitsize, cparse_undefined));
+    } while (cparse_accept(cp, ","));
+    cparse_expect(cp, ";");
+}
+
+static json_value cparse_struct(cparse *cp)
+{
+    const cparse_token *keyword = cparse_next(cp);
+    const char *kind = cparse_is(keyword, "struct") ? "Struct" : "Union";
+    const cparse_token *name = NULL;
+    if (cparse_is_name(cparse_peek(cp, 0)))
+        name = cparse_next(cp);
+    json_value name_value = name != NULL ? cparse_token_string(cp, name) : cparse_null;
+    const cparse_token *brace = cparse_peek(cp, 0);
+    if (!cparse_is(brace, "{"))
+    {
+        if (name == NULL)
+        {
+            cparse_error(cp, brace, "struct/union 이름이나 '{'가 필요합니다");
+            return cparse_undefined;
+        }
+        return cparse_node(cp, kind, cparse_coord(cp, name), "decls", cparse_null, "name", name_value, NULL);
+    }
+    cparse_next(cp);
+    // pycparser의 렉서는 모든 중괄호에서 스코프를 엽니다
+    size_t mark = cp->symbol_count;
+    size_t base = json_parser_open(cp->json);
+    while (!cparse_is(cparse_peek(cp, 0), "}") && cparse_peek(cp, 0)->kind != CTOK_EOF)
+    {
+        if (!cparse_accept(cp, ";"))
+            cparse_struct_declaration(cp);
+    }
+    cparse_expect(cp, "}");
+    cparse_close_scope(cp, mark);
+    json_value decls = cparse_list(cp, base);
+    json_value coord = name != NULL ? cparse_coord(cp, name) : cparse_coord_brace(cp, brace);
+    return cparse_node(cp, kind, coord, "decls", decls, "name", name_value, NULL);
+}
+
+static json_value cparse_enum(cparse *cp)
+{
+    const cparse_token *keyword = cparse_next(cp);
+    json_value coord = cparse_coord(cp, keyword);
+    json_value name = cparse_null;
+    if (cparse_is_name(cparse_peek(cp, 0)))
+        name = cparse_token_string(cp, cparse_next(cp));
+    if (!cparse_accept(cp, "{"))
+    {
+        if (name.type == JSON_NULL)
+            cparse_error(cp, cparse_peek(cp, 0), "enum 이름이나 '{'가 필요합니다");
+        return cparse_node(cp, "Enum", coord, "name", name, "values", cparse_null, NULL);
+    }
+    size_t mark = cp->symbol_count;
+    size_t base = json_parser_open(cp->json);
+    do
+    {
+        const cparse_token *t = cparse_peek(cp, 0);
+        if (cparse_is(t, "}"))
+            break;
+        if (!cparse_is_name(t))
+        {
+            cparse_error(cp, t, "열거자 이름이 필요합니다");
+            break;
+        }
+        cparse_next(cp);
+        json_value value = cparse_null;
+        if (cparse_accept(cp, "="))
+            value = cparse_conditional(cp);
+        cparse_push(cp, NULL, cparse_node(cp, "Enumerator", cparse_coord(cp, t), "name", cparse_token_string(cp, t), "value",
+                                          value, NULL));
+        cparse_declare(cp, t->text, t->length, false);
+    } while (cparse_accept(cp, ","));
+    cparse_expect(cp, "}");
+    cparse_close_scope(cp, mark);
+    json_value enumerators = cparse_list(cp, base);
+    if (enumerators.type != JSON_ARRAY)
+    {
+        cparse_error(cp, cparse_peek(cp, 0), "열거자가 필요합니다");
+        return cparse_undefined;
+    }
+    json_value list = cparse_node(cp, "EnumeratorList", cparse_coord_of(((json_array *)enumerators.value)->values[0]),
+                                  "enumerators", enumerators, NULL);
+    return cparse_node(cp, "Enum", coord, "name", name, "values", list, NULL);
+}
+
+// --- 초기화자 ---
+
+// '{' 다음부터 '}'까지. InitList의 좌표는 첫 초기화자의 좌표, 비어 있으면 중괄호 줄
+static json_value cparse_init_list(cparse *cp, const cparse_token *brace)
+{
+    if (cparse_accept(cp, "}"))
+        return cparse_node(cp, "InitList", cparse_coord_brace(cp, brace), "exprs", cparse_null, NULL);
+    size_t base = json_parser_open(cp->json);
+    json_value coord = cparse_undefined;
+    do
+    {
+        if (cparse_is(cparse_peek(cp, 0), "}"))
+            break; // 끝의 쉼표
+        json_value designators = cparse_undefined;
+        if (cparse_is(cparse_peek(cp, 0), "[") || cparse_is(cparse_peek(cp, 0), "."))
+        {
+            size_t names = json_parser_open(cp->json);
+            while (!cp->failed)
+            {
+                if (cparse_accept(cp, "["))
+                {
+                    cparse_push(cp, NULL, cparse_conditional(cp));
+                    cparse_expect(cp, "]");
+                }
+                else if (cparse_accept(cp, "."))
+                {
+                    const cparse_token *field = cparse_next(cp);
+                    if (!cparse_is_name(field))
+                        cparse_error(cp, field, "멤버 이름이 필요합니다");
+                    cparse_push(cp, NULL, cparse_id(cp, field));
+                }
+                else
+                    break;
+            }
+            designators = cparse_list(cp, names);
+            cparse_expect(cp, "=");
+        }
+        json_value init = cparse_initializer(cp);
+        if (coord.type == JSON_UNDEFINED)
+            coord = cparse_coord_of(init);
+        if (designators.type != JSON_UNDEFINED)
+            init = cparse_node(cp, "NamedInitializer", cparse_null, "expr", init, "name", designators, NULL);
+        cparse_push(cp, NULL, init);
+    } while (cparse_accept(cp, ","));
+    cparse_expect(cp, "}");
+    json_value exprs = cparse_list(cp, base);
+    return cparse_node(cp, "InitList", coord, "exprs", exprs, NULL);
+}
+
+static json_value cparse_initializer(cparse *cp)
+{
+    const cparse_token *brace = cparse_peek(cp, 0);
+    if (!cparse_is(brace, "{"))
+        return cparse_assignment(cp);
+    cparse_next(cp);
+    return cparse_init_list(cp, brace);
+}
+
+// --- 식 ---
+
+// 정수 상수의 타입: 끝 세 글자의 u/l 개수 (pycparser와 같은 규칙)
+static json_value cparse_int_constant(cparse *cp, const cparse_token *t)
+{
+    int u = 0, l = 0;
+    for (size_t i = t->length > 3 ? t->length - 3 : 0; i < t->length; i++)
+    {
+        if (t->text[i] == 'u' || t->text[i] == 'U')
+            u++;
+        else if (t->text[i] == 'l' || t->text[i] == 'L')
+            l++;
+    }
+    if (u > 1 || l > 2)
+    {
+        cparse_error(cp, t, "정수 상수의 접미사가 잘못되었습니다");
+        return cparse_undefined;
+    }
+    char type[32] = "";
+    for (int i = 0; i < u; i++)
+        strcat(type, "unsigned ");
+    for (int i = 0; i < l; i++)
+        strcat(type, "long ");
+    strcat(type, "int");
+    return cparse_node(cp, "Constant", cparse_coord(cp, t), "type", cparse_string(cp, type, strlen(type)), "value",
+                       cparse_token_string(cp, t), NULL);
+}
+
+static json_value cparse_float_constant(cparse *cp, const cparse_token *t)
+{
+    const char *type = "double";
+    char last = t->text[t->length - 1];
+    if (memchr(t->text, 'x', t->length) != NULL || memchr(t->text, 'X', t->length) != NULL || last == 'f' || last == 'F')
+        type = "float";
+    else if (last == 'l' || last == 'L')
+        type = "long double";
+    return cparse_node(cp, "Constant", cparse_coord(cp, t), "type", cparse_string(cp, type, strlen(type)), "value",
+                       cparse_token_string(cp, t), NULL);
+}
+
+// 이어진 문자열 상수를 하나로 합칩니다 ("a" "b" → "ab"; 넓은 문자열은 뒤쪽의 접두사까지 떼어 냄)
+static json_value cparse_string_constant(cparse *cp)
+{
+    const cparse_token *first = cparse_next(cp);
+    size_t length = first->length;
+    size_t count = 1;
+    size_t skip = first->kind == CTOK_STRING ? 1 : 2;
+    while (!cp->failed && cparse_peek(cp, count - 1)->kind == first->kind)
+        length += cparse_peek(cp, count++ - 1)->length;
+    if (count == 1)
+        return cparse_node(cp, "Constant", cparse_coord(cp, first), "type", cparse_string(cp, "string", 6), "value",
+                           cparse_token_string(cp, first), NULL);
+    if (!cparse_reserve(cp, length + 1))
+        return cparse_undefined;
+    memcpy(cp->text, first->text, first->length);
+    size_t used = first->length;
+    for (size_t i = 1; i < count; i++)
+    {
+        const cparse_token *t = cparse_next(cp);
+        used--; // 앞 문자열의 닫는 따옴표
+        if (t->length > skip)
+        {
+            memcpy(cp->text + used, t->text + skip, t->length - skip);
+            used += t->length - skip;
+        }
+    }
+    json_value value = cparse_string(cp, cp->text, used);
+    return cparse_node(cp, "Constant", cparse_coord(cp, first), "type", cparse_string(cp, "string", 6), "value", value,
+                       NULL);
+}
+
+// offsetof(type, member.designator[expr])
+static json_value cparse_offsetof(cparse *cp)
+{
+    const cparse_token *keyword = cparse_next(cp);
+    json_value coord = cparse_coord(cp, keyword);
+    cparse_expect(cp, "(");
+    json_value type = cparse_type_name(cp);
+    cparse_expect(cp, ",");
+    const cparse_token *t = cparse_next(cp);
+    if (!cparse_is_name(t))
+        cparse_error(cp, t, "멤버 이름이 필요합니다");
+    json_value member = cparse_id(cp, t);
+    while (!cp->failed)
+    {
+        if (cparse_is(cparse_peek(cp, 0), "."))
+        {
+            const cparse_token *op = cparse_next(cp);
+            const cparse_token *field = cparse_next(cp);
+            if (!cparse_is_name(field))
+                cparse_error(cp, field, "멤버 이름이 필요합니다");
+            member = cparse_node(cp, "StructRef", cparse_coord_of(member), "field", cparse_id(cp, field), "name", member,
+                                 "type", cparse_token_string(cp, op), NULL);
+        }
+        else if (cparse_accept(cp, "["))
+        {
+            json_value subscript = cparse_expression(cp);
+            cparse_expect(cp, "]");
+            member = cparse_node(cp, "ArrayRef", cparse_coord_of(member), "name", member, "subscript", subscript, NULL);
+        }
+        else
+            break;
+    }
+    cparse_expect(cp, ")");
+    size_t base = json_parser_open(cp->json);
+    cparse_push(cp, NULL, type);
+    cparse_push(cp, NULL, member);
+    json_value args = cparse_node(cp, "ExprList", coord, "exprs", cparse_list(cp, base), NULL);
+    json_value name = cparse_node(cp, "ID", coord, "name", cparse_string(cp, "offsetof", 8), NULL);
+    return cparse_node(cp, "FuncCall", coord, "args", args, "name", name, NULL);
+}
+
+static json_value cparse_primary(cparse *cp)
+{
+    const cparse_token *t = cparse_peek(cp, 0);
+    switch (t->kind)
+    {
+    case CTOK_ID:
+        if (cparse_is(t, "offsetof"))
+            return cparse_offsetof(cp);
+        if (!cparse_is_name(t))
+            break;
+        cparse_next(cp);
+        return cparse_id(cp, t);
+    case CTOK_INT:
+        cparse_next(cp);
+        return cparse_int_constant(cp, t);
+    case CTOK_FLOAT:
+        cparse_next(cp);
+        return cparse_float_constant(cp, t);
+    case CTOK_CHAR:
+        cparse_next(cp);
+        return cparse_node(cp, "Constant", cparse_coord(cp, t), "type", cparse_string(cp, "char", 4), "value",
+                           cparse_token_string(cp, t), NULL);
+    case CTOK_STRING:
+    case CTOK_WSTRING:
+        return cparse_string_constant(cp);
+    case CTOK_PUNCT:
+        if (!cparse_is(t, "("))
+            break;
+        cparse_next(cp);
+        json_value v = cparse_expression(cp);
+        cparse_expect(cp, ")");
+        return v;
+    default:
+        break;
+    }
+    cparse_error(cp, t, "식이 필요합니다");
+    return cparse_undefined;
+}
+
+static json_value cparse_postfix(cparse *cp, json_value v)
+{
+    while (!cp->failed)
+    {
+        const cparse_token *t = cparse_peek(cp, 0);
+        if (cparse_is(t, "["))
+        {
+            cparse_next(cp);
+            json_value subscript = cparse_expression(cp);
+            cparse_expect(cp, "]");
+            v = cparse_node(cp, "ArrayRef", cparse_coord_of(v), "name", v, "subscript", subscript, NULL);
+        }
+        else if (cparse_is(t, "("))
+        {
+            cparse_next(cp);
+            json_value args = cparse_null;
+            if (!cparse_is(cparse_peek(cp, 0), ")"))
+            {
+                size_t base = json_parser_open(cp->json);
+                json_value first = cparse_undefined;
+                do
+                {
+                    json_value arg = cparse_assignment(cp);
+                    if (first.type == JSON_UNDEFINED)
+                        first = arg;
+                    cparse_push(cp, NULL, arg);
+                } while (cparse_accept(cp, ","));
+                args = cparse_node(cp, "ExprList", cparse_coord_of(first), "exprs", cparse_list(cp, base), NULL);
+            }
+            cparse_expect(cp, ")");
+            v = cparse_node(cp, "FuncCall", cparse_coord_of(v), "args", args, "name", v, NULL);
+        }
+        else if (cparse_is(t, ".") || cparse_is(t, "->"))
+        {
+            cparse_next(cp);
+            const cparse_token *field = cparse_next(cp);
+            if (!cparse_is_name(field))
+                cparse_error(cp, field, "멤버 이름이 필요합니다");
+            v = cparse_node(cp, "StructRef", cparse_coord_of(v), "field", cparse_id(cp, field), "name", v, "type",
+                            cparse_token_string(cp, t), NULL);
+        }
+        else if (cparse_is(t, "++") || cparse_is(t, "--"))
+        {
+            cparse_next(cp);
+            v = cparse_node(cp, "UnaryOp", cparse_coord_of(v), "expr", v, "op",
+                            cparse_string(cp, cparse_is(t, "++") ? "p++" : "p--", 3), NULL);
+        }
+        else
+            break;
+    }
+    return v;
+}
+
+static json_value cparse_unary(cparse *cp)
+{
+    const cparse_token *t = cparse_peek(cp, 0);
+    if (cparse_is(t, "++") || cparse_is(t, "--"))
+    {
+        cparse_next(cp);
+        json_value expr = cparse_unary(cp);
+        return cparse_node(cp, "UnaryOp", cparse_coord_of(expr), "expr", expr, "op", cparse_token_string(cp, t), NULL);
+    }
+    if (t->kind == CTOK_PUNCT && t->length == 1 && strchr("&*+-~!", t->text[0]) != NULL)
+    {
+        cparse_next(cp);
+        json_value expr = cparse_cast(cp);
+        return cparse_node(cp, "UnaryOp", cparse_coord_of(expr), "expr", expr, "op", cparse_token_string(cp, t), NULL);
+    }
+    if (cparse_is(t, "sizeof") || cparse_is(t, "_Alignof"))
+    {
+        cparse_next(cp);
+        json_value expr;
+        if (cparse_is(cparse_peek(cp, 0), "(") && cparse_is_type_start(cp, cparse_peek(cp, 1)))
+        {
+            cparse_next(cp);
+            expr = cparse_type_name(cp);
+            cparse_expect(cp, ")");
+        }
+        else if (cparse_is(t, "sizeof"))
+            expr = cparse_unary(cp);
+        else
+        {
+            cparse_error(cp, cparse_peek(cp, 0), "타입 이름이 필요합니다");
+            return cparse_undefined;
+        }
+        return cparse_node(cp, "UnaryOp", cparse_coord(cp, t), "expr", expr, "op", cparse_token_string(cp, t), NULL);
+    }
+    return cparse_postfix(cp, cparse_primary(cp));
+}
+
+// cast_expression: (type) cast, (type){ ... } 복합 리터럴, GNU ({ ... }) 문장 식
+static json_value cparse_cast(cparse *cp)
+{
+    const cparse_token *open = cparse_peek(cp, 0);
+    if (cparse_is(open, "(") && cparse_is(cparse_peek(cp, 1), "{"))
+    {
+        cparse_next(cp);
+        json_value body = cparse_compound(cp, cparse_null);
+        cparse_expect(cp, ")");
+        return body;
+    }
+    if (!cparse_is(open, "(") || !cparse_is_type_start(cp, cparse_peek(cp, 1)))
+        return cparse_unary(cp);
+    cparse_next(cp);
+    json_value type = cparse_type_name(cp);
+    cparse_expect(cp, ")");
+    const cparse_token *brace = cparse_peek(cp, 0);
+    if (cparse_is(brace, "{"))
+    {
+        cparse_next(cp);
+        json_value init = cparse_init_list(cp, brace);
+        return cparse_postfix(cp, cparse_node(cp, "CompoundLiteral", cparse_null, "init", init, "type", type, NULL));
+    }
+    json_value expr = cparse_cast(cp);
+    return cparse_node(cp, "Cast", cparse_coord(cp, open), "expr", expr, "to_type", type, NULL);
+}
+
+static int cparse_binary_precedence(const cparse_token *t)
+{
+    static const struct
+    {
+        const char *op;
+        int precedence;
+    } table[] = {
+        {"||", 1}, {"&&", 2}, {"|", 3}, {"^", 4}, {"&", 5}, {"==", 6}, {"!=", 6}, {"<", 7}, {"<=", 7},
+        {">", 7}, {">=", 7}, {"<<", 8}, {">>", 8}, {"+", 9}, {"-", 9}, {"*", 10}, {"/", 10}, {"%", 10},
+    };
+    if (t->kind != CTOK_PUNCT)
+        return 0;
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++)
+        if (cparse_is(t, table[i].op))
+            return table[i].precedence;
+    return 0;
+}
+
+// 이항 연산자는 모두 왼쪽 결합이므로 우선순위 등반으로 파싱합니다
+static json_value cparse_binary(cparse *cp, int min_precedence)
+{
+    json_value left = cparse_cast(cp);
+    while (!cp->failed)
+    {
+        const cparse_token *op = cparse_peek(cp, 0);
+        int precedence = cparse_binary_precedence(op);
+        if (precedence < min_precedence || precedence == 0)
+            break;
+        cparse_next(cp);
+        json_value right = cparse_binary(cp, precedence + 1);
+        left = cparse_node(cp, "BinaryOp", cparse_coord_of(left), "left", left, "op", cparse_token_string(cp, op), "right",
+                           right, NULL);
+    }
+    return left;
+}
+
+static json_value cparse_conditional(cparse *cp)
+{
+    json_value cond = cparse_binary(cp, 1);
+    if (!cparse_accept(cp, "?"))
+        return cond;
+    json_value iftrue = cparse_expression(cp);
+    cparse_expect(cp, ":");
+    json_value iffalse = cparse_conditional(cp);
+    return cparse_node(cp, "TernaryOp", cparse_coord_of(cond), "cond", cond, "iffalse", iffalse, "iftrue", iftrue, NULL);
+}
+
+static bool cparse_is_assignment_op(const cparse_token *t)
+{
+    static const char *const ops[] = {"=", "*=", "/=", "%=", "+=", "-=", "<<=", ">>=", "&=", "^=", "|="};
+    if (t->kind != CTOK_PUNCT)
+        return false;
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+        if (cparse_is(t, ops[i]))
+            return true;
+    return false;
+}
+
+static json_value cparse_assignment(cparse *cp)
+{
+    json_value lvalue = cparse_conditional(cp);
+    const cparse_token *op = cparse_peek(cp, 0);
+    if (!cparse_is_assignment_op(op))
+        return lvalue;
+    cparse_next(cp);
+    json_value rvalue = cparse_assignment(cp);
+    return cparse_node(cp, "Assignment", cparse_coord_of(lvalue), "lvalue", lvalue, "op", cparse_token_string(cp, op),
+                       "rvalue", rvalue, NULL);
+}
+
+static json_value cparse_expression(cparse *cp)
+{
+    json_value first = cparse_assignment(cp);
+    if (!cparse_is(cparse_peek(cp, 0), ","))
+        return first;
+    size_t base = json_parser_open(cp->json);
+    cparse_push(cp, NULL, first);
+    while (cparse_accept(cp, ","))
+        cparse_push(cp, NULL, cparse_assignment(cp));
+    return cparse_node(cp, "ExprList", cparse_coord_of(first), "exprs", cparse_list(cp, base), NULL);
+}
+
+// --- 문장 ---
+
+static json_value cparse_static_assert(cparse *cp)
+{
+    const cparse_token *keyword = cparse_next(cp);
+    cparse_expect(cp, "(");
+    json_value cond = cparse_conditional(cp);
+    json_value message = cparse_null;
+    if (cparse_accept(cp, ","))
+    {
+        if (cparse_peek(cp, 0)->kind != CTOK_STRING)
+            cparse_error(cp, cparse_peek(cp, 0), "문자열 상수가 필요합니다");
+        message = cparse_string_constant(cp);
+    }
+    cparse_expect(cp, ")");
+    return cparse_node(cp, "StaticAssert", cparse_coord(cp, keyword), "cond", cond, "message", message, NULL);
+}
+
+static bool cparse_is_case_label(const cparse_token *t)
+{
+    return cparse_is(t, "case") || cparse_is(t, "default");
+}
+
+// case expr: / default: 머리. Case면 expr, Default면 JSON_UNDEFINED
+static json_value cparse_case_label(cparse *cp)
+{
+    const cparse_token *keyword = cparse_next(cp);
+    json_value expr = cparse_is(keyword, "case") ? cparse_conditional(cp) : cparse_undefined;
+    cparse_expect(cp, ":");
+    return expr;
+}
+
+static json_value cparse_case_node(cparse *cp, const cparse_token *keyword, json_value expr, json_value stmts)
+{
+    if (cparse_is(keyword, "case"))
+        return cparse_node(cp, "Case", cparse_coord(cp, keyword), "expr", expr, "stmts", stmts, NULL);
+    return cparse_node(cp, "Default", cparse_coord(cp, keyword), "stmts", stmts, NULL);
+}
+
+/*
+ * switch 본문 블록 (fix_switch_cases)
+ * 레이블 뒤의 문장들을 다음 case/default 전까지 그 레이블의 stmts로 모읍니다.
+ * 연달아 붙은 레이블(case 1: case 2:)은 앞쪽이 빈 stmts(null)를 가집니다.
+ */
+static json_value cparse_switch_body(cparse *cp)
+{
+    const cparse_token *brace = cparse_next(cp);
+    size_t mark = cp->symbol_count;
+    size_t base = json_parser_open(cp->json);
+    while (!cparse_is(cparse_peek(cp, 0), "}") && cparse_peek(cp, 0)->kind != CTOK_EOF)
+    {
+        const cparse_token *keyword = cparse_peek(cp, 0);
+        if (!cparse_is_case_label(keyword))
+        {
+            cparse_block_item(cp);
+            continue;
+        }
+        json_value expr = cparse_case_label(cp);
+        size_t stmts = json_parser_open(cp->json);
+        if (!cparse_is_case_label(cparse_peek(cp, 0)))
+        {
+            cparse_push(cp, NULL, cparse_statement(cp));
+            while (!cparse_is(cparse_peek(cp, 0), "}") && !cparse_is_case_label(cparse_peek(cp, 0)) &&
+                   cparse_peek(cp, 0)->kind != CTOK_EOF)
+                cparse_block_item(cp);
+        }
+        json_value list = cparse_list(cp, stmts);
+        cparse_push(cp, NULL, cparse_case_node(cp, keyword, expr, list));
+    }
+    cparse_expect(cp, "}");
+    cparse_close_scope(cp, mark);
+    json_value items = cparse_list(cp, base);
+    return cparse_node(cp, "Compound", cparse_coord_brace(cp, brace), "block_items", items, NULL);
+}
+
+static json_value cparse_statement(cparse *cp)
+{
+    const cparse_token *t = cparse_peek(cp, 0);
+    if (cparse_is_case_label(t))
+    {
+        json_value expr = cparse_case_label(cp);
+        size_t base = json_parser_open(cp->json);
+        cparse_push(cp, NULL, cparse_statement(cp));
+        return cparse_case_node(cp, t, expr, cparse_list(cp, base));
+    }
+    if (cparse_is(t, "_Static_assert"))
+        return cparse_static_assert(cp);
+    // 문장 키워드는 먼저 읽고 좌표를 잡아 둡니다
+    json_value coord = cparse_undefined;
+    if (t->kind == CTOK_ID && t->keyword == CKW_OTHER && !cparse_is(t, "sizeof") && !cparse_is(t, "_Alignof") &&
+        !cparse_is(t, "offsetof"))
+    {
+        cparse_next(cp);
+        coord = cparse_coord(cp, t);
+    }
+    if (cparse_is(t, "{"))
+        return cparse_compound(cp, cparse_null);
+    if (cparse_is(t, "if"))
+    {
+        cparse_expect(cp, "(");
+        json_value cond = cparse_expression(cp);
+        cparse_expect(cp, ")");
+        json_value iftrue = cparse_statement(cp);
+        json_value iffalse = cparse_accept(cp, "else") ? cparse_statement(cp) : cparse_null;
+        return cparse_node(cp, "If", coord, "cond", cond, "iffalse", iffalse, "iftrue", iftrue, NULL);
+    }
+    if (cparse_is(t, "while") || cparse_is(t, "switch"))
+    {
+        cparse_expect(cp, "(");
+        json_value cond = cparse_expression(cp);
+        cparse_expect(cp, ")");
+        bool grouped = cparse_is(t, "switch") && cparse_is(cparse_peek(cp, 0), "{");
+        json_value stmt = grouped ? cparse_switch_body(cp) : cparse_statement(cp);
+        return cparse_node(cp, cparse_is(t, "while") ? "While" : "Switch", coord, "cond", cond, "stmt", stmt, NULL);
+    }
+    if (cparse_is(t, "do"))
+    {
+        json_value stmt = cparse_statement(cp);
+        cparse_expect(cp, "while");
+        cparse_expect(cp, "(");
+        json_value cond = cparse_expression(cp);
+        cparse_expect(cp, ")");
+        cparse_expect(cp, ";");
+        return cparse_node(cp, "DoWhile", coord, "cond", cond, "stmt", stmt, NULL);
+    }
+    if (cparse_is(t, "for"))
+    {
+        cparse_expect(cp, "(");
+        json_value init = cparse_null;
+        if (cparse_is_type_start(cp, cparse_peek(cp, 0)))
+        {
+            // for (int i = 0; ...): 선언이 ';'까지 읽습니다
+            size_t base = json_parser_open(cp->json);
+            cparse_declaration(cp, false);
+            init = cparse_node(cp, "DeclList", coord, "decls", cparse_list(cp, base), NULL);
+        }
+        else
+        {
+            if (!cparse_is(cparse_peek(cp, 0), ";"))
+                init = cparse_expression(cp);
+            cparse_expect(cp, ";");
+        }
+        json_value cond = cparse_is(cparse_peek(cp, 0), ";") ? cparse_null : cparse_expression(cp);
+        cparse_expect(cp, ";");
+        json_value next = cparse_is(cparse_peek(cp, 0), ")") ? cparse_null : cparse_expression(cp);
+        cparse_expect(cp, ")");
+        json_value stmt = cparse_statement(cp);
+        return cparse_node(cp, "For", coord, "cond", cond, "init", init, "next", next, "stmt", stmt, NULL);
+    }
+    if (cparse_is(t, "return"))
+    {
+        json_value expr = cparse_is(cparse_peek(cp, 0), ";") ? cparse_null : cparse_expression(cp);
+        cparse_expect(cp, ";");
+        return cparse_node(cp, "Return", coord, "expr", expr, NULL);
+    }
+    if (cparse_is(t, "break") || cparse_is(t, "continue"))
+    {
+        cparse_expect(cp, ";");
+        return cparse_node(cp, cparse_is(t, "break") ? "Break" : "Continue", coord, NULL);
+    }
+    if (cparse_is(t, "goto"))
+    {
+        const cparse_token *label = cparse_next(cp);
+        if (!cparse_is_name(label))
+            cparse_error(cp, label, "레이블 이름이 필요합니다");
+        cparse_expect(cp, ";");
+        return cparse_node(cp, "Goto", coord, "name", cparse_token_string(cp, label), NULL);
+    }
+    if (coord.type != JSON_UNDEFINED)
+    {
+        cparse_error(cp, t, "문장이 필요합니다");
+        return cparse_undefined;
+    }
+    if (cparse_is_name(t) && cparse_is(cparse_peek(cp, 1), ":"))
+    {
+        cparse_next(cp);
+        cparse_next(cp);
+        json_value stmt = cparse_statement(cp);
+        return cparse_node(cp, "Label", cparse_coord(cp, t), "name", cparse_token_string(cp, t), "stmt", stmt, NULL);
+    }
+    if (cparse_accept(cp, ";"))
+        return cparse_node(cp, "EmptyStatement", cparse_coord(cp, t), NULL);
+    json_value expr = cparse_expression(cp);
+    cparse_expect(cp, ";");
+    return expr;
+}
+
+// block_item : declaration | statement (선언은 Decl들을, 문장은 노드 하나를 쌓습니다)
+static void cparse_block_item(cparse *cp)
+{
+    const cparse_token *t = cparse_peek(cp, 0);
+    if (cparse_is_type_start(cp, t) && !cparse_is(cparse_peek(cp, 1), ":"))
+        cparse_declaration(cp, false);
+    else
+        cparse_push(cp, NULL, cparse_statement(cp));
+}
+
+// compound_statement. params는 함수 본문일 때 본문 스코프에 등록할 ParamList
+static json_value cparse_compound(cparse *cp, json_value params)
+{
+    const cparse_token *brace = cparse_expect(cp, "{");
+    size_t mark = cp->symbol_count;
+    if (params.type == JSON_OBJECT)
+    {
+        // '...'(EllipsisParam)에는 name이 없으므로 오류 메시지 없이 찾습니다
+        static JSON_THREAD_LOCAL json_inline_cache params_ic, name_ic;
+        const json_value *list = json_get_ic(params, "params", &params_ic);
+        json_array *arr = list != NULL && list->type == JSON_ARRAY ? (json_array *)list->value : NULL;
+        for (json_index i = 0; arr != NULL && i <= arr->last_index; i++)
+        {
+            const json_value *name = json_get_ic(arr->values[i], "name", &name_ic);
+            const char *text = name != NULL ? json_string_of(name) : NULL;
+            if (text != NULL)
+                cparse_declare(cp, text, strlen(text), false);
+        }
+    }
+    size_t base = json_parser_open(cp->json);
+    while (!cparse_is(cparse_peek(cp, 0), "}") && cparse_peek(cp, 0)->kind != CTOK_EOF)
+        cparse_block_item(cp);
+    cparse_expect(cp, "}");
+    cparse_close_scope(cp, mark);
+    json_value items = cparse_list(cp, base);
+    return cparse_node(cp, "Compound", cparse_coord_brace(cp, brace), "block_items", items, NULL);
+}
+
+// --- 선언과 함수 정의 ---
+
+// 함수 정의: 선언자 다음의 K&R 파라미터 선언들과 본문
+static json_value cparse_function_definition(cparse *cp, const cparse_spec *spec, int64_t d, json_value int_coord)
+{
+    json_value params = cp->last_params;
+    json_value decl = cparse_decl_node(cp, spec, d, cparse_null, cparse_null, int_coord);
+    int64_t type_decl = cparse_typedecl_of(cp, d);
+    if (type_decl >= 0 && cp->decls[type_decl].name != NULL)
+        cparse_declare(cp, cp->decls[type_decl].name->text, cp->decls[type_decl].name->length, false);
+    size_t base = json_parser_open(cp->json);
+    while (cparse_is_type_start(cp, cparse_peek(cp, 0)))
+        cparse_declaration(cp, false);
+    json_value param_decls = cparse_list(cp, base);
+    json_value body = cparse_compound(cp, params);
+    return cparse_node(cp, "FuncDef", cp->decls[d].coord, "body", body, "decl", decl, "param_decls", param_decls, NULL);
+}
+
+/*
+ * declaration (external이면 function_definition도)
+ * 만든 Decl/Typedef/FuncDef 노드는 호출자가 열어 둔 목록에 바로 쌓습니다.
+ * 선언한 이름은 선언자마다 스코프에 등록합니다 (typedef 이름이 이후 토큰의 해석을 바꿈).
+ */
+static void cparse_declaration(cparse *cp, bool external)
+{
+    const cparse_token *first = cparse_peek(cp, 0);
+    if (cparse_is(first, "_Static_assert"))
+    {
+        cparse_push(cp, NULL, cparse_static_assert(cp));
+        return;
+    }
+    cparse_spec spec;
+    bool has_spec = cparse_specifiers(cp, &spec, true);
+    if (!has_spec && !(external && cparse_is_name(first)))
+    {
+        cparse_error(cp, first, "선언이 필요합니다");
+        return;
+    }
+    if (has_spec && cparse_accept(cp, ";"))
+    {
+        cparse_push(cp, NULL, cparse_tag_decl(cp, &spec, first));
+        return;
+    }
+    // 지정자 없는 함수 정의(main() { ... })의 int는 위치 없는 비단말의 좌표
+    json_value int_coord = has_spec ? cparse_undefined : cparse_coord_none(cp, first);
+    bool is_typedef = cparse_spec_is_typedef(&spec);
+    bool first_declarator = true;
+    do
+    {
+        cp->last_params = cparse_null;
+        int64_t d = cparse_declarator(cp, CPARSE_NAMED);
+        if (d < 0)
+            return;
+        const cparse_token *next = cparse_peek(cp, 0);
+        if (external && first_declarator && cp->decls[d].kind == CDECL_FUNC &&
+            (cparse_is(next, "{") || cparse_is_type_start(cp, next)))
+        {
+            cparse_push(cp, NULL, cparse_function_definition(cp, &spec, d, int_coord));
+            return;
+        }
+        if (!has_spec)
+            break;
+        json_value init = cparse_accept(cp, "=") ? cparse_initializer(cp) : cparse_null;
+        cparse_push(cp, NULL, cparse_decl_node(cp, &spec, d, init, cparse_null, cparse_undefined));
+        int64_t type_decl = cparse_typedecl_of(cp, d);
+        if (type_decl >= 0 && cp->decls[type_decl].name != NULL)
+            cparse_declare(cp, cp->decls[type_decl].name->text, cp->decls[type_decl].name->length, is_typedef);
+        first_declarator = false;
+    } while (cparse_accept(cp, ","));
+    if (!has_spec)
+    {
+        cparse_error(cp, cparse_peek(cp, 0), "함수 본문이 필요합니다");
+        return;
+    }
+    cparse_expect(cp, ";");
+}
+
+json_value ast_cparse(json_parser *parser, const char *source, const char *filename)
+{
+    json_parser_reset(parser);
+    if (parser->heap_nodes)
+        parser->hash_cons = false;
+    cparse cp;
+    memset(&cp, 0x00, sizeof(cparse));
+    cp.json = parser;
+    cp.filename = filename != NULL ? filename : "";
+    cp.last_params = cparse_null;
+
+    json_value ast = cparse_undefined;
+    if (cparse_tokenize(&cp, source))
+    {
+        size_t base = json_parser_open(parser);
+        while (cparse_peek(&cp, 0)->kind != CTOK_EOF)
+        {
+            if (!cparse_accept(&cp, ";"))
+                cparse_declaration(&cp, true);
+        }
+        json_value ext = cparse_list(&cp, base);
+        ast = cparse_node(&cp, "FileAST", cparse_null, "ext", ext, NULL);
+    }
+    if (cp.failed)
+    {
+        ast = cparse_undefined;
+        json_parser_reset(parser);
+    }
+    free(cp.tokens);
+    free(cp.decls);
+    free(cp.symbols);
+    free(cp.slots);
+    free(cp.text);
+    return ast;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
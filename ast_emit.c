@@ -0,0 +1,809 @@
+#ifndef __AST_EMIT_HEADER__
+#define __AST_EMIT_HEADER__
+
+/*
+ * ast_emit.c
+ *
+ * pycparser AST(JSON) → C 소스 생성기 (ast2c_convert.py의 generate_code()를 C로 옮긴 것).
+ * 문자열을 이어 붙이지 않고 하나의 커지는 버퍼에 바로 쓰며, 들여쓰기는 미리 만들어 둔 공백 문자열에서 잘라 씁니다.
+ * generate_code()가 다루는 노드에 더해 For, Switch/Case/Default, UnaryOp, Cast, StructRef, TernaryOp,
+ * NamedInitializer, CompoundLiteral, StaticAssert, GNU 문 식과
+ * 선언자(포인터/배열/함수 포인터)를 C 문법대로 처리하므로 출력은 다시 컴파일할 수 있는 C 코드입니다.
+ * 모르는 노드를 만나면 ast_emit_c가 false를 돌려주고 그 종류를 unsupported에 남깁니다.
+ *
+ * 사용 예:
+ *   ast_emit_buffer out;
+ *   ast_emit_init(&out);
+ *   if (ast_emit_c(&out, doc))
+ *       fwrite(out.data, 1, out.size, fp);
+ *   ast_emit_free(&out);
+ */
+
+#include "ast_analyzer.c"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#define AST_EMIT_INDENT 4
+
+typedef struct ast_emit_buffer_s
+{
+    char *data;
+    size_t size;
+    size_t capacity;
+    bool failed; // 메모리 할당에 실패하거나 모르는 노드를 만나면 이후 쓰기는 무시됩니다
+    const char *unsupported; // 처음 만난 모르는 노드의 종류 (없으면 NULL)
+} ast_emit_buffer;
+
+void ast_emit_init(ast_emit_buffer *out);
+void ast_emit_free(ast_emit_buffer *out);
+// 문서(FileAST) 또는 임의의 노드를 C 소스로 out 뒤에 덧붙입니다. 실패하면 false
+bool ast_emit_c(ast_emit_buffer *out, json_value node);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#ifndef __AST_EMIT_BODY__
+#define __AST_EMIT_BODY__
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+static const char ast_emit_spaces[] = "                                                                "; // 64칸
+
+void ast_emit_init(ast_emit_buffer *out)
+{
+    memset(out, 0x00, sizeof(ast_emit_buffer));
+}
+
+void ast_emit_free(ast_emit_buffer *out)
+{
+    free(out->data);
+    memset(out, 0x00, sizeof(ast_emit_buffer));
+}
+
+static bool ast_emit_reserve(ast_emit_buffer *out, size_t extra)
+{
+    if (out->failed)
+        return false;
+    if (out->size + extra + 1 <= out->capacity)
+        return true;
+    size_t capacity = out->capacity ? out->capacity : 4096;
+    while (capacity < out->size + extra + 1)
+        capacity *= 2;
+    char *data = (char *)realloc(out->data, capacity);
+    if (data == NULL)
+    {
+        out->failed = true;
+        return false;
+    }
+    out->data = data;
+    out->capacity = capacity;
+    return true;
+}
+
+static void ast_emit_write(ast_emit_buffer *out, const char *str, size_t len)
+{
+    if (!ast_emit_reserve(out, len))
+        return;
+    memcpy(out->data + out->size, str, len);
+    out->size += len;
+    out->data[out->size] = '\0';
+}
+
+static void ast_emit_str(ast_emit_buffer *out, const char *str)
+{
+    if (str != NULL)
+        ast_emit_write(out, str, strlen(str));
+}
+
+static void ast_emit_indent(ast_emit_buffer *out, int level)
+{
+    size_t n = (size_t)level * AST_EMIT_INDENT;
+    while (n > 0)
+    {
+        size_t chunk = n < sizeof(ast_emit_spaces) - 1 ? n : sizeof(ast_emit_spaces) - 1;
+        ast_emit_write(out, ast_emit_spaces, chunk);
+        n -= chunk;
+    }
+}
+
+// --- 노드 접근 (없는 키도 오류 메시지 없이 undefined를 돌려줌) ---
+// 분석기와 같은 ast_get()으로 찾습니다. ic는 호출한 함수가 키마다 둔 인라인 캐시입니다 (스레드마다 따로).
+// 짧은 문자열은 칸 안에 들어 있을 수 있으므로(JSON_INLINE) 문자열은 복사본이 아닌 문서 안의 칸에서 읽습니다.
+static json_value ast_emit_member(json_value node, const char *key, json_inline_cache *ic)
+{
+    return *ast_get(node, key, ic);
+}
+
+static const char *ast_emit_string(json_value node, const char *key, json_inline_cache *ic)
+{
+    return json_string_of(ast_get(node, key, ic));
+}
+
+static const char *ast_emit_kind(json_value node)
+{
+    if (node.type != JSON_OBJECT || node.value == NULL)
+        return NULL;
+    return ast_nodetype((const json_object *)node.value);
+}
+
+static bool ast_emit_is(json_value node, const char *kind)
+{
+    const char *k = ast_emit_kind(node);
+    return k != NULL && strcmp(k, kind) == 0;
+}
+
+static const json_array *ast_emit_array(json_value node, const char *key, json_inline_cache *ic)
+{
+    json_value v = ast_emit_member(node, key, ic);
+    return v.type == JSON_ARRAY ? (const json_array *)v.value : NULL;
+}
+
+// 문자열 배열(quals, storage, names 등)을 각 원소 뒤에 sep를 붙여 씁니다
+static void ast_emit_words(ast_emit_buffer *out, json_value node, const char *key, const char *sep, json_inline_cache *ic)
+{
+    const json_array *arr = ast_emit_array(node, key, ic);
+    for (json_index i = 0; arr != NULL && i <= arr->last_index; i++)
+    {
+        if (!json_is_string(arr->values[i]))
+            continue;
+        ast_emit_str(out, json_string_of(&arr->values[i]));
+        ast_emit_str(out, sep);
+    }
+}
+
+static void ast_emit_expr(ast_emit_buffer *out, json_value node);
+static void ast_emit_stmt(ast_emit_buffer *out, json_value node, int level);
+static void ast_emit_decl(ast_emit_buffer *out, json_value decl, bool with_storage);
+static void ast_emit_type(ast_emit_buffer *out, json_value type, const char *name);
+
+/*
+ * 타입과 선언자.
+ * C 선언자는 안쪽에서 바깥쪽으로 읽으므로, 바깥 노드(PtrDecl/ArrayDecl/FuncDecl)를 modifier 목록에 모은 뒤
+ * TypeDecl(이름)에 도달하면 목록을 차례로 적용해 선언자 문자열을 만듭니다.
+ * 포인터를 가리키는 배열/함수가 아니라 배열/함수를 가리키는 포인터면 "(*name)[3]"처럼 괄호를 넣습니다.
+ */
+#define AST_EMIT_MAX_MODIFIERS 64
+
+static void ast_emit_params(ast_emit_buffer *out, json_value funcdecl)
+{
+    static JSON_THREAD_LOCAL json_inline_cache args_ic, params_ic, type_ic;
+    // 파라미터 목록이 없는 선언(int f())은 그대로 "()"로 써야 다시 파싱했을 때 같은 AST가 됩니다
+    json_value args = ast_emit_member(funcdecl, "args", &args_ic);
+    const json_array *params = ast_emit_array(args, "params", &params_ic);
+    if (params == NULL || params->last_index < 0)
+        return;
+    for (json_index i = 0; i <= params->last_index; i++)
+    {
+        if (i > 0)
+            ast_emit_str(out, ", ");
+        json_value param = params->values[i];
+        if (ast_emit_is(param, "Decl"))
+            ast_emit_decl(out, param, true);
+        else if (ast_emit_is(param, "Typename"))
+            ast_emit_type(out, ast_emit_member(param, "type", &type_ic), NULL);
+        else if (ast_emit_is(param, "EllipsisParam"))
+            ast_emit_str(out, "...");
+        else
+            ast_emit_expr(out, param);
+    }
+}
+
+// 타입 지정자 (IdentifierType, Struct/Union/Enum)
+static void ast_emit_specifier(ast_emit_buffer *out, json_value spec)
+{
+    static JSON_THREAD_LOCAL json_inline_cache decls_ic, enumerators_ic, name_ic, names_ic, value_ic, values_ic;
+    const char *kind = ast_emit_kind(spec);
+    if (kind == NULL)
+        return;
+    if (strcmp(kind, "IdentifierType") == 0)
+    {
+        const json_array *names = ast_emit_array(spec, "names", &names_ic);
+        for (json_index i = 0; names != NULL && i <= names->last_index; i++)
+        {
+            if (i > 0)
+                ast_emit_str(out, " ");
+            if (json_is_string(names->values[i]))
+                ast_emit_str(out, json_string_of(&names->values[i]));
+        }
+        return;
+    }
+    if (strcmp(kind, "Struct") == 0 || strcmp(kind, "Union") == 0 || strcmp(kind, "Enum") == 0)
+    {
+        ast_emit_str(out, strcmp(kind, "Struct") == 0 ? "struct" : strcmp(kind, "Union") == 0 ? "union" : "enum");
+        const char *name = ast_emit_string(spec, "name", &name_ic);
+        if (name != NULL)
+        {
+            ast_emit_str(out, " ");
+            ast_emit_str(out, name);
+        }
+        if (strcmp(kind, "Enum") == 0)
+        {
+            const json_array *items = ast_emit_array(ast_emit_member(spec, "values", &values_ic), "enumerators", &enumerators_ic);
+            if (items == NULL)
+                return;
+            ast_emit_str(out, " { ");
+            for (json_index i = 0; i <= items->last_index; i++)
+            {
+                ast_emit_str(out, i ? ", " : "");
+                ast_emit_str(out, ast_emit_string(items->values[i], "name", &name_ic));
+                json_value value = ast_emit_member(items->values[i], "value", &value_ic);
+                if (value.type == JSON_OBJECT)
+                {
+                    ast_emit_str(out, " = ");
+                    ast_emit_expr(out, value);
+                }
+            }
+            ast_emit_str(out, " }");
+            return;
+        }
+        const json_array *decls = ast_emit_array(spec, "decls", &decls_ic);
+        if (decls == NULL)
+            return;
+        ast_emit_str(out, " { ");
+        for (json_index i = 0; i <= decls->last_index; i++)
+        {
+            ast_emit_decl(out, decls->values[i], true);
+            ast_emit_str(out, "; ");
+        }
+        ast_emit_str(out, "}");
+        return;
+    }
+    ast_emit_type(out, spec, NULL);
+}
+
+// 타입 노드 사슬을 선언자와 함께 씁니다. name이 NULL이면 TypeDecl의 declname을 씁니다 (추상 선언자면 없음)
+static void ast_emit_type(ast_emit_buffer *out, json_value type, const char *name)
+{
+    static JSON_THREAD_LOCAL json_inline_cache declname_ic, dim_ic, quals_ic, type_ic;
+    json_value modifiers[AST_EMIT_MAX_MODIFIERS];
+    int count = 0;
+    json_value node = type;
+    const char *kind;
+    while ((kind = ast_emit_kind(node)) != NULL && count < AST_EMIT_MAX_MODIFIERS &&
+           (strcmp(kind, "PtrDecl") == 0 || strcmp(kind, "ArrayDecl") == 0 || strcmp(kind, "FuncDecl") == 0))
+    {
+        modifiers[count++] = node;
+        node = ast_emit_member(node, "type", &type_ic);
+    }
+    if (kind == NULL || strcmp(kind, "TypeDecl") != 0)
+    {
+        // TypeDecl 없이 지정자만 있는 경우 (Typename의 안쪽 등)
+        ast_emit_specifier(out, node);
+        return;
+    }
+
+    ast_emit_words(out, node, "quals", " ", &quals_ic);
+    ast_emit_specifier(out, ast_emit_member(node, "type", &type_ic));
+    if (name == NULL)
+        name = ast_emit_string(node, "declname", &declname_ic);
+
+    // 선언자: 이름에서 시작해 바깥 modifier(목록의 앞)부터 차례로 감쌉니다.
+    // 예) PtrDecl(FuncDecl(TypeDecl)) → "*p" → "(*p)(args)": 함수를 가리키는 포인터
+    ast_emit_buffer decl;
+    ast_emit_init(&decl);
+    ast_emit_str(&decl, name ? name : "");
+    for (int i = 0; i < count; i++)
+    {
+        const char *mk = ast_emit_kind(modifiers[i]);
+        if (strcmp(mk, "PtrDecl") == 0)
+        {
+            ast_emit_buffer prefixed;
+            ast_emit_init(&prefixed);
+            ast_emit_str(&prefixed, "*");
+            ast_emit_words(&prefixed, modifiers[i], "quals", " ", &quals_ic);
+            ast_emit_str(&prefixed, decl.data);
+            ast_emit_free(&decl);
+            decl = prefixed;
+            continue;
+        }
+        // 포인터를 감싼 배열/함수는 괄호가 필요합니다: (*name)[N], (*name)(args)
+        if (i > 0 && ast_emit_is(modifiers[i - 1], "PtrDecl"))
+        {
+            ast_emit_buffer wrapped;
+            ast_emit_init(&wrapped);
+            ast_emit_str(&wrapped, "(");
+            ast_emit_str(&wrapped, decl.data);
+            ast_emit_str(&wrapped, ")");
+            ast_emit_free(&decl);
+            decl = wrapped;
+        }
+        if (strcmp(mk, "ArrayDecl") == 0)
+        {
+            ast_emit_str(&decl, "[");
+            json_value dim = ast_emit_member(modifiers[i], "dim", &dim_ic);
+            if (dim.type == JSON_OBJECT)
+                ast_emit_expr(&decl, dim);
+            ast_emit_str(&decl, "]");
+        }
+        else
+        {
+            ast_emit_str(&decl, "(");
+            ast_emit_params(&decl, modifiers[i]);
+            ast_emit_str(&decl, ")");
+        }
+    }
+    if (decl.failed)
+        out->failed = true;
+    else if (decl.size > 0)
+    {
+        ast_emit_str(out, " ");
+        ast_emit_write(out, decl.data, decl.size);
+    }
+    ast_emit_free(&decl);
+}
+
+// Decl 하나 ("static int *p = 0" — 끝의 세미콜론은 호출한 쪽에서 붙임)
+static void ast_emit_decl(ast_emit_buffer *out, json_value decl, bool with_storage)
+{
+    static JSON_THREAD_LOCAL json_inline_cache bitsize_ic, funcspec_ic, init_ic, name_ic, storage_ic, type_ic;
+    if (with_storage)
+    {
+        ast_emit_words(out, decl, "storage", " ", &storage_ic);
+        ast_emit_words(out, decl, "funcspec", " ", &funcspec_ic);
+    }
+    json_value type = ast_emit_member(decl, "type", &type_ic);
+    if (ast_emit_is(type, "Struct") || ast_emit_is(type, "Union") || ast_emit_is(type, "Enum"))
+        ast_emit_specifier(out, type); // 이름 없는 선언: struct 정의 자체
+    else
+        ast_emit_type(out, type, ast_emit_string(decl, "name", &name_ic));
+    json_value bitsize = ast_emit_member(decl, "bitsize", &bitsize_ic);
+    if (bitsize.type == JSON_OBJECT)
+    {
+        ast_emit_str(out, " : ");
+        ast_emit_expr(out, bitsize);
+    }
+    json_value init = ast_emit_member(decl, "init", &init_ic);
+    if (init.type == JSON_OBJECT)
+    {
+        ast_emit_str(out, " = ");
+        ast_emit_expr(out, init);
+    }
+}
+
+/*
+ * 식.
+ * generate_code()처럼 이항 연산은 항상 괄호로 감싸 우선순위를 보존합니다.
+ * 단항 연산/형 변환의 피연산자가 단순한 식(이름, 상수, 호출, 첨자, 멤버, 괄호 식)이 아니면 괄호를 더합니다.
+ */
+static bool ast_emit_is_primary(json_value node)
+{
+    const char *kind = ast_emit_kind(node);
+    return kind == NULL || strcmp(kind, "ID") == 0 || strcmp(kind, "Constant") == 0 || strcmp(kind, "FuncCall") == 0 ||
+           strcmp(kind, "ArrayRef") == 0 || strcmp(kind, "StructRef") == 0 || strcmp(kind, "BinaryOp") == 0 ||
+           strcmp(kind, "TernaryOp") == 0 || strcmp(kind, "Assignment") == 0;
+}
+
+static void ast_emit_operand(ast_emit_buffer *out, json_value node)
+{
+    bool paren = !ast_emit_is_primary(node);
+    ast_emit_str(out, paren ? "(" : "");
+    ast_emit_expr(out, node);
+    ast_emit_str(out, paren ? ")" : "");
+}
+
+static void ast_emit_list(ast_emit_buffer *out, const json_array *items)
+{
+    for (json_index i = 0; items != NULL && i <= items->last_index; i++)
+    {
+        if (i > 0)
+            ast_emit_str(out, ", ");
+        ast_emit_expr(out, items->values[i]);
+    }
+}
+
+static void ast_emit_expr(ast_emit_buffer *out, json_value node)
+{
+    static JSON_THREAD_LOCAL json_inline_cache args_ic, block_items_ic, cond_ic, decls_ic, expr_ic, exprs_ic, field_ic, iffalse_ic, iftrue_ic, init_ic, left_ic, lvalue_ic, message_ic, name_ic, op_ic, right_ic, rvalue_ic, subscript_ic, to_type_ic, type_ic, value_ic;
+    const char *kind = ast_emit_kind(node);
+    if (kind == NULL)
+    {
+        if (json_is_string(node))
+            ast_emit_str(out, json_string_of(&node));
+        return;
+    }
+    if (strcmp(kind, "ID") == 0)
+        ast_emit_str(out, ast_emit_string(node, "name", &name_ic));
+    else if (strcmp(kind, "Constant") == 0)
+        ast_emit_str(out, ast_emit_string(node, "value", &value_ic));
+    else if (strcmp(kind, "BinaryOp") == 0)
+    {
+        ast_emit_str(out, "(");
+        ast_emit_expr(out, ast_emit_member(node, "left", &left_ic));
+        ast_emit_str(out, " ");
+        ast_emit_str(out, ast_emit_string(node, "op", &op_ic));
+        ast_emit_str(out, " ");
+        ast_emit_expr(out, ast_emit_member(node, "right", &right_ic));
+        ast_emit_str(out, ")");
+    }
+    else if (strcmp(kind, "Assignment") == 0)
+    {
+        const char *op = ast_emit_string(node, "op", &op_ic);
+        ast_emit_str(out, "(");
+        ast_emit_expr(out, ast_emit_member(node, "lvalue", &lvalue_ic));
+        ast_emit_str(out, " ");
+        ast_emit_str(out, op ? op : "=");
+        ast_emit_str(out, " ");
+        ast_emit_expr(out, ast_emit_member(node, "rvalue", &rvalue_ic));
+        ast_emit_str(out, ")");
+    }
+    else if (strcmp(kind, "UnaryOp") == 0)
+    {
+        const char *op = ast_emit_string(node, "op", &op_ic);
+        json_value expr = ast_emit_member(node, "expr", &expr_ic);
+        if (op == NULL)
+            op = "";
+        if (strcmp(op, "p++") == 0 || strcmp(op, "p--") == 0)
+        {
+            ast_emit_operand(out, expr);
+            ast_emit_str(out, op + 1);
+        }
+        else if (strcmp(op, "sizeof") == 0)
+        {
+            ast_emit_str(out, "sizeof(");
+            ast_emit_expr(out, expr);
+            ast_emit_str(out, ")");
+        }
+        else
+        {
+            ast_emit_str(out, op);
+            ast_emit_operand(out, expr);
+        }
+    }
+    else if (strcmp(kind, "Cast") == 0)
+    {
+        ast_emit_str(out, "(");
+        ast_emit_expr(out, ast_emit_member(node, "to_type", &to_type_ic));
+        ast_emit_str(out, ")");
+        ast_emit_operand(out, ast_emit_member(node, "expr", &expr_ic));
+    }
+    else if (strcmp(kind, "Typename") == 0)
+        ast_emit_type(out, ast_emit_member(node, "type", &type_ic), NULL);
+    else if (strcmp(kind, "StructRef") == 0)
+    {
+        ast_emit_operand(out, ast_emit_member(node, "name", &name_ic));
+        ast_emit_str(out, ast_emit_string(node, "type", &type_ic));
+        ast_emit_expr(out, ast_emit_member(node, "field", &field_ic));
+    }
+    else if (strcmp(kind, "TernaryOp") == 0)
+    {
+        ast_emit_str(out, "(");
+        ast_emit_expr(out, ast_emit_member(node, "cond", &cond_ic));
+        ast_emit_str(out, " ? ");
+        ast_emit_expr(out, ast_emit_member(node, "iftrue", &iftrue_ic));
+        ast_emit_str(out, " : ");
+        ast_emit_expr(out, ast_emit_member(node, "iffalse", &iffalse_ic));
+        ast_emit_str(out, ")");
+    }
+    else if (strcmp(kind, "FuncCall") == 0)
+    {
+        ast_emit_operand(out, ast_emit_member(node, "name", &name_ic));
+        ast_emit_str(out, "(");
+        ast_emit_list(out, ast_emit_array(ast_emit_member(node, "args", &args_ic), "exprs", &exprs_ic));
+        ast_emit_str(out, ")");
+    }
+    else if (strcmp(kind, "ArrayRef") == 0)
+    {
+        ast_emit_operand(out, ast_emit_member(node, "name", &name_ic));
+        ast_emit_str(out, "[");
+        ast_emit_expr(out, ast_emit_member(node, "subscript", &subscript_ic));
+        ast_emit_str(out, "]");
+    }
+    else if (strcmp(kind, "ExprList") == 0)
+        ast_emit_list(out, ast_emit_array(node, "exprs", &exprs_ic));
+    else if (strcmp(kind, "InitList") == 0)
+    {
+        ast_emit_str(out, "{");
+        ast_emit_list(out, ast_emit_array(node, "exprs", &exprs_ic));
+        ast_emit_str(out, "}");
+    }
+    else if (strcmp(kind, "Decl") == 0)
+        ast_emit_decl(out, node, true);
+    else if (strcmp(kind, "DeclList") == 0)
+    {
+        // for (int i = 0, j = 1; ...): 첫 선언만 타입을 쓰고 나머지는 선언자만
+        const json_array *decls = ast_emit_array(node, "decls", &decls_ic);
+        for (json_index i = 0; decls != NULL && i <= decls->last_index; i++)
+        {
+            if (i == 0)
+            {
+                ast_emit_decl(out, decls->values[i], true);
+                continue;
+            }
+            ast_emit_str(out, ", ");
+            ast_emit_str(out, ast_emit_string(decls->values[i], "name", &name_ic));
+            json_value init = ast_emit_member(decls->values[i], "init", &init_ic);
+            if (init.type == JSON_OBJECT)
+            {
+                ast_emit_str(out, " = ");
+                ast_emit_expr(out, init);
+            }
+        }
+    }
+    else if (strcmp(kind, "Compound") == 0)
+    {
+        // GNU 문 식 ({ ... }): 문장들을 쓴 뒤 줄바꿈을 공백으로 바꿔 한 줄로 만듭니다
+        const json_array *items = ast_emit_array(node, "block_items", &block_items_ic);
+        ast_emit_str(out, "({ ");
+        size_t start = out->size;
+        for (json_index i = 0; items != NULL && i <= items->last_index; i++)
+            ast_emit_stmt(out, items->values[i], 0);
+        for (size_t i = start; !out->failed && i < out->size; i++)
+        {
+            if (out->data[i] == '\n')
+                out->data[i] = ' ';
+        }
+        ast_emit_str(out, "})");
+    }
+    else if (strcmp(kind, "NamedInitializer") == 0)
+    {
+        // pycparser의 c_generator와 같이 ID는 .필드, 나머지는 [색인]으로 씁니다
+        const json_array *names = ast_emit_array(node, "name", &name_ic);
+        for (json_index i = 0; names != NULL && i <= names->last_index; i++)
+        {
+            if (ast_emit_is(names->values[i], "ID"))
+            {
+                ast_emit_str(out, ".");
+                ast_emit_expr(out, names->values[i]);
+            }
+            else
+            {
+                ast_emit_str(out, "[");
+                ast_emit_expr(out, names->values[i]);
+                ast_emit_str(out, "]");
+            }
+        }
+        ast_emit_str(out, " = ");
+        ast_emit_expr(out, ast_emit_member(node, "expr", &expr_ic));
+    }
+    else if (strcmp(kind, "CompoundLiteral") == 0)
+    {
+        // init은 InitList라 중괄호를 스스로 씁니다
+        ast_emit_str(out, "(");
+        ast_emit_expr(out, ast_emit_member(node, "type", &type_ic));
+        ast_emit_str(out, ")");
+        ast_emit_expr(out, ast_emit_member(node, "init", &init_ic));
+    }
+    else if (strcmp(kind, "StaticAssert") == 0)
+    {
+        json_value message = ast_emit_member(node, "message", &message_ic);
+        ast_emit_str(out, "_Static_assert(");
+        ast_emit_expr(out, ast_emit_member(node, "cond", &cond_ic));
+        if (message.type == JSON_OBJECT)
+        {
+            ast_emit_str(out, ", ");
+            ast_emit_expr(out, message);
+        }
+        ast_emit_str(out, ")");
+    }
+    else
+    {
+        // 다룰 수 없는 노드를 건너뛰면 컴파일되지 않는 소스가 나오므로 실패로 돌려줍니다
+        if (out->unsupported == NULL)
+            out->unsupported = kind;
+        out->failed = true;
+    }
+}
+
+/*
+ * 문장. 각 문장은 들여쓰기부터 줄바꿈까지 한 번에 씁니다.
+ * if/while/for/switch의 본문이 Compound면 같은 줄에서 "{"를 열고, 아니면 다음 줄에 한 단계 더 들여 씁니다.
+ */
+static void ast_emit_items(ast_emit_buffer *out, const json_array *items, int level)
+{
+    for (json_index i = 0; items != NULL && i <= items->last_index; i++)
+        ast_emit_stmt(out, items->values[i], level);
+}
+
+// 본문을 쓰고, Compound였으면 true (닫는 "}" 뒤에 줄바꿈을 쓰지 않은 상태)
+static bool ast_emit_body(ast_emit_buffer *out, json_value body, int level)
+{
+    static JSON_THREAD_LOCAL json_inline_cache block_items_ic;
+    if (ast_emit_is(body, "Compound"))
+    {
+        ast_emit_str(out, " {\n");
+        ast_emit_items(out, ast_emit_array(body, "block_items", &block_items_ic), level + 1);
+        ast_emit_indent(out, level);
+        ast_emit_str(out, "}");
+        return true;
+    }
+    ast_emit_str(out, "\n");
+    if (ast_emit_kind(body) == NULL)
+    {
+        // 본문이 비어 있으면(null) 빈 문장으로
+        ast_emit_indent(out, level + 1);
+        ast_emit_str(out, ";\n");
+        return false;
+    }
+    ast_emit_stmt(out, body, level + 1);
+    return false;
+}
+
+static void ast_emit_if(ast_emit_buffer *out, json_value node, int level)
+{
+    static JSON_THREAD_LOCAL json_inline_cache cond_ic, iffalse_ic, iftrue_ic;
+    ast_emit_str(out, "if (");
+    ast_emit_expr(out, ast_emit_member(node, "cond", &cond_ic));
+    ast_emit_str(out, ")");
+    bool closed = ast_emit_body(out, ast_emit_member(node, "iftrue", &iftrue_ic), level);
+    json_value iffalse = ast_emit_member(node, "iffalse", &iffalse_ic);
+    if (iffalse.type != JSON_OBJECT)
+    {
+        if (closed)
+            ast_emit_str(out, "\n");
+        return;
+    }
+    if (closed)
+        ast_emit_str(out, " else");
+    else
+    {
+        ast_emit_indent(out, level);
+        ast_emit_str(out, "else");
+    }
+    if (ast_emit_is(iffalse, "If"))
+    {
+        // else if 사슬은 같은 들여쓰기로 이어 씁니다
+        ast_emit_str(out, " ");
+        ast_emit_if(out, iffalse, level);
+        return;
+    }
+    if (ast_emit_body(out, iffalse, level))
+        ast_emit_str(out, "\n");
+}
+
+static void ast_emit_stmt(ast_emit_buffer *out, json_value node, int level)
+{
+    static JSON_THREAD_LOCAL json_inline_cache block_items_ic, body_ic, cond_ic, decl_ic, expr_ic, ext_ic, init_ic, lvalue_ic, name_ic, next_ic, op_ic, rvalue_ic, stmt_ic, stmts_ic, type_ic;
+    const char *kind = ast_emit_kind(node);
+    if (kind == NULL)
+        return;
+    if (strcmp(kind, "Case") == 0 || strcmp(kind, "Default") == 0)
+    {
+        ast_emit_indent(out, level);
+        if (strcmp(kind, "Case") == 0)
+        {
+            ast_emit_str(out, "case ");
+            ast_emit_expr(out, ast_emit_member(node, "expr", &expr_ic));
+            ast_emit_str(out, ":\n");
+        }
+        else
+            ast_emit_str(out, "default:\n");
+        ast_emit_items(out, ast_emit_array(node, "stmts", &stmts_ic), level + 1);
+        return;
+    }
+    if (strcmp(kind, "Label") == 0)
+    {
+        ast_emit_str(out, ast_emit_string(node, "name", &name_ic));
+        ast_emit_str(out, ":\n");
+        ast_emit_stmt(out, ast_emit_member(node, "stmt", &stmt_ic), level);
+        return;
+    }
+
+    ast_emit_indent(out, level);
+    bool closed = false;
+    if (strcmp(kind, "Compound") == 0)
+    {
+        ast_emit_str(out, "{\n");
+        ast_emit_items(out, ast_emit_array(node, "block_items", &block_items_ic), level + 1);
+        ast_emit_indent(out, level);
+        ast_emit_str(out, "}\n");
+        return;
+    }
+    else if (strcmp(kind, "If") == 0)
+    {
+        ast_emit_if(out, node, level);
+        return;
+    }
+    else if (strcmp(kind, "While") == 0)
+    {
+        ast_emit_str(out, "while (");
+        ast_emit_expr(out, ast_emit_member(node, "cond", &cond_ic));
+        ast_emit_str(out, ")");
+        closed = ast_emit_body(out, ast_emit_member(node, "stmt", &stmt_ic), level);
+    }
+    else if (strcmp(kind, "DoWhile") == 0)
+    {
+        ast_emit_str(out, "do");
+        if (!ast_emit_body(out, ast_emit_member(node, "stmt", &stmt_ic), level))
+            ast_emit_indent(out, level);
+        else
+            ast_emit_str(out, " ");
+        ast_emit_str(out, "while (");
+        ast_emit_expr(out, ast_emit_member(node, "cond", &cond_ic));
+        ast_emit_str(out, ");\n");
+        return;
+    }
+    else if (strcmp(kind, "For") == 0)
+    {
+        ast_emit_str(out, "for (");
+        ast_emit_expr(out, ast_emit_member(node, "init", &init_ic));
+        ast_emit_str(out, "; ");
+        ast_emit_expr(out, ast_emit_member(node, "cond", &cond_ic));
+        ast_emit_str(out, "; ");
+        ast_emit_expr(out, ast_emit_member(node, "next", &next_ic));
+        ast_emit_str(out, ")");
+        closed = ast_emit_body(out, ast_emit_member(node, "stmt", &stmt_ic), level);
+    }
+    else if (strcmp(kind, "Switch") == 0)
+    {
+        ast_emit_str(out, "switch (");
+        ast_emit_expr(out, ast_emit_member(node, "cond", &cond_ic));
+        ast_emit_str(out, ")");
+        closed = ast_emit_body(out, ast_emit_member(node, "stmt", &stmt_ic), level);
+    }
+    else if (strcmp(kind, "Return") == 0)
+    {
+        json_value expr = ast_emit_member(node, "expr", &expr_ic);
+        ast_emit_str(out, expr.type == JSON_OBJECT ? "return " : "return");
+        ast_emit_expr(out, expr);
+        ast_emit_str(out, ";\n");
+    }
+    else if (strcmp(kind, "Break") == 0)
+        ast_emit_str(out, "break;\n");
+    else if (strcmp(kind, "Continue") == 0)
+        ast_emit_str(out, "continue;\n");
+    else if (strcmp(kind, "Goto") == 0)
+    {
+        ast_emit_str(out, "goto ");
+        ast_emit_str(out, ast_emit_string(node, "name", &name_ic));
+        ast_emit_str(out, ";\n");
+    }
+    else if (strcmp(kind, "EmptyStatement") == 0)
+        ast_emit_str(out, ";\n");
+    else if (strcmp(kind, "Assignment") == 0)
+    {
+        // 문장 위치의 대입은 바깥 괄호 없이
+        const char *op = ast_emit_string(node, "op", &op_ic);
+        ast_emit_expr(out, ast_emit_member(node, "lvalue", &lvalue_ic));
+        ast_emit_str(out, " ");
+        ast_emit_str(out, op ? op : "=");
+        ast_emit_str(out, " ");
+        ast_emit_expr(out, ast_emit_member(node, "rvalue", &rvalue_ic));
+        ast_emit_str(out, ";\n");
+    }
+    else if (strcmp(kind, "Typedef") == 0)
+    {
+        ast_emit_str(out, "typedef ");
+        ast_emit_type(out, ast_emit_member(node, "type", &type_ic), ast_emit_string(node, "name", &name_ic));
+        ast_emit_str(out, ";\n");
+    }
+    else if (strcmp(kind, "FuncDef") == 0)
+    {
+        ast_emit_decl(out, ast_emit_member(node, "decl", &decl_ic), true);
+        ast_emit_body(out, ast_emit_member(node, "body", &body_ic), level);
+        ast_emit_str(out, "\n");
+    }
+    else if (strcmp(kind, "FileAST") == 0)
+    {
+        const json_array *ext = ast_emit_array(node, "ext", &ext_ic);
+        for (json_index i = 0; ext != NULL && i <= ext->last_index; i++)
+        {
+            if (i > 0)
+                ast_emit_str(out, "\n");
+            ast_emit_stmt(out, ext->values[i], level);
+        }
+    }
+    else
+    {
+        // 선언, 호출, 증감 등 나머지는 식 문장
+        ast_emit_expr(out, node);
+        ast_emit_str(out, ";\n");
+    }
+    if (closed)
+        ast_emit_str(out, "\n");
+}
+
+bool ast_emit_c(ast_emit_buffer *out, json_value node)
+{
+    ast_emit_stmt(out, node, 0);
+    return !out->failed;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
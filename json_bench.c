@@ -0,0 +1,676 @@
+/*
+ * json_bench.c
+ * reproducible benchmarks for json_c.c. every case builds or reads its own input and
+ * prints wall clock times, so a run before and after a change can be compared directly.
+ *   json_bench strings [MB]     parse one escaped string value of MB megabytes (default 8)
+ *                               with an arena parser and with json_create()
+ *   json_bench readers AST [T]  walk one parsed document from 1, 2, 4 .. T threads at once
+ *                               (default: the number of cores) with inline-cached lookups and
+ *                               ast_index subtree queries; reports the throughput per thread count
+ *   json_bench hugepages AST [N] parse AST with json_parser.huge_page_threshold off and on, then
+ *                               walk it N times (default 20) in tree order and in random node
+ *                               order; reports time, AnonHugePages and dTLB load misses (linux)
+ *   json_bench handoff AST [N]  parse AST N times (default 50) on a producer thread, detach each document
+ *                               and walk and free it on the consumer thread, with and without a chunk pool
+ *   json_bench mutate [N]       check json_object_set/delete and json_array_push/insert/set/delete on
+ *                               arena and json_create() documents, the refusal on hash-consed ones,
+ *                               and time N appends (default 1000000)
+ *   json_bench large [GB] [PATH]  write a document of GB gigabytes (default 5) to PATH (default
+ *                               /tmp/json_bench_large.json), parse it and check the records past 4 GB
+ *
+ * build:
+ *   gcc -O2 json_bench.c -o json_bench -pthread
+ */
+
+#define _FILE_OFFSET_BITS 64
+
+#include "json_c.c"
+#include "ast_analyzer.c"
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define JSON_BENCH_RUNS 3
+
+static double json_bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/*
+ * strings: the unescaping buffer grows geometrically (json_strbuf), so a string of n bytes
+ * costs O(n) copies. a builder that grows by a constant step is quadratic here.
+ */
+static int json_bench_strings(int argc, char* argv[]) {
+    size_t mb = argc > 0 ? (size_t)atol(argv[0]) : 8;
+    if (mb == 0) mb = 8;
+    //plain text with an escape every few bytes, so both the copy runs and the escape path are hit
+    static const char piece[] = "abcdefghijklmnopqrstuvwxyz0123456789 \\\"\\n\\t\\u00e9\\\\";
+    size_t piece_size = sizeof(piece) - 1;
+    size_t count = mb * 1024 * 1024 / piece_size;
+    char* message = (char *)malloc(count * piece_size + 5);
+    if (message == NULL) {
+        fprintf(stderr, "json_bench error: malloc error\n");
+        return 1;
+    }
+    size_t pos = 0;
+    message[pos++] = '[';
+    message[pos++] = '"';
+    for (size_t i = 0; i < count; i++, pos += piece_size) memcpy(message + pos, piece, piece_size);
+    message[pos++] = '"';
+    message[pos++] = ']';
+    message[pos] = '\0';
+
+    json_parser p;
+    json_parser_init(&p);
+    double best_arena = 0, best_heap = 0;
+    size_t length = 0;
+    for (int run = 0; run < JSON_BENCH_RUNS; run++) {
+        double start = json_bench_now();
+        json_value v = json_parser_parse(&p, message);
+        double arena = json_bench_now() - start;
+        const char* str = v.type == JSON_ARRAY ? json_string_of(&((json_array *)v.value)->values[0]) : NULL;
+        length = str != NULL ? strlen(str) : 0;
+
+        start = json_bench_now();
+        json_value h = json_create(message);
+        double heap = json_bench_now() - start;
+        json_free(h);
+        if (run == 0 || arena < best_arena) best_arena = arena;
+        if (run == 0 || heap < best_heap) best_heap = heap;
+    }
+    printf("strings: %.1f MB of JSON text -> %.1f MB string\n", (double)pos / (1024 * 1024), (double)length / (1024 * 1024));
+    printf("  arena parser : %.3fs (%.0f MB/s)\n", best_arena, (double)pos / (1024 * 1024) / best_arena);
+    printf("  json_create  : %.3fs (%.0f MB/s)\n", best_heap, (double)pos / (1024 * 1024) / best_heap);
+    json_parser_free(&p);
+    free(message);
+    return length > 0 ? 0 : 1;
+}
+
+//reads the whole file into a NUL terminated buffer
+static char* json_bench_read_file(const char* path, size_t* size) {
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "json_bench error: cannot open %s\n", path);
+        return NULL;
+    }
+    //off_t, so files past 2 GB are not truncated
+    fseeko(fp, 0, SEEK_END);
+    off_t length = ftello(fp);
+    fseeko(fp, 0, SEEK_SET);
+    if (length < 0 || (uint64_t)length >= SIZE_MAX) {
+        fclose(fp);
+        fprintf(stderr, "json_bench error: cannot get the size of %s\n", path);
+        return NULL;
+    }
+    char* text = (char *)malloc((size_t)length + 1);
+    if (text == NULL) {
+        fclose(fp);
+        fprintf(stderr, "json_bench error: malloc error\n");
+        return NULL;
+    }
+    *size = fread(text, 1, (size_t)length, fp);
+    text[*size] = '\0';
+    fclose(fp);
+    return text;
+}
+
+/*
+ * readers: the read API keeps no shared mutable state (inline caches are thread local and
+ * ast_index publishes its lazily built arrays atomically), so throughput should grow with
+ * the thread count up to the number of cores. every thread must get the same checksum.
+ */
+#define JSON_BENCH_READER_WALKS 8
+typedef struct json_bench_reader_s {
+    pthread_t thread;
+    json_value root;
+    ast_index* index;
+    int64_t checksum;
+} json_bench_reader;
+
+static int64_t json_bench_reader_walk(json_value v, ast_index* index) {
+    static JSON_THREAD_LOCAL json_inline_cache nodetype_ic;
+    int64_t sum = 1;
+    if (v.type == JSON_OBJECT) {
+        json_object* o = (json_object *)v.value;
+        const json_value* nodetype = json_get_ic(v, "_nodetype", &nodetype_ic);
+        if (nodetype != NULL && json_is_string(*nodetype) && strcmp(json_string_of(nodetype), "FuncDef") == 0) {
+            json_index pre = ast_index_preorder(index, v);
+            sum += ast_index_count_kind(index, pre, "If") + ast_index_count_kind(index, pre, "FuncCall");
+        }
+        for (json_index i = 0; i <= o->last_index; i++) sum += json_bench_reader_walk(o->values[i], index);
+    }
+    else if (v.type == JSON_ARRAY) {
+        json_array* a = (json_array *)v.value;
+        for (json_index i = 0; i <= a->last_index; i++) sum += json_bench_reader_walk(a->values[i], index);
+    }
+    return sum;
+}
+static void* json_bench_reader_run(void* arg) {
+    json_bench_reader* r = (json_bench_reader *)arg;
+    json_set_quiet(true);
+    r->checksum = 0;
+    for (int walk = 0; walk < JSON_BENCH_READER_WALKS; walk++) r->checksum += json_bench_reader_walk(r->root, r->index);
+    return NULL;
+}
+static int json_bench_readers(int argc, char* argv[]) {
+    if (argc < 1) {
+        fprintf(stderr, "usage: json_bench readers AST [threads]\n");
+        return 1;
+    }
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = argc > 1 ? atoi(argv[1]) : (int)(cores > 0 ? cores : 1);
+    if (max_threads < 1) max_threads = 1;
+    size_t size;
+    char* text = json_bench_read_file(argv[0], &size);
+    if (text == NULL) return 1;
+    json_parser p;
+    json_parser_init(&p);
+    p.inline_strings = true;
+    json_value root = json_parser_parse(&p, text);
+    json_bench_reader* readers = (json_bench_reader *)calloc((size_t)max_threads, sizeof(json_bench_reader));
+    if (root.type == JSON_UNDEFINED || readers == NULL) {
+        fprintf(stderr, "json_bench error: cannot parse %s\n", argv[0]);
+        json_parser_free(&p);
+        free(text);
+        free(readers);
+        return 1;
+    }
+    printf("readers: %s, %ld cores, %d walks per thread\n", argv[0], cores, JSON_BENCH_READER_WALKS);
+    int status = 0;
+    double single = 0;
+    for (int threads = 1; ; threads = threads * 2 < max_threads ? threads * 2 : max_threads) {
+        //a fresh index per round, so its prefix arrays are built by racing readers
+        ast_index index;
+        if (!ast_index_build(&index, root)) {
+            fprintf(stderr, "json_bench error: malloc error\n");
+            status = 1;
+            break;
+        }
+        double start = json_bench_now();
+        int started = 0;
+        for (; started < threads; started++) {
+            readers[started].root = root;
+            readers[started].index = &index;
+            if (pthread_create(&readers[started].thread, NULL, json_bench_reader_run, &readers[started]) != 0) break;
+        }
+        for (int t = 0; t < started; t++) pthread_join(readers[t].thread, NULL);
+        double elapsed = json_bench_now() - start;
+        ast_index_free(&index);
+        for (int t = 1; t < started; t++)
+            if (readers[t].checksum != readers[0].checksum) status = 1;
+        double rate = (double)started * JSON_BENCH_READER_WALKS / elapsed;
+        if (threads == 1) single = rate;
+        printf("  %3d threads : %.3fs, %.1f walks/s (x%.2f)%s\n", started, elapsed, rate, rate / single,
+               status != 0 ? "  CHECKSUM MISMATCH" : "");
+        if (started < threads || status != 0 || threads == max_threads) break;
+    }
+    free(readers);
+    json_parser_free(&p);
+    free(text);
+    return status;
+}
+
+/*
+ * hugepages: arena chunks past json_parser.huge_page_threshold are 2 MB aligned and advised
+ * as transparent huge pages. a traversal of a large document then needs far fewer TLB
+ * entries; the random order walk is the worst case for small pages.
+ */
+#define JSON_BENCH_TLB_UNAVAILABLE -1
+//a dTLB load miss counter for this thread, or -1 where perf events are not permitted
+static int json_bench_tlb_open(void) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0x00, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return JSON_BENCH_TLB_UNAVAILABLE;
+#endif
+}
+static void json_bench_tlb_start(int fd) {
+#ifdef __linux__
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+static long long json_bench_tlb_stop(int fd) {
+    long long misses = JSON_BENCH_TLB_UNAVAILABLE;
+#ifdef __linux__
+    if (fd < 0) return misses;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &misses, sizeof(misses)) != sizeof(misses)) misses = JSON_BENCH_TLB_UNAVAILABLE;
+#endif
+    return misses;
+}
+//AnonHugePages of the process in kB, -1 when unknown
+static long json_bench_huge_kb(void) {
+    FILE* fp = fopen("/proc/self/smaps_rollup", "r");
+    if (fp == NULL) return -1;
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), fp) != NULL)
+        if (strncmp(line, "AnonHugePages:", 14) == 0) kb = atol(line + 14);
+    fclose(fp);
+    return kb;
+}
+typedef struct json_bench_nodes_s {
+    void** nodes;                     //json_object* / json_array*, tagged with the low bit for arrays
+    size_t count;
+    size_t capacity;
+} json_bench_nodes;
+static bool json_bench_collect(json_bench_nodes* n, json_value v) {
+    if (v.type != JSON_OBJECT && v.type != JSON_ARRAY) return true;
+    if (n->count == n->capacity) {
+        size_t capacity = n->capacity ? n->capacity * 2 : 1024;
+        void** nodes = (void **)realloc(n->nodes, sizeof(void *) * capacity);
+        if (nodes == NULL) return false;
+        n->nodes = nodes;
+        n->capacity = capacity;
+    }
+    n->nodes[n->count++] = (void *)((uintptr_t)v.value | (v.type == JSON_ARRAY));
+    json_index last = json_len(v) - 1;
+    json_value* values = v.type == JSON_OBJECT ? ((json_object *)v.value)->values : ((json_array *)v.value)->values;
+    for (json_index i = 0; i <= last; i++)
+        if (!json_bench_collect(n, values[i])) return false;
+    return true;
+}
+static int64_t json_bench_tree_walk(json_value v) {
+    int64_t sum = 1;
+    if (v.type == JSON_OBJECT) {
+        json_object* o = (json_object *)v.value;
+        for (json_index i = 0; i <= o->last_index; i++) sum += json_bench_tree_walk(o->values[i]);
+    }
+    else if (v.type == JSON_ARRAY) {
+        json_array* a = (json_array *)v.value;
+        for (json_index i = 0; i <= a->last_index; i++) sum += json_bench_tree_walk(a->values[i]);
+    }
+    return sum;
+}
+//visits every node once in the order of a multiplicative permutation and reads its first member
+static int64_t json_bench_random_walk(const json_bench_nodes* n) {
+    int64_t sum = 0;
+    //a long stride coprime with count visits every node exactly once
+    size_t step = 2654435761u % n->count;
+    for (;; step++) {
+        size_t a = n->count, b = step;
+        while (b != 0) {
+            size_t r = a % b;
+            a = b;
+            b = r;
+        }
+        if (a == 1 || n->count == 1) break;
+    }
+    for (size_t i = 0, k = 0; i < n->count; i++, k = (k + step) % n->count) {
+        uintptr_t tagged = (uintptr_t)n->nodes[k];
+        if (tagged & 1) {
+            json_array* a = (json_array *)(tagged & ~(uintptr_t)1);
+            sum += a->last_index + (a->last_index >= 0 ? a->values[0].type : 0);
+        }
+        else {
+            json_object* o = (json_object *)tagged;
+            sum += o->last_index + (o->last_index >= 0 ? o->values[0].type : 0);
+        }
+    }
+    return sum;
+}
+static int json_bench_hugepages(int argc, char* argv[]) {
+    if (argc < 1) {
+        fprintf(stderr, "usage: json_bench hugepages AST [walks]\n");
+        return 1;
+    }
+    int walks = argc > 1 ? atoi(argv[1]) : 20;
+    if (walks < 1) walks = 1;
+    size_t size;
+    char* text = json_bench_read_file(argv[0], &size);
+    if (text == NULL) return 1;
+    int tlb = json_bench_tlb_open();
+    printf("hugepages: %s (%.1f MB), %d walks%s\n", argv[0], (double)size / (1024 * 1024), walks,
+           tlb < 0 ? ", dTLB counter unavailable (perf_event_paranoid or no PMU)" : "");
+    int status = 0;
+    for (int on = 0; on <= 1 && status == 0; on++) {
+        json_parser p;
+        json_parser_init(&p);
+        p.huge_page_threshold = on ? JSON_ARENA_HUGE_PAGE_THRESHOLD : 0;
+        long huge_before = json_bench_huge_kb();
+        json_value root = json_parser_parse(&p, text);
+        long huge_after = json_bench_huge_kb();
+        json_bench_nodes nodes = {NULL, 0, 0};
+        if (root.type == JSON_UNDEFINED || !json_bench_collect(&nodes, root) || nodes.count == 0) {
+            fprintf(stderr, "json_bench error: cannot parse %s\n", argv[0]);
+            status = 1;
+        }
+        else {
+            int64_t checksum = 0;
+            json_bench_tlb_start(tlb);
+            double start = json_bench_now();
+            for (int w = 0; w < walks; w++) checksum += json_bench_tree_walk(root);
+            double tree = json_bench_now() - start;
+            long long tree_misses = json_bench_tlb_stop(tlb);
+            json_bench_tlb_start(tlb);
+            start = json_bench_now();
+            for (int w = 0; w < walks; w++) checksum += json_bench_random_walk(&nodes);
+            double random = json_bench_now() - start;
+            long long random_misses = json_bench_tlb_stop(tlb);
+            printf("  huge pages %-3s: arena %.1f MB, AnonHugePages +%ld kB\n", on ? "on" : "off",
+                   (double)p.arena_size / (1024 * 1024), huge_after >= 0 ? huge_after - huge_before : 0);
+            char tree_text[32] = "n/a", random_text[32] = "n/a";
+            if (tree_misses >= 0) snprintf(tree_text, sizeof(tree_text), "%lld", tree_misses);
+            if (random_misses >= 0) snprintf(random_text, sizeof(random_text), "%lld", random_misses);
+            printf("    tree order   : %.3fs, dTLB load misses %s\n", tree, tree_text);
+            printf("    random order : %.3fs, dTLB load misses %s  (checksum %lld)\n", random, random_text, (long long)checksum);
+        }
+        free(nodes.nodes);
+        json_parser_free(&p);
+    }
+    if (tlb >= 0) close(tlb);
+    free(text);
+    return status;
+}
+
+/*
+ * handoff: a producer thread parses and json_parser_detach()es documents, the consumer walks
+ * them and json_document_free()s them from its own thread. with a pool the chunks travel back
+ * through the pool's lock-free returned stack and are parsed into again, so the producer stops
+ * calling malloc after the first few documents. both runs must give the same checksum.
+ */
+#define JSON_BENCH_HANDOFF_DEPTH 2
+typedef struct json_bench_handoff_queue_s {
+    const char* text;
+    int documents;
+    bool pooled;
+    json_document queue[JSON_BENCH_HANDOFF_DEPTH];
+    int produced;                     //written by the producer only
+    int consumed;                     //written by the consumer only
+    size_t pooled_chunks;             //chunks the pool held when the producer closed it
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} json_bench_handoff_queue;
+static void* json_bench_handoff_produce(void* arg) {
+    json_bench_handoff_queue* h = (json_bench_handoff_queue *)arg;
+    json_arena_pool pool;
+    json_arena_pool_init(&pool);
+    json_parser p;
+    json_parser_init(&p);
+    p.inline_strings = true;
+    if (h->pooled) p.pool = &pool;
+    for (int d = 0; d < h->documents; d++) {
+        pthread_mutex_lock(&h->lock);
+        while (h->produced - h->consumed == JSON_BENCH_HANDOFF_DEPTH) pthread_cond_wait(&h->changed, &h->lock);
+        pthread_mutex_unlock(&h->lock);
+        json_document doc = json_parser_detach(&p, json_parser_parse(&p, h->text));
+        pthread_mutex_lock(&h->lock);
+        h->queue[h->produced % JSON_BENCH_HANDOFF_DEPTH] = doc;
+        h->produced++;
+        pthread_cond_broadcast(&h->changed);
+        pthread_mutex_unlock(&h->lock);
+    }
+    //the pool is closed on its own thread once every document has come back
+    pthread_mutex_lock(&h->lock);
+    while (h->consumed < h->produced) pthread_cond_wait(&h->changed, &h->lock);
+    pthread_mutex_unlock(&h->lock);
+    json_parser_free(&p);
+    json_arena_chunk* lists[2] = {pool.free_chunks, __atomic_load_n(&pool.returned, __ATOMIC_ACQUIRE)};
+    for (int i = 0; i < 2; i++)
+        for (json_arena_chunk* chunk = lists[i]; chunk != NULL; chunk = chunk->next) h->pooled_chunks++;
+    json_arena_pool_free(&pool);
+    return NULL;
+}
+static int json_bench_handoff(int argc, char* argv[]) {
+    if (argc < 1) {
+        fprintf(stderr, "usage: json_bench handoff AST [documents]\n");
+        return 1;
+    }
+    int documents = argc > 1 ? atoi(argv[1]) : 50;
+    if (documents < 1) documents = 1;
+    size_t size;
+    char* text = json_bench_read_file(argv[0], &size);
+    if (text == NULL) return 1;
+    printf("handoff: %s (%.1f MB), %d documents\n", argv[0], (double)size / (1024 * 1024), documents);
+    int status = 0;
+    int64_t checksums[2] = {0, 0};
+    for (int pooled = 0; pooled <= 1 && status == 0; pooled++) {
+        json_bench_handoff_queue h;
+        memset(&h, 0x00, sizeof(h));
+        h.text = text;
+        h.documents = documents;
+        h.pooled = pooled;
+        pthread_mutex_init(&h.lock, NULL);
+        pthread_cond_init(&h.changed, NULL);
+        pthread_t producer;
+        double start = json_bench_now();
+        if (pthread_create(&producer, NULL, json_bench_handoff_produce, &h) != 0) {
+            fprintf(stderr, "json_bench error: cannot create a thread\n");
+            status = 1;
+            break;
+        }
+        for (int d = 0; d < documents; d++) {
+            pthread_mutex_lock(&h.lock);
+            while (h.produced == h.consumed) pthread_cond_wait(&h.changed, &h.lock);
+            json_document doc = h.queue[h.consumed % JSON_BENCH_HANDOFF_DEPTH];
+            pthread_mutex_unlock(&h.lock);
+            if (doc.root.type == JSON_UNDEFINED) status = 1;
+            checksums[pooled] += json_bench_tree_walk(doc.root);
+            json_document_free(&doc);
+            pthread_mutex_lock(&h.lock);
+            h.consumed++;
+            pthread_cond_broadcast(&h.changed);
+            pthread_mutex_unlock(&h.lock);
+        }
+        pthread_join(producer, NULL);
+        double elapsed = json_bench_now() - start;
+        pthread_cond_destroy(&h.changed);
+        pthread_mutex_destroy(&h.lock);
+        printf("  %-7s: %.3fs, %.2f ms per document, %zu chunks pooled at exit (checksum %lld)\n", pooled ? "pool" : "no pool",
+               elapsed, elapsed * 1000 / documents, h.pooled_chunks, (long long)checksums[pooled]);
+    }
+    if (status == 0 && checksums[0] != checksums[1]) status = 1;
+    free(text);
+    return status;
+}
+
+/*
+ * mutate: every step is compared against the document it should produce, so the case
+ * fails (exit status 1) on a wrong result. the refused calls print their usual errors.
+ */
+static bool json_bench_expect(json_value v, const char* expected_text, const char* what) {
+    json_value expected = json_create(expected_text);
+    bool same = json_equal(v, expected);
+    json_free(expected);
+    printf("  %-36s: %s\n", what, same ? "ok" : "MISMATCH");
+    return same;
+}
+static bool json_bench_check(bool ok, const char* what) {
+    printf("  %-36s: %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+static int json_bench_mutate(int argc, char* argv[]) {
+    json_index appends = argc > 0 ? (json_index)atoll(argv[0]) : 1000000;
+    if (appends < 1) appends = 1000000;
+    json_value null_value = {JSON_NULL, NULL};
+    bool ok = true;
+    printf("mutate:\n");
+
+    //arena document; inline strings cover values that live inside their json_value
+    json_parser p;
+    json_parser_init(&p);
+    p.inline_strings = true;
+    json_value root = json_parser_parse(&p, "{\"a\":1,\"b\":[1,2,3]}");
+    ok &= json_object_set(&p, root, "a", json_parser_string(&p, "x", 1));
+    ok &= json_bench_expect(root, "{\"a\":\"x\",\"b\":[1,2,3]}", "arena object_set (replace)");
+    ok &= json_object_set(&p, root, "c", null_value);
+    ok &= json_bench_expect(root, "{\"a\":\"x\",\"b\":[1,2,3],\"c\":null}", "arena object_set (new key)");
+    ok &= json_object_delete(&p, root, "a");
+    ok &= json_bench_expect(root, "{\"b\":[1,2,3],\"c\":null}", "arena object_delete");
+    json_value b = json_get(root, "b");
+    ok &= json_array_insert(&p, b, 0, json_parser_string(&p, "s", 1));
+    ok &= json_array_insert(&p, b, 4, json_parser_string(&p, "a long string that is not inline", 32));
+    ok &= json_array_set(&p, b, 2, null_value);
+    ok &= json_array_delete(&p, b, 1);
+    ok &= json_bench_expect(root, "{\"b\":[\"s\",null,3,\"a long string that is not inline\"],\"c\":null}", "arena array insert/set/delete");
+    ok &= json_bench_check(!json_array_set(&p, b, 4, null_value) && !json_array_insert(&p, b, -1, null_value) &&
+                           !json_array_delete(&p, b, 4) && !json_object_delete(&p, root, "a"), "out of range and missing key refused");
+
+    //growth: capacity doubles, so appends are amortized O(1)
+    json_value list = json_parser_parse(&p, "[]");
+    double start = json_bench_now();
+    for (json_index i = 0; i < appends && ok; i++) ok = json_array_push(&p, list, null_value);
+    double arena_time = json_bench_now() - start;
+    ok &= json_bench_check(json_len(list) == appends, "arena array_push growth");
+
+    //json_create() documents: replaced and removed values are json_free()d
+    json_parser hp;
+    json_parser_init(&hp);
+    hp.heap_nodes = true;
+    json_value doc = json_create("{\"a\":[1],\"b\":\"y\"}");
+    ok &= json_object_set(&hp, doc, "a", json_create("\"z\""));
+    ok &= json_object_set(&hp, doc, "c", json_create("[]"));
+    ok &= json_object_delete(&hp, doc, "b");
+    json_value c = json_get(doc, "c");
+    ok &= json_array_push(&hp, c, json_create("1"));
+    ok &= json_array_insert(&hp, c, 0, json_create("{\"k\":true}"));
+    ok &= json_array_set(&hp, c, 1, json_create("2"));
+    ok &= json_array_push(&hp, c, json_create("3"));
+    ok &= json_array_delete(&hp, c, 0);
+    ok &= json_bench_expect(doc, "{\"a\":\"z\",\"c\":[2,3]}", "json_create set/insert/delete");
+    json_value heap_list = json_create("[]");
+    start = json_bench_now();
+    for (json_index i = 0; i < appends && ok; i++) ok = json_array_push(&hp, heap_list, json_create("null"));
+    double heap_time = json_bench_now() - start;
+    ok &= json_bench_check(json_len(heap_list) == appends, "json_create array_push growth");
+    json_free(heap_list);
+    json_free(doc);
+    json_parser_free(&hp);
+
+    //a hash-consed document stays read-only after hash_cons is turned off
+    json_parser cp;
+    json_parser_init(&cp);
+    cp.hash_cons = true;
+    json_value dag = json_parser_parse(&cp, "[[1,2],[1,2]]");
+    cp.hash_cons = false;
+    json_value first = json_get(dag, 0);
+    ok &= json_bench_check(json_same(first, json_get(dag, 1)) && !json_array_push(&cp, first, null_value) &&
+                           !json_array_delete(&cp, dag, 0), "hash-consed document refused");
+    ok &= json_bench_expect(dag, "[[1,2],[1,2]]", "hash-consed document unchanged");
+    json_value tree = json_parser_parse(&cp, "[[1,2],[1,2]]");
+    ok &= json_array_push(&cp, json_get(tree, 0), null_value);
+    ok &= json_bench_expect(tree, "[[1,2,null],[1,2]]", "next document without hash_cons");
+    json_parser_free(&cp);
+
+    printf("  %lld appends: arena %.1f ns, json_create %.1f ns per push\n", (long long)appends,
+           arena_time * 1e9 / (double)appends, heap_time * 1e9 / (double)appends);
+    json_parser_free(&p);
+    return ok ? 0 : 1;
+}
+
+/*
+ * large: sizes, offsets and indices are 64 bit, so a document past 4 GB parses like a small one.
+ * the text is written to a file and mapped rather than read into memory, and the record bodies
+ * are kept as JSON_RAW spans (lazy_key) with lazy numbers, so the case needs little more memory
+ * than the parsed records themselves. the records past 4 GB are read back and checked.
+ */
+#define JSON_BENCH_LARGE_BODY_ITEMS 1000
+static int json_bench_large(int argc, char* argv[]) {
+    uint64_t gb = argc > 0 ? (uint64_t)atol(argv[0]) : 5;
+    if (gb == 0) gb = 5;
+    const char* path = argc > 1 ? argv[1] : "/tmp/json_bench_large.json";
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "json_bench error: cannot open %s\n", path);
+        return 1;
+    }
+    //each record is about 4 kB: {"id":N,"name":"fN","body":{"_nodetype":"Compound","id":N,"items":[...]}}
+    char items[JSON_BENCH_LARGE_BODY_ITEMS * 8];
+    size_t items_size = 0;
+    for (int i = 0; i < JSON_BENCH_LARGE_BODY_ITEMS; i++)
+        items_size += (size_t)sprintf(items + items_size, i ? ",%d" : "%d", i);
+    double start = json_bench_now();
+    uint64_t target = gb << 30, written = 0;
+    int64_t records = 0;
+    bool ok = fputc('[', fp) != EOF;
+    for (; ok && written < target; records++) {
+        char head[128];
+        int n = snprintf(head, sizeof(head), "%s{\"id\":%lld,\"name\":\"f%lld\",\"body\":{\"_nodetype\":\"Compound\",\"id\":%lld,\"items\":[",
+                         records ? ",\n" : "", (long long)records, (long long)records, (long long)records);
+        ok = fwrite(head, 1, (size_t)n, fp) == (size_t)n && fwrite(items, 1, items_size, fp) == items_size && fputs("]}}", fp) != EOF;
+        written += (uint64_t)n + items_size + 3;
+    }
+    //a size that is not a page multiple leaves a zero byte after the mapped text
+    ok = ok && fputs("]\n", fp) != EOF;
+    if (ok && (written + 3) % (uint64_t)sysconf(_SC_PAGESIZE) == 0) ok = fputc('\n', fp) != EOF;
+    ok = fclose(fp) == 0 && ok;
+    double write_time = json_bench_now() - start;
+    int fd = ok ? open(path, O_RDONLY) : -1;
+    struct stat st;
+    char* text = fd >= 0 && fstat(fd, &st) == 0 ? (char *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : (char *)MAP_FAILED;
+    if (fd >= 0) close(fd);
+    if (text == MAP_FAILED) {
+        fprintf(stderr, "json_bench error: cannot write and map %s\n", path);
+        remove(path);
+        return 1;
+    }
+    double size_mb = (double)st.st_size / (1024 * 1024);
+    printf("large: %s, %.1f MB, %lld records (written in %.1fs)\n", path, size_mb, (long long)records, write_time);
+
+    json_parser p;
+    json_parser_init(&p);
+    p.lazy_numbers = true;
+    p.inline_strings = true;
+    p.lazy_key = "body";
+    p.huge_page_threshold = JSON_ARENA_HUGE_PAGE_THRESHOLD;
+    start = json_bench_now();
+    json_value root = json_parser_parse(&p, text);
+    double parse = json_bench_now() - start;
+    int status = root.type == JSON_ARRAY && ((json_array *)root.value)->last_index + 1 == records ? 0 : 1;
+    if (status == 0) {
+        printf("  parse        : %.2fs (%.0f MB/s), arena %.1f MB\n", parse, size_mb / parse, (double)json_parser_memory_usage(&p) / (1024 * 1024));
+        //every record whose body starts past 4 GB must still read back its own id
+        json_array* a = (json_array *)root.value;
+        int64_t checked = 0;
+        for (json_index i = a->last_index; i >= 0 && status == 0; i--) {
+            json_value body = json_get(a->values[i], "body");
+            if (body.type != JSON_RAW || ((json_raw *)body.value)->begin - text < ((ptrdiff_t)1 << 32)) break;
+            body = json_parser_materialize(&p, body);
+            if (json_get_longlongint(a->values[i], "id") != i || json_get_longlongint(body, "id") != i) status = 1;
+            checked++;
+        }
+        printf("  past 4 GB    : %lld records %s\n", (long long)checked, status == 0 ? "checked" : "MISMATCH");
+        if (checked == 0 && gb > 4) status = 1;
+    }
+    else fprintf(stderr, "json_bench error: cannot parse %s\n", path);
+    json_parser_free(&p);
+    munmap(text, (size_t)st.st_size);
+    remove(path);
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "strings") == 0) return json_bench_strings(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "readers") == 0) return json_bench_readers(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "hugepages") == 0) return json_bench_hugepages(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "handoff") == 0) return json_bench_handoff(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "mutate") == 0) return json_bench_mutate(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "large") == 0) return json_bench_large(argc - 2, argv + 2);
+    fprintf(stderr, "usage: json_bench strings [MB]\n"
+                    "       json_bench readers AST [threads]\n"
+                    "       json_bench hugepages AST [walks]\n"
+                    "       json_bench handoff AST [documents]\n"
+                    "       json_bench mutate [appends]\n"
+                    "       json_bench large [GB] [path]\n");
+    return 1;
+}
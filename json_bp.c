@@ -0,0 +1,880 @@
+#ifndef __JSONBP_HEADER__
+#define __JSONBP_HEADER__
+
+/*
+ * json_bp.c
+ * succinct archival encoding of a json document.
+ *  - tree shape : balanced parentheses bitvector (1 = open, 0 = close) in preorder
+ *                 with a rank directory and a range min-max tree over 512-bit blocks
+ *  - node kinds : packed 4-bit array indexed by preorder number
+ *  - labels     : object keys and scalar texts as ids into a front-coded dictionary,
+ *                 stored in bit-packed arrays just wide enough for the dictionary
+ * a node is identified by the position of its open parenthesis. first child and
+ * subtree size are O(1); parent and next sibling run a min-max tree search that is
+ * bounded by one block scan plus O(log n) tree steps.
+ * archives hold ids and offsets only, so json_bp_map() can use a mapped file (or a
+ * memfd shared with forked workers) in place: every process reads the same pages.
+ */
+
+#include "json_c.c"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#define JSON_BP_NONE UINT64_MAX
+#define JSON_BP_BLOCK_BITS 512
+#define JSON_BP_BUCKET 16
+
+typedef enum json_bp_kind_enum { JSON_BP_NULL = 0, JSON_BP_FALSE, JSON_BP_TRUE, JSON_BP_INTEGER, JSON_BP_DOUBLE, JSON_BP_STRING, JSON_BP_ARRAY, JSON_BP_OBJECT } json_bp_kind;
+typedef uint64_t json_bp_node;
+
+//fixed width integer vector
+typedef struct json_bp_packed_s {
+    uint64_t width;
+    uint64_t length;
+    uint64_t* words;
+} json_bp_packed;
+//front-coded sorted string dictionary
+typedef struct json_bp_dict_s {
+    uint64_t count;
+    uint64_t size;                 //bytes in data
+    uint64_t* bucket_offsets;      //start of every JSON_BP_BUCKET-th string in data
+    unsigned char* data;
+} json_bp_dict;
+typedef struct json_bp_s {
+    uint64_t node_count;
+    uint64_t bit_count;            //2 * node_count
+    uint64_t* bits;
+    uint64_t* rank_blocks;         //ones before each block
+    int64_t* tree_min;             //min-max tree: min prefix excess of each node's range
+    int64_t* tree_sum;             //and its total excess
+    uint64_t tree_leaves;
+    uint8_t* kinds;                //two json_bp_kind per byte
+    json_bp_packed keys;           //dictionary id + 1 of the member key, 0 inside arrays
+    json_bp_packed texts;          //dictionary id + 1 of a string or number, 0 otherwise
+    json_bp_dict dict;
+    void* mapping;                 //json_bp_map(): the arrays point into this read-only mapping
+    size_t mapping_size;
+} json_bp;
+
+bool json_bp_build(json_bp* bp, json_value root);
+bool json_bp_write(const json_bp* bp, FILE* fp);
+bool json_bp_read(json_bp* bp, FILE* fp);
+//maps an archive written by json_bp_write() with MAP_SHARED instead of copying it (JSONBP1 archives are
+//read into private memory). fd may be closed afterwards
+bool json_bp_map(json_bp* bp, int fd);
+void json_bp_free(json_bp* bp);
+
+#define json_bp_root(bp) ((json_bp_node)0)
+json_bp_node json_bp_parent(const json_bp* bp, json_bp_node x);
+json_bp_node json_bp_first_child(const json_bp* bp, json_bp_node x);
+json_bp_node json_bp_next_sibling(const json_bp* bp, json_bp_node x);
+uint64_t json_bp_subtree_size(const json_bp* bp, json_bp_node x);
+uint64_t json_bp_preorder(const json_bp* bp, json_bp_node x);
+json_bp_node json_bp_select(const json_bp* bp, uint64_t preorder);
+json_bp_node json_bp_find_close(const json_bp* bp, json_bp_node x);
+
+json_bp_kind json_bp_get_kind(const json_bp* bp, json_bp_node x);
+//copy the key / scalar text of x into buf like snprintf. returns the full length, or -1 if x has none
+int64_t json_bp_key(const json_bp* bp, json_bp_node x, char* buf, size_t bufsize);
+int64_t json_bp_text(const json_bp* bp, json_bp_node x, char* buf, size_t bufsize);
+int64_t json_bp_dict_get(const json_bp_dict* dict, uint64_t id, char* buf, size_t bufsize);
+void json_bp_fprint(FILE* outfp, const json_bp* bp, json_bp_node x, int tab);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#ifndef __JSONBP_BODY__
+#define __JSONBP_BODY__
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+static bool json_bp_bit(const json_bp* bp, uint64_t i) {
+    return (bp->bits[i >> 6] >> (i & 63)) & 1;
+}
+
+/*
+ * packed integer vector
+ */
+static bool json_bp_packed_init(json_bp_packed* v, uint64_t length, uint64_t max_value) {
+    v->width = 1;
+    while (v->width < 64 && (max_value >> v->width) != 0) v->width++;
+    v->length = length;
+    v->words = (uint64_t *)calloc((length * v->width + 63) / 64 + 1, sizeof(uint64_t));
+    if (v->words == NULL) {
+        fprintf(stderr, "json_bp_packed_init error: malloc error\n");
+        return false;
+    }
+    return true;
+}
+static void json_bp_packed_set(json_bp_packed* v, uint64_t i, uint64_t value) {
+    uint64_t pos = i * v->width, word = pos >> 6, shift = pos & 63;
+    uint64_t mask = v->width == 64 ? UINT64_MAX : ((1ULL << v->width) - 1);
+    v->words[word] = (v->words[word] & ~(mask << shift)) | (value << shift);
+    if (shift + v->width > 64)
+        v->words[word + 1] = (v->words[word + 1] & ~(mask >> (64 - shift))) | (value >> (64 - shift));
+}
+static uint64_t json_bp_packed_get(const json_bp_packed* v, uint64_t i) {
+    uint64_t pos = i * v->width, word = pos >> 6, shift = pos & 63;
+    uint64_t mask = v->width == 64 ? UINT64_MAX : ((1ULL << v->width) - 1);
+    uint64_t value = v->words[word] >> shift;
+    if (shift + v->width > 64) value |= v->words[word + 1] << (64 - shift);
+    return value & mask;
+}
+static uint64_t json_bp_packed_words(const json_bp_packed* v) {
+    return (v->length * v->width + 63) / 64 + 1;
+}
+
+/*
+ * rank directory and range min-max tree
+ */
+static uint64_t json_bp_rank1(const json_bp* bp, uint64_t i) {
+    //ones in [0, i)
+    uint64_t block = i / JSON_BP_BLOCK_BITS;
+    uint64_t rank = bp->rank_blocks[block];
+    for (uint64_t w = block * (JSON_BP_BLOCK_BITS / 64); w < (i >> 6); w++)
+        rank += (uint64_t)__builtin_popcountll(bp->bits[w]);
+    if (i & 63) rank += (uint64_t)__builtin_popcountll(bp->bits[i >> 6] & ((1ULL << (i & 63)) - 1));
+    return rank;
+}
+//excess (opens - closes) of the prefix [0, i]
+static int64_t json_bp_excess(const json_bp* bp, uint64_t i) {
+    return 2 * (int64_t)json_bp_rank1(bp, i + 1) - (int64_t)(i + 1);
+}
+static uint64_t json_bp_index_blocks(json_bp* bp) {
+    uint64_t blocks = (bp->bit_count + JSON_BP_BLOCK_BITS - 1) / JSON_BP_BLOCK_BITS + 1;
+    bp->tree_leaves = 1;
+    while (bp->tree_leaves < blocks) bp->tree_leaves *= 2;
+    return blocks;
+}
+//computes the rank directory and min-max tree. with verify set the stored arrays of a loaded
+//archive are compared with the computed values instead: navigation trusts them blindly
+#define JSON_BP_INDEX_PUT(slot, value) do { \
+        if (!verify) (slot) = (value); \
+        else if ((slot) != (value)) return false; \
+    } while (0)
+static bool json_bp_index_pass(json_bp* bp, bool verify) {
+    uint64_t blocks = json_bp_index_blocks(bp);
+    uint64_t rank = 0;
+    for (uint64_t b = 0; b < bp->tree_leaves; b++) {
+        int64_t sum = 0, min = INT64_MAX;
+        if (b < blocks) JSON_BP_INDEX_PUT(bp->rank_blocks[b], rank);
+        for (uint64_t i = b * JSON_BP_BLOCK_BITS; i < (b + 1) * JSON_BP_BLOCK_BITS && i < bp->bit_count; i++) {
+            bool open = json_bp_bit(bp, i);
+            sum += open ? 1 : -1;
+            rank += open;
+            if (sum < min) min = sum;
+        }
+        JSON_BP_INDEX_PUT(bp->tree_min[bp->tree_leaves + b], min);
+        JSON_BP_INDEX_PUT(bp->tree_sum[bp->tree_leaves + b], sum);
+    }
+    for (uint64_t n = bp->tree_leaves - 1; n >= 1; n--) {
+        int64_t left_min = bp->tree_min[2 * n], right_min = bp->tree_min[2 * n + 1];
+        int64_t left_sum = bp->tree_sum[2 * n];
+        if (right_min != INT64_MAX) right_min += left_sum;
+        JSON_BP_INDEX_PUT(bp->tree_min[n], left_min < right_min ? left_min : right_min);
+        JSON_BP_INDEX_PUT(bp->tree_sum[n], left_sum + bp->tree_sum[2 * n + 1]);
+    }
+    return true;
+}
+#undef JSON_BP_INDEX_PUT
+static bool json_bp_build_index(json_bp* bp) {
+    uint64_t blocks = json_bp_index_blocks(bp);
+    bp->rank_blocks = (uint64_t *)malloc(sizeof(uint64_t) * blocks);
+    bp->tree_min = (int64_t *)malloc(sizeof(int64_t) * 2 * bp->tree_leaves);
+    bp->tree_sum = (int64_t *)malloc(sizeof(int64_t) * 2 * bp->tree_leaves);
+    if (bp->rank_blocks == NULL || bp->tree_min == NULL || bp->tree_sum == NULL) {
+        fprintf(stderr, "json_bp_build_index error: malloc error\n");
+        return false;
+    }
+    //slot 0 is unused (the root is 1) but written with the arrays, so it must not be heap garbage
+    bp->tree_min[0] = bp->tree_sum[0] = 0;
+    return json_bp_index_pass(bp, false);
+}
+//smallest j > i with excess(j) == target, or JSON_BP_NONE. target < excess(i)
+static uint64_t json_bp_fwd_search(const json_bp* bp, uint64_t i, int64_t target) {
+    int64_t excess = json_bp_excess(bp, i);
+    uint64_t block = i / JSON_BP_BLOCK_BITS;
+    uint64_t end = (block + 1) * JSON_BP_BLOCK_BITS;
+    for (uint64_t j = i + 1; j < end && j < bp->bit_count; j++) {
+        excess += json_bp_bit(bp, j) ? 1 : -1;
+        if (excess == target) return j;
+    }
+    //climb until a right sibling range can reach the target, then descend into it
+    uint64_t n = bp->tree_leaves + block;
+    while (n > 1) {
+        if ((n & 1) == 0 && bp->tree_min[n + 1] != INT64_MAX && excess + bp->tree_min[n + 1] <= target) {
+            n = n + 1;
+            break;
+        }
+        if ((n & 1) == 0) excess += bp->tree_sum[n + 1];
+        n >>= 1;
+    }
+    if (n == 1) return JSON_BP_NONE;
+    while (n < bp->tree_leaves) {
+        if (bp->tree_min[2 * n] != INT64_MAX && excess + bp->tree_min[2 * n] <= target) n = 2 * n;
+        else {
+            excess += bp->tree_sum[2 * n];
+            n = 2 * n + 1;
+        }
+    }
+    for (uint64_t j = (n - bp->tree_leaves) * JSON_BP_BLOCK_BITS; j < bp->bit_count; j++) {
+        excess += json_bp_bit(bp, j) ? 1 : -1;
+        if (excess == target) return j;
+    }
+    return JSON_BP_NONE;
+}
+//largest j < i with excess(j) == target, where excess(-1) == 0 is reported as
+//JSON_BP_BEFORE_START. like the forward search this needs target < excess(i)
+#define JSON_BP_BEFORE_START (UINT64_MAX - 1)
+static uint64_t json_bp_bwd_search(const json_bp* bp, uint64_t i, int64_t target) {
+    int64_t excess = json_bp_excess(bp, i);
+    uint64_t block = i / JSON_BP_BLOCK_BITS;
+    uint64_t start = block * JSON_BP_BLOCK_BITS;
+    //excess(j - 1) = excess(j) - delta(j)
+    for (uint64_t j = i; j > start; j--) {
+        excess -= json_bp_bit(bp, j) ? 1 : -1;
+        if (excess == target) return j - 1;
+    }
+    excess -= json_bp_bit(bp, start) ? 1 : -1;
+    if (excess == target) return start == 0 ? JSON_BP_BEFORE_START : start - 1;
+    //excess is the value at the end of every left range we look at. values move by
+    //one per bit, so a range whose minimum reaches the target contains it.
+    uint64_t n = bp->tree_leaves + block;
+    while (n > 1) {
+        if ((n & 1) == 1) {
+            if (excess - bp->tree_sum[n - 1] + bp->tree_min[n - 1] <= target) {
+                n = n - 1;
+                break;
+            }
+            excess -= bp->tree_sum[n - 1];
+        }
+        n >>= 1;
+    }
+    if (n == 1) return target == 0 ? JSON_BP_BEFORE_START : JSON_BP_NONE;
+    while (n < bp->tree_leaves) {
+        uint64_t right = 2 * n + 1;
+        if (bp->tree_min[right] != INT64_MAX && excess - bp->tree_sum[right] + bp->tree_min[right] <= target)
+            n = right;
+        else {
+            excess -= bp->tree_sum[right];
+            n = 2 * n;
+        }
+    }
+    uint64_t first = (n - bp->tree_leaves) * JSON_BP_BLOCK_BITS;
+    for (uint64_t j = first + JSON_BP_BLOCK_BITS - 1; ; j--) {
+        if (excess == target) return j;
+        excess -= json_bp_bit(bp, j) ? 1 : -1;
+        if (j == first) break;
+    }
+    return first == 0 ? JSON_BP_BEFORE_START : first - 1;
+}
+
+json_bp_node json_bp_find_close(const json_bp* bp, json_bp_node x) {
+    if (x >= bp->bit_count) return JSON_BP_NONE;
+    return json_bp_fwd_search(bp, x, json_bp_excess(bp, x) - 1);
+}
+json_bp_node json_bp_parent(const json_bp* bp, json_bp_node x) {
+    if (x == 0 || x >= bp->bit_count) return JSON_BP_NONE;
+    uint64_t j = json_bp_bwd_search(bp, x, json_bp_excess(bp, x) - 2);
+    if (j == JSON_BP_NONE) return JSON_BP_NONE;
+    return j == JSON_BP_BEFORE_START ? 0 : j + 1;
+}
+json_bp_node json_bp_first_child(const json_bp* bp, json_bp_node x) {
+    if (x + 1 < bp->bit_count && json_bp_bit(bp, x + 1)) return x + 1;
+    return JSON_BP_NONE;
+}
+json_bp_node json_bp_next_sibling(const json_bp* bp, json_bp_node x) {
+    uint64_t close = json_bp_find_close(bp, x);
+    if (close == JSON_BP_NONE || close + 1 >= bp->bit_count || !json_bp_bit(bp, close + 1)) return JSON_BP_NONE;
+    return close + 1;
+}
+uint64_t json_bp_subtree_size(const json_bp* bp, json_bp_node x) {
+    uint64_t close = json_bp_find_close(bp, x);
+    return close == JSON_BP_NONE ? 0 : (close - x + 1) / 2;
+}
+uint64_t json_bp_preorder(const json_bp* bp, json_bp_node x) {
+    return json_bp_rank1(bp, x);
+}
+json_bp_node json_bp_select(const json_bp* bp, uint64_t preorder) {
+    if (preorder >= bp->node_count) return JSON_BP_NONE;
+    //binary search the rank directory, then scan words inside the block
+    uint64_t lo = 0, hi = (bp->bit_count + JSON_BP_BLOCK_BITS - 1) / JSON_BP_BLOCK_BITS;
+    while (hi - lo > 1) {
+        uint64_t mid = (lo + hi) / 2;
+        if (bp->rank_blocks[mid] <= preorder) lo = mid;
+        else hi = mid;
+    }
+    uint64_t rank = bp->rank_blocks[lo];
+    for (uint64_t w = lo * (JSON_BP_BLOCK_BITS / 64); ; w++) {
+        uint64_t ones = (uint64_t)__builtin_popcountll(bp->bits[w]);
+        if (rank + ones > preorder) {
+            uint64_t word = bp->bits[w];
+            for (uint64_t k = preorder - rank; k > 0; k--) word &= word - 1;
+            return w * 64 + (uint64_t)__builtin_ctzll(word);
+        }
+        rank += ones;
+    }
+}
+
+json_bp_kind json_bp_get_kind(const json_bp* bp, json_bp_node x) {
+    uint64_t pre = json_bp_preorder(bp, x);
+    return (json_bp_kind)((bp->kinds[pre >> 1] >> ((pre & 1) * 4)) & 0xF);
+}
+
+/*
+ * front-coded dictionary
+ * bucket head : varint length, bytes
+ * other       : varint shared prefix length, varint suffix length, suffix bytes
+ */
+static size_t json_bp_put_varint(unsigned char* out, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (unsigned char)v;
+    return n;
+}
+//false when the varint runs past end (a corrupted archive)
+static bool json_bp_get_varint(const unsigned char** in, const unsigned char* end, uint64_t* v) {
+    uint64_t value = 0;
+    for (int shift = 0; *in < end && shift < 64; shift += 7) {
+        unsigned char byte = *(*in)++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *v = value;
+            return true;
+        }
+    }
+    return false;
+}
+int64_t json_bp_dict_get(const json_bp_dict* dict, uint64_t id, char* buf, size_t bufsize) {
+    if (id >= dict->count) return -1;
+    const unsigned char* end = dict->data + dict->size;
+    const unsigned char* in = dict->data + dict->bucket_offsets[id / JSON_BP_BUCKET];
+    uint64_t first;
+    if (!json_bp_get_varint(&in, end, &first) || first > (uint64_t)(end - in)) return -1;
+    //decode into a scratch string the size of the longest prefix seen so far
+    char small[256];
+    char* cur = small;
+    size_t cap = sizeof(small), len = (size_t)first;
+    if (len + 1 > cap) {
+        cap = len + 1;
+        cur = (char *)malloc(cap);
+        if (cur == NULL) return -1;
+    }
+    memcpy(cur, in, len);
+    in += len;
+    for (uint64_t k = id % JSON_BP_BUCKET; k > 0; k--) {
+        uint64_t shared, suffix;
+        if (!json_bp_get_varint(&in, end, &shared) || !json_bp_get_varint(&in, end, &suffix)
+            || shared > len || suffix > (uint64_t)(end - in)) {
+            if (cur != small) free(cur);
+            return -1;
+        }
+        if (shared + suffix + 1 > cap) {
+            size_t grown = (size_t)(shared + suffix + 1) * 2;
+            char* next = (char *)malloc(grown);
+            if (next == NULL) {
+                if (cur != small) free(cur);
+                return -1;
+            }
+            memcpy(next, cur, (size_t)shared);
+            if (cur != small) free(cur);
+            cur = next;
+            cap = grown;
+        }
+        memcpy(cur + shared, in, (size_t)suffix);
+        in += suffix;
+        len = (size_t)(shared + suffix);
+    }
+    if (bufsize > 0) {
+        size_t n = len < bufsize - 1 ? len : bufsize - 1;
+        memcpy(buf, cur, n);
+        buf[n] = '\0';
+    }
+    if (cur != small) free(cur);
+    return (int64_t)len;
+}
+static int json_bp_strcmp(const void* a, const void* b) {
+    return strcmp(*(const char* const *)a, *(const char* const *)b);
+}
+static bool json_bp_dict_build(json_bp_dict* dict, char** strings, uint64_t count) {
+    memset(dict, 0x00, sizeof(json_bp_dict));
+    size_t bytes = 0;
+    for (uint64_t i = 0; i < count; i++) bytes += strlen(strings[i]) + 20;
+    dict->count = count;
+    dict->bucket_offsets = (uint64_t *)malloc(sizeof(uint64_t) * ((count + JSON_BP_BUCKET - 1) / JSON_BP_BUCKET + 1));
+    dict->data = (unsigned char *)malloc(bytes + 1);
+    if (dict->bucket_offsets == NULL || dict->data == NULL) {
+        fprintf(stderr, "json_bp_dict_build error: malloc error\n");
+        return false;
+    }
+    size_t pos = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        size_t len = strlen(strings[i]);
+        if (i % JSON_BP_BUCKET == 0) {
+            dict->bucket_offsets[i / JSON_BP_BUCKET] = pos;
+            pos += json_bp_put_varint(dict->data + pos, len);
+            memcpy(dict->data + pos, strings[i], len);
+            pos += len;
+        }
+        else {
+            size_t shared = 0;
+            while (strings[i - 1][shared] != '\0' && strings[i - 1][shared] == strings[i][shared]) shared++;
+            pos += json_bp_put_varint(dict->data + pos, shared);
+            pos += json_bp_put_varint(dict->data + pos, len - shared);
+            memcpy(dict->data + pos, strings[i] + shared, len - shared);
+            pos += len - shared;
+        }
+    }
+    dict->size = pos;
+    return true;
+}
+
+/*
+ * build
+ */
+typedef struct json_bp_builder_s {
+    json_bp* bp;
+    uint64_t pos;                  //next bit
+    uint64_t pre;                  //next preorder number
+    char** strings;                //every key and scalar text, in preorder, before sorting
+    uint64_t string_count;
+    uint64_t string_capacity;
+    char numbuf[64];
+} json_bp_builder;
+
+static uint64_t json_bp_count_nodes(json_value v) {
+    uint64_t n = 1;
+    if (v.type == JSON_ARRAY) {
+        json_array* a = (json_array *)v.value;
+        for (json_index i = 0; i <= a->last_index; i++) n += json_bp_count_nodes(a->values[i]);
+    }
+    else if (v.type == JSON_OBJECT) {
+        json_object* o = (json_object *)v.value;
+        for (json_index i = 0; i <= o->last_index; i++) n += json_bp_count_nodes(o->values[i]);
+    }
+    return n;
+}
+static json_bp_kind json_bp_kind_of(json_value v) {
+    if (v.type & JSON_NUMBER) return (v.type & JSON_DOUBLE) ? JSON_BP_DOUBLE : JSON_BP_INTEGER;
+    if (json_is_string(v)) return JSON_BP_STRING;
+    switch (v.type) {
+        case JSON_BOOLEAN: return *((bool *)v.value) ? JSON_BP_TRUE : JSON_BP_FALSE;
+        case JSON_ARRAY: return JSON_BP_ARRAY;
+        case JSON_OBJECT: return JSON_BP_OBJECT;
+        default: return JSON_BP_NULL;
+    }
+}
+//text form of a scalar; numbers are kept as text so the archive round-trips exactly
+static const char * json_bp_scalar_text(json_bp_builder* b, json_value v) {
+    if (v.type == JSON_STRING) return (const char *)v.value;
+    //an inline string lives in this copy of the value, so it is copied out as well
+    if (v.type == (JSON_STRING|JSON_INLINE)) return strcpy(b->numbuf, json_string_of(&v));
+    //lazy numbers are converted too, so the archive text does not depend on the parser options
+    if ((v.type & JSON_NUMBER) && (v.type & JSON_INTEGER)) {
+        snprintf(b->numbuf, sizeof(b->numbuf), "%lld", json_to_longlongint(v));
+        return b->numbuf;
+    }
+    if ((v.type & JSON_NUMBER) && (v.type & JSON_DOUBLE)) {
+        snprintf(b->numbuf, sizeof(b->numbuf), "%.17g", json_to_double(v));
+        return b->numbuf;
+    }
+    return NULL;
+}
+static bool json_bp_collect(json_bp_builder* b, const char* str) {
+    if (b->string_count == b->string_capacity) {
+        uint64_t capacity = b->string_capacity ? b->string_capacity * 2 : 1024;
+        char** strings = (char **)realloc(b->strings, sizeof(char *) * capacity);
+        if (strings == NULL) return false;
+        b->strings = strings;
+        b->string_capacity = capacity;
+    }
+    b->strings[b->string_count] = strdup(str);
+    return b->strings[b->string_count++] != NULL;
+}
+static uint64_t json_bp_lookup(char** sorted, uint64_t count, const char* str) {
+    uint64_t lo = 0, hi = count;
+    while (lo < hi) {
+        uint64_t mid = (lo + hi) / 2;
+        int cmp = strcmp(sorted[mid], str);
+        if (cmp == 0) return mid;
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return JSON_BP_NONE;
+}
+//pass 1 (sorted == NULL) collects strings, pass 2 writes shape, kinds and label ids
+static bool json_bp_encode(json_bp_builder* b, json_value v, const char* key, char** sorted, uint64_t count) {
+    json_bp* bp = b->bp;
+    const char* text = json_bp_scalar_text(b, v);
+    if (sorted == NULL) {
+        if (key != NULL && !json_bp_collect(b, key)) return false;
+        if (text != NULL && !json_bp_collect(b, text)) return false;
+    }
+    else {
+        uint64_t pre = b->pre++;
+        bp->bits[b->pos >> 6] |= 1ULL << (b->pos & 63);
+        b->pos++;
+        bp->kinds[pre >> 1] |= (uint8_t)(json_bp_kind_of(v) << ((pre & 1) * 4));
+        if (key != NULL) json_bp_packed_set(&bp->keys, pre, json_bp_lookup(sorted, count, key) + 1);
+        if (text != NULL) json_bp_packed_set(&bp->texts, pre, json_bp_lookup(sorted, count, text) + 1);
+    }
+    if (v.type == JSON_ARRAY) {
+        json_array* a = (json_array *)v.value;
+        for (json_index i = 0; i <= a->last_index; i++)
+            if (!json_bp_encode(b, a->values[i], NULL, sorted, count)) return false;
+    }
+    else if (v.type == JSON_OBJECT) {
+        json_object* o = (json_object *)v.value;
+        for (json_index i = 0; i <= o->last_index; i++)
+            if (!json_bp_encode(b, o->values[i], o->keys[i], sorted, count)) return false;
+    }
+    if (sorted != NULL) b->pos++;  //close parenthesis is a zero bit
+    return true;
+}
+
+bool json_bp_build(json_bp* bp, json_value root) {
+    memset(bp, 0x00, sizeof(json_bp));
+    json_bp_builder b;
+    memset(&b, 0x00, sizeof(json_bp_builder));
+    b.bp = bp;
+    bool ok = json_bp_encode(&b, root, NULL, NULL, 0);
+
+    //sort and deduplicate the collected strings into the dictionary order
+    uint64_t unique = 0;
+    if (ok && b.string_count > 0) {
+        qsort(b.strings, b.string_count, sizeof(char *), json_bp_strcmp);
+        for (uint64_t i = 0; i < b.string_count; i++) {
+            if (unique > 0 && strcmp(b.strings[unique - 1], b.strings[i]) == 0) free(b.strings[i]);
+            else b.strings[unique++] = b.strings[i];
+        }
+    }
+    if (ok) {
+        bp->node_count = json_bp_count_nodes(root);
+        bp->bit_count = 2 * bp->node_count;
+        bp->bits = (uint64_t *)calloc(bp->bit_count / 64 + 2, sizeof(uint64_t));
+        bp->kinds = (uint8_t *)calloc(bp->node_count / 2 + 1, sizeof(uint8_t));
+        ok = bp->bits != NULL && bp->kinds != NULL
+            && json_bp_packed_init(&bp->keys, bp->node_count, unique)
+            && json_bp_packed_init(&bp->texts, bp->node_count, unique)
+            && json_bp_dict_build(&bp->dict, b.strings, unique);
+    }
+    if (ok) ok = json_bp_encode(&b, root, NULL, b.strings, unique);
+    if (ok) ok = json_bp_build_index(bp);
+
+    for (uint64_t i = 0; i < unique; i++) free(b.strings[i]);
+    free(b.strings);
+    if (!ok) {
+        fprintf(stderr, "json_bp_build error: cannot encode the document\n");
+        json_bp_free(bp);
+    }
+    return ok;
+}
+
+void json_bp_free(json_bp* bp) {
+    if (bp->mapping != NULL) {
+        munmap(bp->mapping, bp->mapping_size);
+        memset(bp, 0x00, sizeof(json_bp));
+        return;
+    }
+    free(bp->bits);
+    free(bp->rank_blocks);
+    free(bp->tree_min);
+    free(bp->tree_sum);
+    free(bp->kinds);
+    free(bp->keys.words);
+    free(bp->texts.words);
+    free(bp->dict.bucket_offsets);
+    free(bp->dict.data);
+    memset(bp, 0x00, sizeof(json_bp));
+}
+
+/*
+ * file format (little endian, host layout)
+ * "JSONBP2\0", node_count, key width, text width, dict count, dict size,
+ * bits, kinds (zero padded to 8 bytes), keys, texts, bucket offsets,
+ * rank directory, min-max tree (min, sum), dict data
+ * every section but the dict data is whole uint64_t words, so a mapped archive is
+ * aligned in place. "JSONBP1" archives (no padding or index) are still read, and the
+ * index is rebuilt for them.
+ */
+static const char json_bp_magic[8] = "JSONBP2";
+static const char json_bp_magic_v1[8] = "JSONBP1";
+
+static uint64_t json_bp_kinds_size(const json_bp* bp) {
+    return bp->node_count / 2 + 1;
+}
+static uint64_t json_bp_kinds_padded(const json_bp* bp) {
+    return (json_bp_kinds_size(bp) + 7) & ~(uint64_t)7;
+}
+static uint64_t json_bp_buckets(const json_bp* bp) {
+    return (bp->dict.count + JSON_BP_BUCKET - 1) / JSON_BP_BUCKET;
+}
+
+//byte sizes of the sections after the header
+typedef struct json_bp_layout_s {
+    uint64_t bits;
+    uint64_t kinds;                //padded in JSONBP2 archives
+    uint64_t keys;
+    uint64_t texts;
+    uint64_t buckets;
+    uint64_t rank;                 //stored index, 0 in JSONBP1 archives
+    uint64_t tree;                 //tree_min and tree_sum each
+} json_bp_layout;
+//takes the header of an archive and lays out its sections, or returns false if it cannot
+//describe an archive of available bytes (UINT64_MAX when the stream size is unknown).
+//node_count is bounded so that no section size below can overflow; the sums that involve
+//the free dictionary fields are overflow checked.
+static bool json_bp_set_header(json_bp* bp, const uint64_t header[5], bool v1, uint64_t available, json_bp_layout* l) {
+    //every dictionary string takes at least one byte
+    if (header[0] == 0 || header[0] > UINT64_MAX / 256 || header[1] == 0 || header[1] > 64
+        || header[2] == 0 || header[2] > 64 || header[3] > header[4])
+        return false;
+    bp->node_count = header[0];
+    bp->bit_count = 2 * bp->node_count;
+    bp->keys.width = header[1];
+    bp->keys.length = bp->node_count;
+    bp->texts.width = header[2];
+    bp->texts.length = bp->node_count;
+    bp->dict.count = header[3];
+    bp->dict.size = header[4];
+    uint64_t blocks = json_bp_index_blocks(bp);
+    l->bits = sizeof(uint64_t) * (bp->bit_count / 64 + 2);
+    l->kinds = v1 ? json_bp_kinds_size(bp) : json_bp_kinds_padded(bp);
+    l->keys = sizeof(uint64_t) * json_bp_packed_words(&bp->keys);
+    l->texts = sizeof(uint64_t) * json_bp_packed_words(&bp->texts);
+    l->buckets = sizeof(uint64_t) * json_bp_buckets(bp);
+    l->rank = v1 ? 0 : sizeof(uint64_t) * blocks;
+    l->tree = v1 ? 0 : sizeof(int64_t) * 2 * bp->tree_leaves;
+    uint64_t total = l->bits + l->kinds + l->keys + l->texts + l->rank + 2 * l->tree;
+    return !__builtin_add_overflow(total, l->buckets, &total) && !__builtin_add_overflow(total, bp->dict.size, &total)
+        && total <= available;
+}
+//what the header cannot vouch for: one balanced tree of node_count nodes, known kinds and
+//bucket offsets that start strings inside the dictionary
+static bool json_bp_check_body(const json_bp* bp) {
+    int64_t excess = 0;
+    for (uint64_t i = 0; i < bp->bit_count; i++) {
+        excess += json_bp_bit(bp, i) ? 1 : -1;
+        if (excess < 0 || (excess == 0 && i + 1 < bp->bit_count)) return false;
+    }
+    if (excess != 0) return false;
+    for (uint64_t pre = 0; pre < bp->node_count; pre++)
+        if (((bp->kinds[pre >> 1] >> ((pre & 1) * 4)) & 0xF) > JSON_BP_OBJECT) return false;
+    uint64_t buckets = json_bp_buckets(bp);
+    for (uint64_t b = 0; b < buckets; b++) {
+        uint64_t offset = bp->dict.bucket_offsets[b];
+        if (offset >= bp->dict.size || (b == 0 ? offset != 0 : offset <= bp->dict.bucket_offsets[b - 1])) return false;
+    }
+    return true;
+}
+
+bool json_bp_write(const json_bp* bp, FILE* fp) {
+    static const uint8_t padding[8] = {0};
+    uint64_t header[5] = {bp->node_count, bp->keys.width, bp->texts.width, bp->dict.count, bp->dict.size};
+    uint64_t buckets = json_bp_buckets(bp);
+    uint64_t blocks = (bp->bit_count + JSON_BP_BLOCK_BITS - 1) / JSON_BP_BLOCK_BITS + 1;
+    uint64_t pad = json_bp_kinds_padded(bp) - json_bp_kinds_size(bp);
+    bool ok = fwrite(json_bp_magic, 1, 8, fp) == 8
+        && fwrite(header, sizeof(uint64_t), 5, fp) == 5
+        && fwrite(bp->bits, sizeof(uint64_t), bp->bit_count / 64 + 2, fp) == bp->bit_count / 64 + 2
+        && fwrite(bp->kinds, 1, json_bp_kinds_size(bp), fp) == json_bp_kinds_size(bp)
+        && fwrite(padding, 1, pad, fp) == pad
+        && fwrite(bp->keys.words, sizeof(uint64_t), json_bp_packed_words(&bp->keys), fp) == json_bp_packed_words(&bp->keys)
+        && fwrite(bp->texts.words, sizeof(uint64_t), json_bp_packed_words(&bp->texts), fp) == json_bp_packed_words(&bp->texts)
+        && fwrite(bp->dict.bucket_offsets, sizeof(uint64_t), buckets, fp) == buckets
+        && fwrite(bp->rank_blocks, sizeof(uint64_t), blocks, fp) == blocks
+        && fwrite(bp->tree_min, sizeof(int64_t), 2 * bp->tree_leaves, fp) == 2 * bp->tree_leaves
+        && fwrite(bp->tree_sum, sizeof(int64_t), 2 * bp->tree_leaves, fp) == 2 * bp->tree_leaves
+        && fwrite(bp->dict.data, 1, bp->dict.size, fp) == bp->dict.size;
+    if (!ok) fprintf(stderr, "json_bp_write error: write failed\n");
+    return ok;
+}
+bool json_bp_read(json_bp* bp, FILE* fp) {
+    memset(bp, 0x00, sizeof(json_bp));
+    char magic[8];
+    uint64_t header[5];
+    if (fread(magic, 1, 8, fp) != 8 || (memcmp(magic, json_bp_magic, 8) != 0 && memcmp(magic, json_bp_magic_v1, 8) != 0)
+        || fread(header, sizeof(uint64_t), 5, fp) != 5) {
+        fprintf(stderr, "json_bp_read error: not a json_bp archive\n");
+        return false;
+    }
+    bool v1 = memcmp(magic, json_bp_magic_v1, 8) == 0;
+    //a regular file bounds the sections before anything is allocated
+    uint64_t available = UINT64_MAX;
+    struct stat st;
+    off_t at = ftello(fp);
+    if (at >= 0 && fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode))
+        available = (uint64_t)st.st_size > (uint64_t)at ? (uint64_t)st.st_size - (uint64_t)at : 0;
+    json_bp_layout l;
+    if (!json_bp_set_header(bp, header, v1, available, &l)) {
+        fprintf(stderr, "json_bp_read error: corrupted archive header\n");
+        memset(bp, 0x00, sizeof(json_bp));
+        return false;
+    }
+    bp->bits = (uint64_t *)malloc(l.bits);
+    bp->kinds = (uint8_t *)malloc(l.kinds);
+    bp->keys.words = (uint64_t *)malloc(l.keys);
+    bp->texts.words = (uint64_t *)malloc(l.texts);
+    bp->dict.bucket_offsets = (uint64_t *)malloc(l.buckets + sizeof(uint64_t));
+    bp->dict.data = (unsigned char *)malloc(bp->dict.size + 1);
+    bool ok = bp->bits && bp->kinds && bp->keys.words && bp->texts.words && bp->dict.bucket_offsets && bp->dict.data
+        && fread(bp->bits, 1, l.bits, fp) == l.bits
+        && fread(bp->kinds, 1, l.kinds, fp) == l.kinds
+        && fread(bp->keys.words, 1, l.keys, fp) == l.keys
+        && fread(bp->texts.words, 1, l.texts, fp) == l.texts
+        && fread(bp->dict.bucket_offsets, 1, l.buckets, fp) == l.buckets;
+    if (ok && !v1) {
+        bp->rank_blocks = (uint64_t *)malloc(l.rank);
+        bp->tree_min = (int64_t *)malloc(l.tree);
+        bp->tree_sum = (int64_t *)malloc(l.tree);
+        ok = bp->rank_blocks && bp->tree_min && bp->tree_sum
+            && fread(bp->rank_blocks, 1, l.rank, fp) == l.rank
+            && fread(bp->tree_min, 1, l.tree, fp) == l.tree
+            && fread(bp->tree_sum, 1, l.tree, fp) == l.tree;
+    }
+    ok = ok && fread(bp->dict.data, 1, bp->dict.size, fp) == bp->dict.size;
+    if (!ok) {
+        fprintf(stderr, "json_bp_read error: truncated archive\n");
+        json_bp_free(bp);
+        return false;
+    }
+    if (!(v1 ? json_bp_build_index(bp) : json_bp_index_pass(bp, true)) || !json_bp_check_body(bp)) {
+        fprintf(stderr, "json_bp_read error: corrupted archive\n");
+        json_bp_free(bp);
+        return false;
+    }
+    return true;
+}
+bool json_bp_map(json_bp* bp, int fd) {
+    memset(bp, 0x00, sizeof(json_bp));
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 48) {
+        fprintf(stderr, "json_bp_map error: not a json_bp archive\n");
+        return false;
+    }
+    void* mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "json_bp_map error: mmap error\n");
+        return false;
+    }
+    if (memcmp(mapping, json_bp_magic, 8) != 0) {
+        munmap(mapping, (size_t)st.st_size);
+        //older archives are not aligned for mapping and are copied instead
+        FILE* fp = lseek(fd, 0, SEEK_SET) == 0 ? fdopen(dup(fd), "rb") : NULL;
+        if (fp == NULL) {
+            fprintf(stderr, "json_bp_map error: not a json_bp archive\n");
+            return false;
+        }
+        bool ok = json_bp_read(bp, fp);
+        fclose(fp);
+        return ok;
+    }
+    uint64_t header[5];
+    memcpy(header, (const char *)mapping + 8, sizeof(header));
+    json_bp_layout l;
+    if (!json_bp_set_header(bp, header, false, (uint64_t)st.st_size - 48, &l)) {
+        fprintf(stderr, "json_bp_map error: corrupted archive header\n");
+        munmap(mapping, (size_t)st.st_size);
+        memset(bp, 0x00, sizeof(json_bp));
+        return false;
+    }
+    //every section but the dict data is whole words, so each one starts 8-byte aligned.
+    //the mapping is read-only; the casts only drop const for the shared struct layout
+    const char* at = (const char *)mapping + 48;
+    bp->bits = (uint64_t *)at;                  at += l.bits;
+    bp->kinds = (uint8_t *)at;                  at += l.kinds;
+    bp->keys.words = (uint64_t *)at;            at += l.keys;
+    bp->texts.words = (uint64_t *)at;           at += l.texts;
+    bp->dict.bucket_offsets = (uint64_t *)at;   at += l.buckets;
+    bp->rank_blocks = (uint64_t *)at;           at += l.rank;
+    bp->tree_min = (int64_t *)at;               at += l.tree;
+    bp->tree_sum = (int64_t *)at;               at += l.tree;
+    bp->dict.data = (unsigned char *)at;
+    bp->mapping = mapping;
+    bp->mapping_size = (size_t)st.st_size;
+    if (!json_bp_index_pass(bp, true) || !json_bp_check_body(bp)) {
+        fprintf(stderr, "json_bp_map error: corrupted archive\n");
+        json_bp_free(bp);
+        return false;
+    }
+    return true;
+}
+
+int64_t json_bp_key(const json_bp* bp, json_bp_node x, char* buf, size_t bufsize) {
+    uint64_t id = json_bp_packed_get(&bp->keys, json_bp_preorder(bp, x));
+    return id == 0 ? -1 : json_bp_dict_get(&bp->dict, id - 1, buf, bufsize);
+}
+int64_t json_bp_text(const json_bp* bp, json_bp_node x, char* buf, size_t bufsize) {
+    uint64_t id = json_bp_packed_get(&bp->texts, json_bp_preorder(bp, x));
+    return id == 0 ? -1 : json_bp_dict_get(&bp->dict, id - 1, buf, bufsize);
+}
+
+//prints in the same layout as json_fprint_value()
+void json_bp_fprint(FILE* outfp, const json_bp* bp, json_bp_node x, int tab) {
+    char small[256];
+    json_bp_kind kind = json_bp_get_kind(bp, x);
+    if (kind == JSON_BP_NULL) fprintf(outfp, "null");
+    else if (kind == JSON_BP_FALSE) fprintf(outfp, "false");
+    else if (kind == JSON_BP_TRUE) fprintf(outfp, "true");
+    else if (kind == JSON_BP_INTEGER || kind == JSON_BP_DOUBLE || kind == JSON_BP_STRING) {
+        int64_t len = json_bp_text(bp, x, small, sizeof(small));
+        char* text = small;
+        if (len >= (int64_t)sizeof(small)) {
+            text = (char *)malloc((size_t)len + 1);
+            if (text == NULL) return;
+            json_bp_text(bp, x, text, (size_t)len + 1);
+        }
+        if (kind == JSON_BP_INTEGER) fprintf(outfp, "%s", text);
+        else if (kind == JSON_BP_DOUBLE) fprintf(outfp, "%f", atof(text));
+        else fprintf(outfp, "\"%s\"", text);
+        if (text != small) free(text);
+    }
+    else if (kind == JSON_BP_ARRAY) {
+        fprintf(outfp, "[");
+        for (json_bp_node c = json_bp_first_child(bp, x); c != JSON_BP_NONE; ) {
+            json_bp_fprint(outfp, bp, c, tab);
+            c = json_bp_next_sibling(bp, c);
+            if (c != JSON_BP_NONE) fprintf(outfp, ", ");
+        }
+        fprintf(outfp, "]");
+    }
+    else {
+        fprintf(outfp, "{\n");
+        tab++;
+        for (json_bp_node c = json_bp_first_child(bp, x); c != JSON_BP_NONE; ) {
+            for (int t = 0; t < tab; t++) fprintf(outfp, "\t");
+            int64_t len = json_bp_key(bp, c, small, sizeof(small));
+            char* key = small;
+            if (len >= (int64_t)sizeof(small)) {
+                key = (char *)malloc((size_t)len + 1);
+                if (key == NULL) return;
+                json_bp_key(bp, c, key, (size_t)len + 1);
+            }
+            fprintf(outfp, "\"%s\": ", len < 0 ? "" : key);
+            if (key != small) free(key);
+            json_bp_fprint(outfp, bp, c, tab);
+            c = json_bp_next_sibling(bp, c);
+            if (c != JSON_BP_NONE) fprintf(outfp, ",\n");
+        }
+        fprintf(outfp, "\n");
+        tab--;
+        for (int t = 0; t < tab; t++) fprintf(outfp, "\t");
+        fprintf(outfp, "}");
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -11,12 +11,22 @@ extern "C"{
 #include <string.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
-#define JSON_MAX_INDEX 100
+//largest integer that json_get() treats as an index rather than a string key.
+//containers themselves grow without limit; use json_get_from_array() beyond this.
+#define JSON_MAX_INDEX 4095
+#define JSON_INIT_CAPACITY 8
 #define JSON_LAST_ARG_MAGIC_NUMBER -1027
 #define JSON_STRBUFSIZE 256
 
-typedef enum json_type_enum { JSON_UNDEFINED = 0x0, JSON_NUMBER = 0x1, JSON_STRING=0x2, JSON_BOOLEAN=0x4, JSON_ARRAY=0x8, JSON_OBJECT=0x10, JSON_NULL=0x20, JSON_INTEGER=0x40, JSON_DOUBLE=0x80 } json_type;
+typedef enum json_type_enum { JSON_UNDEFINED = 0x0, JSON_NUMBER = 0x1, JSON_STRING=0x2, JSON_BOOLEAN=0x4, JSON_ARRAY=0x8, JSON_OBJECT=0x10, JSON_NULL=0x20, JSON_INTEGER=0x40, JSON_DOUBLE=0x80, JSON_RAW=0x100, JSON_INLINE=0x200 } json_type;
+//sizes and indices are 64-bit so multi-GB documents survive on LP64
+typedef int64_t json_index;
 typedef enum json_keyorvalue_enum { JSON_KEY, JSON_VALUE } json_keyorvalue;
 typedef struct json_small_stack_s{
 	int top;
@@ -27,15 +37,162 @@ typedef struct json_value_s {
     json_type type;
     void* value;
 } json_value;
+//JSON_STRING|JSON_INLINE: a string of at most JSON_INLINE_MAX bytes stored, NUL padded, in
+//the bytes of value itself (see json_parser.inline_strings). read it with json_string_of().
+//only value's bytes hold text: the padding after type is not kept when a json_value is copied
+#define JSON_INLINE_MAX (sizeof(void *) - 1)
+#define json_is_string(v) (((v).type & ~JSON_INLINE) == JSON_STRING)
+//shape (hidden class): the key sequence shared by every object of an arena document
+//that has exactly these keys in this order. such objects only hold their values and
+//point keys at shape->keys, so inline caches can resolve them by shape id.
+//heap (json_create) objects own a private shape with id 0 that json_free_object() releases.
+typedef struct json_shape_s {
+    uint64_t id;                      //never reused, not even after json_parser_reset()
+    uint64_t hash;
+    json_index count;
+    char* keys[];
+} json_shape;
 typedef struct json_object_s {
-    int last_index;
-    char* keys[JSON_MAX_INDEX];
-    json_value values[JSON_MAX_INDEX];
+    json_index last_index;
+    json_index capacity;
+    char** keys;                      //shape->keys of a non-empty object
+    json_value* values;
 } json_object;
+//the shape of an object, NULL when it is empty
+#define json_object_shape(o) ((o)->keys != NULL ? (json_shape *)((char *)(o)->keys - offsetof(json_shape, keys)) : NULL)
 typedef struct json_array_s {
-    int last_index;
-    json_value values[JSON_MAX_INDEX];
+    json_index last_index;
+    json_index capacity;
+    json_value* values;
 } json_array;
+//JSON_RAW: an unparsed span of the source text (see json_parser.lazy_key).
+//it points into the parsed message, which must outlive the document.
+//JSON_NUMBER|JSON_INTEGER|JSON_RAW (or JSON_DOUBLE): a lazy number (see json_parser.lazy_numbers).
+//value points at the number's token in the message and json_to_longlongint()/json_to_double()
+//convert it on every access.
+typedef struct json_raw_s {
+    const char* begin;
+    size_t length;
+} json_raw;
+
+//arena chunk: nodes of a parser-owned document are carved out of these
+#define JSON_ARENA_CHUNK_SIZE (64 * 1024)
+//once a parser's arena exceeds json_parser.huge_page_threshold bytes, further chunks are
+//multiples of this, aligned to it and advised as transparent huge pages (linux), so random
+//traversal of a large document needs far fewer TLB entries
+#define JSON_ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define JSON_ARENA_HUGE_PAGE_THRESHOLD (16 * 1024 * 1024)
+typedef struct json_arena_chunk_s {
+    struct json_arena_chunk_s* next;
+    size_t size;
+    size_t used;
+    char data[];
+} json_arena_chunk;
+//recycled arena chunks of one thread. the parsers of that thread (json_parser.pool) take
+//chunks from it before calling malloc and give them back when freed, and a detached
+//document (json_parser_detach) returns its chunks here from whichever thread frees it,
+//so a parse/analyze pipeline reaches a steady state without touching the malloc arenas.
+typedef struct json_arena_pool_s {
+    json_arena_chunk* free_chunks;    //owner thread only
+    json_arena_chunk* returned;       //lock-free stack of chunks given back, taken as a whole
+} json_arena_pool;
+typedef struct json_parser_slot_s {
+    char* key;
+    json_value value;
+} json_parser_slot;
+typedef struct json_cons_entry_s {
+    uint64_t hash;
+    json_value value;
+} json_cons_entry;
+//growable buffer strings are unescaped into. its capacity doubles, so building an
+//n-byte string copies O(n) bytes, and it is reused from one string to the next.
+typedef struct json_strbuf_s {
+    char* data;
+    size_t size;
+    size_t capacity;
+} json_strbuf;
+//reusable parser context. json_parser_reset() keeps every buffer, so parsing
+//document after document reaches a steady state without calling malloc.
+typedef struct json_parser_s {
+    bool heap_nodes;                  //malloc each node (json_free-able) instead of using the arena
+    bool hash_cons;                   //share structurally identical subtrees (arena documents only)
+    const char* lazy_key;             //values of members with this key are skipped and kept as JSON_RAW spans
+    bool inline_strings;              //keep short strings inside their json_value (arena documents only)
+    bool lazy_numbers;                //leave numbers as tokens of the message (arena documents without hash_cons)
+    json_arena_pool* pool;            //recycle arena chunks through this pool (use the parser on the pool's thread)
+    size_t huge_page_threshold;       //arena size after which chunks get huge pages, 0 = never (e.g. JSON_ARENA_HUGE_PAGE_THRESHOLD)
+    json_arena_chunk* arena_head;
+    json_arena_chunk* arena_current;
+    size_t arena_size;                //bytes of all chunks the parser holds
+    bool hash_consed;                 //the current document shares containers (hash_cons was on when one closed)
+    json_parser_slot* stack;          //scratch stack collecting container children
+    size_t stack_top;
+    size_t stack_capacity;
+    char** intern_slots;              //open addressing table of interned keys
+    size_t intern_count;
+    size_t intern_capacity;
+    json_strbuf strbuf;               //output buffer strings are unescaped into
+    json_cons_entry* cons_slots;      //hash-consing table of canonical numbers and containers
+    size_t cons_count;
+    size_t cons_capacity;
+    json_shape** shape_slots;         //open addressing table of the document's object shapes
+    size_t shape_count;
+    size_t shape_capacity;
+} json_parser;
+
+void json_parser_init(json_parser* p);
+void json_parser_reset(json_parser* p);
+void json_parser_free(json_parser* p);
+//the returned document is owned by the parser and stays valid until the next
+//json_parser_parse(), json_parser_reset() or json_parser_free(). do not json_free() it.
+//with hash_cons set the document is a DAG: identical subtrees are stored once, so two
+//values of the same document are structurally equal exactly when json_same() holds.
+json_value json_parser_parse(json_parser* p, const char* json_message);
+//the parser skips characters it does not expect, so malformed or truncated text still yields a
+//partial document. json_validate() checks that the first length bytes are exactly one RFC 8259
+//value surrounded by white space: it returns NULL when they are, else the first offending position.
+const char* json_validate(const char* json_message, size_t length);
+size_t json_parser_memory_usage(const json_parser* p);
+//parses a JSON_RAW span into the parser's current document (other values are returned as is).
+//the span is parsed without lazy_key, so the result is fully materialized.
+json_value json_parser_materialize(json_parser* p, json_value raw);
+//building a document without JSON text (e.g. from another front end).
+//open a container, append its members in order, then close it. a nested container
+//must be closed before it is appended to its parent, just like the parser does.
+//built values live in the parser's document (arena, interned keys and hash-consing apply).
+size_t json_parser_open(json_parser* p);
+bool json_parser_append(json_parser* p, const char* key, json_value v);
+json_value json_parser_close(json_parser* p, json_type type, size_t base);
+json_value json_parser_string(json_parser* p, const char* str, size_t len);
+//handing a document to another thread. detach moves the arena chunks of p's current document
+//into the returned handle without copying, and p starts its next document in fresh chunks.
+//json_document_free() may run on any thread; it gives the chunks back to p's pool (or to free()
+//when p has none). lazy numbers and JSON_RAW spans still point into the parsed message.
+typedef struct json_document_s {
+    json_value root;
+    json_arena_chunk* chunks;
+    json_arena_pool* pool;
+} json_document;
+json_document json_parser_detach(json_parser* p, json_value root);
+void json_document_free(json_document* d);
+void json_arena_pool_init(json_arena_pool* pool);
+//frees the pooled chunks. call it on the owner thread once no document of the pool is alive
+void json_arena_pool_free(json_arena_pool* pool);
+//modifying a document in place. p is the parser that owns the document (a parser with
+//heap_nodes set for json_create() documents, whose replaced and removed values are json_free()d).
+//containers grow geometrically, so appends are amortized O(1); insert and delete move the
+//following members. a document built with hash_cons shares subtrees and cannot be modified,
+//even after hash_cons is turned off (json_parser.hash_consed records it until the next reset).
+//an object that gains or loses a key moves to the shape of its new key sequence.
+bool json_object_set(json_parser* p, json_value object, const char* key, json_value v);
+bool json_object_delete(json_parser* p, json_value object, const char* key);
+bool json_array_push(json_parser* p, json_value array, json_value v);
+bool json_array_insert(json_parser* p, json_value array, json_index index, json_value v);
+bool json_array_set(json_parser* p, json_value array, json_index index, json_value v);
+bool json_array_delete(json_parser* p, json_value array, json_index index);
+
+#define json_same(a, b) ((a).type == (b).type && (a).value == (b).value)
+bool json_equal(json_value a, json_value b);
 
 json_value json_string_to_value(const char** json_message);
 json_value json_create(const char* json_message);
@@ -47,28 +204,77 @@ json_object * json_create_object(const char** json_message);
 #define json_get_float(...) ((float)json_to_double(json_get(__VA_ARGS__)))
 #define json_get_double(...) json_to_double(json_get(__VA_ARGS__))
 #define json_get_bool(...) json_to_bool(json_get(__VA_ARGS__))
-#define json_get_string(...) json_to_string(json_get(__VA_ARGS__))
+//works for inline strings too: it reads the cell inside the document, like json_string_of()
+#define json_get_string(...) ((char *)json_string_of(json_get_ref(__VA_ARGS__, (void*)JSON_LAST_ARG_MAGIC_NUMBER)))
 
 #define json_to_int(v) ((int)json_to_longlongint(v))
 long long int json_to_longlongint(json_value v);
 #define json_to_float(v) ((float)json_to_float(v))
 double json_to_double(json_value v);
+//the token of a lazy number: *begin is set into the parsed message and its length is returned.
+//0 when v is not a lazy number.
+size_t json_number_token(json_value v, const char** begin);
 bool json_to_bool(json_value v);
+//NULL for an inline string, which has no text outside its cell: use json_string_of() or
+//json_get_string() where inline_strings may be on
 char * json_to_string(json_value v);
+//the text of a string value, inline or not. an inline string lives in the value cell itself,
+//so pass the cell inside the document (e.g. &obj->values[i]); a pointer into a copy is only
+//valid as long as the copy. NULL when v is NULL or not a string.
+const char * json_string_of(const json_value* v);
 bool json_is_null(json_value v);
 json_type json_get_type(json_value v);
-const char * const json_type_to_string(int type);
+const char * json_type_to_string(int type);
 
 //TODO read json file
 json_value json_read(const char * const path);
 
+/*
+ * concurrent readers
+ * a finished document is never modified by the read functions below (json_get*, json_len,
+ * json_to_*, json_string_of, json_equal, json_fprint*), so any number of threads may read
+ * one document at once without locking. the only state they touch is
+ *  - the json_inline_cache passed to json_get_ic(): give each thread its own, e.g.
+ *    static JSON_THREAD_LOCAL json_inline_cache ic; at a call site several threads run
+ *  - the calling thread's json_set_quiet() switch
+ * everything that takes a json_parser* (parsing, json_parser_materialize(), the builder and
+ * the mutation functions) writes to the parser and its document: it needs exclusive access.
+ */
+#ifdef __cplusplus
+#define JSON_THREAD_LOCAL thread_local
+#else
+#define JSON_THREAD_LOCAL _Thread_local
+#endif
+//when set, the read functions of the calling thread report failures only through their
+//return values instead of also printing to stderr
+void json_set_quiet(bool quiet);
+
 #define json_get(...) (json_get_value(__VA_ARGS__, (void*)JSON_LAST_ARG_MAGIC_NUMBER))
 json_value json_get_value(json_value v, ...);
+//like json_get_value() but returns the cell inside the document, NULL when there is none.
+//needs at least one key, since v itself is a copy
+const json_value* json_get_ref(json_value v, ...);
 json_value json_get_from_json_value(json_value v, const void* k);
 json_value json_get_from_object(json_object* json, const char* key);
-json_value json_get_from_array(json_array* json, const int index);
-int json_len(json_value v);
-int json_get_last_index(json_value v);
+json_value json_get_from_array(json_array* json, const json_index index);
+//inline cache for json_get_ic(). keep one (static) cache per call site and key: it remembers
+//the shapes the key was seen in and its slot there, so objects with a stable key order (e.g.
+//every Decl of a pycparser AST) are resolved without comparing a single key. objects without
+//a shared shape fall back to checking the cached slots before scanning all the keys.
+//a few ways are kept because one call site often sees several node types.
+#define JSON_IC_WAYS 4
+typedef struct json_inline_cache_s {
+    int used;
+    struct {
+        uint64_t shape;               //shape id, 0 for objects without a shared shape
+        json_index slot;
+    } ways[JSON_IC_WAYS];             //most recently added first
+} json_inline_cache;
+//returns NULL without printing an error when v is not an object or has no such key.
+//ic may be NULL for a plain lookup
+const json_value* json_get_ic(json_value v, const char* key, json_inline_cache* ic);
+json_index json_len(json_value v);
+json_index json_get_last_index(json_value v);
 
 void json_fprint_value(FILE * outfp, const json_value v, int tab);
 void json_fprint_array(FILE * outfp, const json_array* json, int tab);
@@ -95,112 +301,848 @@ void json_free_object(json_object* jsono);
 #ifdef __cplusplus
 extern "C"{
 #endif
-static const int MAX_INDEX = JSON_MAX_INDEX;
+static const json_index MAX_INDEX = JSON_MAX_INDEX;
 static const json_value undefined_json = {JSON_UNDEFINED, NULL};
+static json_value json_parse_value(json_parser* p, const char** json_message);
+static json_array* json_parse_array(json_parser* p, const char** json_message);
+static json_object* json_parse_object(json_parser* p, const char** json_message);
 
-json_value json_get_value(json_value v, ...) {
+static JSON_THREAD_LOCAL bool json_quiet = false;
+void json_set_quiet(bool quiet) {
+    json_quiet = quiet;
+}
+#define json_read_error(...) (json_quiet ? (void)0 : (void)fprintf(stderr, __VA_ARGS__))
+
+static const json_value* json_cell_of_json_value(const json_value* v, const void* key);
+static const json_value* json_cell_of_object(json_object* json, const char* key);
+static const json_value* json_cell_of_array(json_array* json, const json_index index);
+
+//walks the keys of a json_get() path from v and returns the cell found, v itself when the
+//path is empty. NULL when a step fails
+static const json_value* json_get_walk(const json_value* v, va_list ap) {
 	void * key = NULL;
 	void * vakey = NULL;
-	va_list ap;
-	va_start(ap, v);
 	key = va_arg(ap, void *);
-	if((int)key == JSON_LAST_ARG_MAGIC_NUMBER){ 
+	if((intptr_t)key == JSON_LAST_ARG_MAGIC_NUMBER){ 
 		return v;
 		//fprintf(stderr, "json_get error : json_get needs two arguments at least and each of arguments must be a index(integer) or string(search key) except the first argument\n");
 		//return undefined_json;
 	}
-	if( ! (v.type == JSON_ARRAY || v.type == JSON_OBJECT)){
-		fprintf(stderr, "json_get error : the first argument of json_get should be an array or an object (type : %s)\n", json_type_to_string(v.type));
-		return undefined_json;
+	if( ! (v->type == JSON_ARRAY || v->type == JSON_OBJECT)){
+		json_read_error("json_get error : the first argument of json_get should be an array or an object (type : %s)\n", json_type_to_string(v->type));
+		return NULL;
 	}
 	json_small_stack jss = json_stacktrace_get_stack();
 
-	if(v.type == JSON_OBJECT) {
-		if((int)key>=0 && (int)key <= ((json_object *)(v.value))->last_index) json_stacktrace_push(&jss, v.type, ((json_object *)(v.value))->keys[(int)key]);
-		else json_stacktrace_push(&jss, v.type, key);
+	if(v->type == JSON_OBJECT) {
+		if((intptr_t)key>=0 && (intptr_t)key <= ((json_object *)(v->value))->last_index) json_stacktrace_push(&jss, v->type, ((json_object *)(v->value))->keys[(intptr_t)key]);
+		else json_stacktrace_push(&jss, v->type, key);
 	}
-	else json_stacktrace_push(&jss, v.type, key);
-
-	json_value ret = json_get_from_json_value(v, key);
-	if(ret.type == JSON_UNDEFINED){
-		fprintf(stderr, "error tracing : ");
-		json_stacktrace_print(stderr, &jss);
-		fprintf(stderr, "\n");
-		return ret;
+	else json_stacktrace_push(&jss, v->type, key);
+
+	const json_value* ret = json_cell_of_json_value(v, key);
+	if(ret == NULL){
+		if(!json_quiet){
+			fprintf(stderr, "error tracing : ");
+			json_stacktrace_print(stderr, &jss);
+			fprintf(stderr, "\n");
+		}
+		return NULL;
 	}
 
 	while(1){
 		vakey = va_arg(ap, void *);
-		if((int)vakey == JSON_LAST_ARG_MAGIC_NUMBER) break; 
+		if((intptr_t)vakey == JSON_LAST_ARG_MAGIC_NUMBER) break; 
 
-		if(ret.type == JSON_OBJECT) {
-			if((int)key>=0 && (int)vakey <= ((json_object *)(ret.value))->last_index) json_stacktrace_push(&jss, ret.type, ((json_object *)(ret.value))->keys[(int)vakey]);
-			else json_stacktrace_push(&jss, ret.type, vakey);
+		if(ret->type == JSON_OBJECT) {
+			if((intptr_t)vakey>=0 && (intptr_t)vakey <= ((json_object *)(ret->value))->last_index) json_stacktrace_push(&jss, ret->type, ((json_object *)(ret->value))->keys[(intptr_t)vakey]);
+			else json_stacktrace_push(&jss, ret->type, vakey);
 		}
-		else json_stacktrace_push(&jss, ret.type, vakey);
+		else json_stacktrace_push(&jss, ret->type, vakey);
 
-		ret = json_get_from_json_value(ret, vakey);
+		ret = json_cell_of_json_value(ret, vakey);
 
-		if(ret.type == JSON_UNDEFINED){
-			fprintf(stderr, "error tracing : ");
-			json_stacktrace_print(stderr, &jss);
-			fprintf(stderr, "\n");
-			return ret;
+		if(ret == NULL){
+			if(!json_quiet){
+				fprintf(stderr, "error tracing : ");
+				json_stacktrace_print(stderr, &jss);
+				fprintf(stderr, "\n");
+			}
+			return NULL;
 		}
 	}
     return ret;
 }
+json_value json_get_value(json_value v, ...) {
+	va_list ap;
+	va_start(ap, v);
+	const json_value* ret = json_get_walk(&v, ap);
+	va_end(ap);
+	return ret != NULL ? *ret : undefined_json;
+}
+const json_value* json_get_ref(json_value v, ...) {
+	va_list ap;
+	va_start(ap, v);
+	const json_value* ret = json_get_walk(&v, ap);
+	va_end(ap);
+	//an empty path would hand out the address of the copy
+	return ret == &v ? NULL : ret;
+}
 json_value json_get_from_json_value(json_value v, const void* key) {
-    if (v.type == JSON_OBJECT) return json_get_from_object((json_object *)(v.value), (char *)key);
-    if (v.type == JSON_ARRAY) return json_get_from_array((json_array *)(v.value), (int)key);
-	fprintf(stderr, "json_get_from_json_value error : cannot get a json value with key from json_value that is not an object nor an array(value type : %s)\n", json_type_to_string(v.type));
-    return undefined_json;
+    const json_value* cell = json_cell_of_json_value(&v, key);
+    return cell != NULL ? *cell : undefined_json;
 }
 json_value json_get_from_object(json_object* json, const char* key) {
+    const json_value* cell = json_cell_of_object(json, key);
+    return cell != NULL ? *cell : undefined_json;
+}
+json_value json_get_from_array(json_array* json, const json_index index) {
+    const json_value* cell = json_cell_of_array(json, index);
+    return cell != NULL ? *cell : undefined_json;
+}
+static const json_value* json_cell_of_json_value(const json_value* v, const void* key) {
+    if (v->type == JSON_OBJECT) return json_cell_of_object((json_object *)(v->value), (char *)key);
+    if (v->type == JSON_ARRAY) return json_cell_of_array((json_array *)(v->value), (intptr_t)key);
+	json_read_error("json_get_from_json_value error : cannot get a json value with key from json_value that is not an object nor an array(value type : %s)\n", json_type_to_string(v->type));
+    return NULL;
+}
+static const json_value* json_cell_of_object(json_object* json, const char* key) {
 	//when the key is assummed as an index
-	if((int)key >=0 && (int)key <= json->last_index)
-		return json->values[(int)key];
-	if((int)key <= MAX_INDEX && (int)key>= 0){
-		fprintf(stderr, "json_get_from_object error : out of index\n");
-		return undefined_json;
+	if((intptr_t)key >=0 && (intptr_t)key <= json->last_index)
+		return &json->values[(intptr_t)key];
+	if((intptr_t)key <= MAX_INDEX && (intptr_t)key>= 0){
+		json_read_error("json_get_from_object error : out of index\n");
+		return NULL;
 	}
 		
 	//when the key is assummed as a string
-    if (json == NULL || key == NULL || *key == '\0') return undefined_json;
-    for (int i = 0; i <= json->last_index; i++) {
+    if (json == NULL || key == NULL || *key == '\0') return NULL;
+    for (json_index i = 0; i <= json->last_index; i++) {
         if (strcmp(json->keys[i], key) == 0) {
-            return json->values[i];
+            return &json->values[i];
         }
     }
-	fprintf(stderr, "json_get_from_object error : no value corresponding to the key(%s)\n", key);
-    return undefined_json;
+	json_read_error("json_get_from_object error : no value corresponding to the key(%s)\n", key);
+    return NULL;
 }
-json_value json_get_from_array(json_array* json, const int index) {
+static const json_value* json_cell_of_array(json_array* json, const json_index index) {
     if (json == NULL || index < 0 || json->last_index < index){
-		fprintf(stderr, "json_get_from_array error : out of index\n");
-		return undefined_json;
+		json_read_error("json_get_from_array error : out of index\n");
+		return NULL;
 	}
-    return json->values[index];
+    return &json->values[index];
 }
-int json_len(json_value v){
+const json_value* json_get_ic(json_value v, const char* key, json_inline_cache* ic) {
+    if (v.type != JSON_OBJECT || v.value == NULL || key == NULL) return NULL;
+    json_object* json = (json_object *)v.value;
+    if (ic == NULL) {
+        for (json_index i = 0; i <= json->last_index; i++)
+            if (strcmp(json->keys[i], key) == 0) return &json->values[i];
+        return NULL;
+    }
+    const json_shape* s = json_object_shape(json);
+    uint64_t shape = s != NULL ? s->id : 0;
+    if (shape != 0) {
+        for (int w = 0; w < ic->used; w++)
+            if (ic->ways[w].shape == shape) return &json->values[ic->ways[w].slot];
+    }
+    //otherwise a cached slot is verified by comparing its key: interned key pointers
+    //are recycled by json_parser_reset(), so they cannot identify a key across documents
+    json_index found = -1;
+    for (int w = 0; w < ic->used && found < 0; w++) {
+        json_index slot = ic->ways[w].slot;
+        if (slot <= json->last_index && strcmp(json->keys[slot], key) == 0) {
+            if (shape == 0) return &json->values[slot];
+            found = slot;
+        }
+    }
+    for (json_index i = 0; i <= json->last_index && found < 0; i++)
+        if (strcmp(json->keys[i], key) == 0) found = i;
+    if (found < 0) return NULL;
+    int shift = ic->used < JSON_IC_WAYS ? ic->used++ : JSON_IC_WAYS - 1;
+    memmove(&ic->ways[1], &ic->ways[0], sizeof(ic->ways[0]) * shift);
+    ic->ways[0].shape = shape;
+    ic->ways[0].slot = found;
+    return &json->values[found];
+}
+json_index json_len(json_value v){
 	return json_get_last_index(v)+1;
 }
-int json_get_last_index(json_value v){
+json_index json_get_last_index(json_value v){
 	if(v.type == JSON_OBJECT) return ((json_object *)(v.value))->last_index;
 	if(v.type == JSON_ARRAY) return ((json_array *)(v.value))->last_index;
 
-	fprintf(stderr, "json_get_last_index : the type of json_value is not a JSON_ARRAY nor a JSON_OBJECT");
+	json_read_error("json_get_last_index : the type of json_value is not a JSON_ARRAY nor a JSON_OBJECT");
 	return -1;
 }
 
-json_value json_string_to_value(const char** json_message) {
+/*
+ * parser context
+ * every allocation of the parser goes through json_parser_alloc().
+ * heap_nodes parsers (used by json_create) malloc each node so json_free() works,
+ * otherwise nodes are carved out of arena chunks that survive json_parser_reset().
+ */
+//a 2 MB aligned chunk advised for transparent huge pages, NULL where that is unavailable.
+//it is freed with free() like any other chunk
+static json_arena_chunk* json_arena_chunk_huge(size_t size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    size_t bytes = (sizeof(json_arena_chunk) + size + JSON_ARENA_HUGE_PAGE_SIZE - 1) & ~(size_t)(JSON_ARENA_HUGE_PAGE_SIZE - 1);
+    void* memory = NULL;
+    if (posix_memalign(&memory, JSON_ARENA_HUGE_PAGE_SIZE, bytes) != 0) return NULL;
+    //a kernel without THP refuses the advice; the chunk then simply uses small pages
+    madvise(memory, bytes, MADV_HUGEPAGE);
+    json_arena_chunk* chunk = (json_arena_chunk *)memory;
+    chunk->size = bytes - sizeof(json_arena_chunk);
+    chunk->used = 0;
+    return chunk;
+#else
+    (void)size;
+    return NULL;
+#endif
+}
+static json_arena_chunk* json_arena_chunk_new(json_parser* p, size_t size) {
+    json_arena_pool* pool = p->pool;
+    json_arena_chunk* chunk;
+    if (p->huge_page_threshold > 0 && p->arena_size >= p->huge_page_threshold) {
+        chunk = json_arena_chunk_huge(size);
+        if (chunk != NULL) return chunk;
+    }
+    if (pool != NULL && size <= JSON_ARENA_CHUNK_SIZE) {
+        if (pool->free_chunks == NULL)
+            pool->free_chunks = __atomic_exchange_n(&pool->returned, NULL, __ATOMIC_ACQUIRE);
+        chunk = pool->free_chunks;
+        if (chunk != NULL) {
+            pool->free_chunks = chunk->next;
+            chunk->used = 0;
+            return chunk;
+        }
+    }
+    size_t chunk_size = size > JSON_ARENA_CHUNK_SIZE ? size : JSON_ARENA_CHUNK_SIZE;
+    chunk = (json_arena_chunk *)malloc(sizeof(json_arena_chunk) + chunk_size);
+    if (chunk == NULL) {
+        fprintf(stderr, "json_parser_alloc error: malloc error\n");
+        return NULL;
+    }
+    chunk->size = chunk_size;
+    chunk->used = 0;
+    return chunk;
+}
+//gives a chunk list back to pool, from any thread. oversized chunks are not pooled
+static void json_arena_chunks_release(json_arena_pool* pool, json_arena_chunk* chunk) {
+    json_arena_chunk* head = NULL;
+    json_arena_chunk* tail = NULL;
+    while (chunk != NULL) {
+        json_arena_chunk* next = chunk->next;
+        if (pool == NULL || chunk->size != JSON_ARENA_CHUNK_SIZE) free(chunk);
+        else {
+            chunk->next = head;
+            if (tail == NULL) tail = chunk;
+            head = chunk;
+        }
+        chunk = next;
+    }
+    if (head == NULL) return;
+    json_arena_chunk* returned = __atomic_load_n(&pool->returned, __ATOMIC_RELAXED);
+    do {
+        tail->next = returned;
+    } while (!__atomic_compare_exchange_n(&pool->returned, &returned, head, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+static void * json_parser_alloc(json_parser* p, size_t size) {
+    if (p->heap_nodes) return malloc(size);
+    size = (size + 15) & ~(size_t)15;
+    json_arena_chunk* chunk = p->arena_current;
+    while (chunk != NULL && chunk->size - chunk->used < size) chunk = chunk->next;
+    if (chunk == NULL) {
+        chunk = json_arena_chunk_new(p, size);
+        if (chunk == NULL) return NULL;
+        p->arena_size += chunk->size;
+        //keep the chunk list ordered so reset() can rewind it from the head
+        if (p->arena_current == NULL) {
+            chunk->next = p->arena_head;
+            p->arena_head = chunk;
+        }
+        else {
+            chunk->next = p->arena_current->next;
+            p->arena_current->next = chunk;
+        }
+    }
+    p->arena_current = chunk;
+    void * ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+static bool json_parser_push(json_parser* p, char* key, json_value v) {
+    if (p->stack_top == p->stack_capacity) {
+        size_t capacity = p->stack_capacity ? p->stack_capacity * 2 : 64;
+        json_parser_slot* stack = (json_parser_slot *)realloc(p->stack, sizeof(json_parser_slot) * capacity);
+        if (stack == NULL) {
+            fprintf(stderr, "json_parser_push error: malloc error\n");
+            return false;
+        }
+        p->stack = stack;
+        p->stack_capacity = capacity;
+    }
+    p->stack[p->stack_top].key = key;
+    p->stack[p->stack_top].value = v;
+    p->stack_top++;
+    return true;
+}
+static uint64_t json_hash_string(const char* str, size_t len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)str[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+//intern a key so that repeated keys share one arena copy
+static char * json_parser_intern(json_parser* p, const char* str, size_t len) {
+    if ((p->intern_count + 1) * 2 > p->intern_capacity) {
+        size_t capacity = p->intern_capacity ? p->intern_capacity * 2 : 256;
+        char** slots = (char **)calloc(capacity, sizeof(char *));
+        if (slots == NULL) {
+            fprintf(stderr, "json_parser_intern error: malloc error\n");
+            return NULL;
+        }
+        for (size_t i = 0; i < p->intern_capacity; i++) {
+            char* s = p->intern_slots[i];
+            if (s == NULL) continue;
+            size_t j = json_hash_string(s, strlen(s)) & (capacity - 1);
+            while (slots[j] != NULL) j = (j + 1) & (capacity - 1);
+            slots[j] = s;
+        }
+        free(p->intern_slots);
+        p->intern_slots = slots;
+        p->intern_capacity = capacity;
+    }
+    size_t i = json_hash_string(str, len) & (p->intern_capacity - 1);
+    while (p->intern_slots[i] != NULL) {
+        if (strncmp(p->intern_slots[i], str, len) == 0 && p->intern_slots[i][len] == '\0')
+            return p->intern_slots[i];
+        i = (i + 1) & (p->intern_capacity - 1);
+    }
+    char* s = (char *)json_parser_alloc(p, len + 1);
+    if (s == NULL) return NULL;
+    memcpy(s, str, len);
+    s[len] = '\0';
+    p->intern_slots[i] = s;
+    p->intern_count++;
+    return s;
+}
+
+//store a short string inside the value when the parser asks for it.
+//inline strings need no interning: equal texts already have equal value bits.
+static bool json_parser_inline(json_parser* p, json_value* v, const char* str, size_t len) {
+    if (!p->inline_strings || p->heap_nodes || len > JSON_INLINE_MAX) return false;
+    v->type = (json_type)(JSON_STRING|JSON_INLINE);
+    v->value = NULL;
+    memcpy(&v->value, str, len);
+    return true;
+}
+
+/*
+ * hash-consing
+ * children are canonical before their parent is closed, so a container is
+ * identified by its type, keys (interned) and child pointers alone.
+ */
+typedef struct json_arena_mark_s {
+    json_arena_chunk* chunk;
+    size_t used;
+} json_arena_mark;
+static json_arena_mark json_parser_mark(const json_parser* p) {
+    json_arena_mark mark = {p->arena_current, p->arena_current ? p->arena_current->used : 0};
+    return mark;
+}
+//drop everything allocated since mark. chunks after the current one are always unused.
+static void json_parser_rewind(json_parser* p, json_arena_mark mark) {
+    if (mark.chunk != p->arena_current) {
+        json_arena_chunk* chunk = mark.chunk ? mark.chunk->next : p->arena_head;
+        for (; chunk != NULL; chunk = chunk->next) {
+            chunk->used = 0;
+            if (chunk == p->arena_current) break;
+        }
+    }
+    if (mark.chunk != NULL) mark.chunk->used = mark.used;
+    p->arena_current = mark.chunk ? mark.chunk : p->arena_head;
+}
+static uint64_t json_hash_mix(uint64_t h, uint64_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+static bool json_cons_reserve(json_parser* p) {
+    if ((p->cons_count + 1) * 2 <= p->cons_capacity) return true;
+    size_t capacity = p->cons_capacity ? p->cons_capacity * 2 : 1024;
+    json_cons_entry* slots = (json_cons_entry *)calloc(capacity, sizeof(json_cons_entry));
+    if (slots == NULL) {
+        fprintf(stderr, "json_cons_reserve error: malloc error\n");
+        return false;
+    }
+    for (size_t i = 0; i < p->cons_capacity; i++) {
+        if (p->cons_slots[i].value.value == NULL) continue;
+        size_t j = p->cons_slots[i].hash & (capacity - 1);
+        while (slots[j].value.value != NULL) j = (j + 1) & (capacity - 1);
+        slots[j] = p->cons_slots[i];
+    }
+    free(p->cons_slots);
+    p->cons_slots = slots;
+    p->cons_capacity = capacity;
+    return true;
+}
+static void json_cons_insert(json_parser* p, uint64_t hash, json_value v) {
+    if (v.value == NULL || !json_cons_reserve(p)) return;
+    size_t i = hash & (p->cons_capacity - 1);
+    while (p->cons_slots[i].value.value != NULL) i = (i + 1) & (p->cons_capacity - 1);
+    p->cons_slots[i].hash = hash;
+    p->cons_slots[i].value = v;
+    p->cons_count++;
+}
+static void * json_cons_find_scalar(json_parser* p, uint64_t hash, json_type type, const void* bytes, size_t size) {
+    if (p->cons_capacity == 0) return NULL;
+    size_t i = hash & (p->cons_capacity - 1);
+    for (; p->cons_slots[i].value.value != NULL; i = (i + 1) & (p->cons_capacity - 1)) {
+        json_cons_entry* e = &p->cons_slots[i];
+        if (e->hash == hash && e->value.type == type && memcmp(e->value.value, bytes, size) == 0)
+            return e->value.value;
+    }
+    return NULL;
+}
+//allocate a number or boolean payload, reusing an identical one in hash_cons mode
+static void * json_parser_scalar(json_parser* p, json_type type, const void* bytes, size_t size) {
+    uint64_t hash = 0;
+    if (p->hash_cons) {
+        hash = json_hash_mix(json_hash_string((const char *)bytes, size), type);
+        void * shared = json_cons_find_scalar(p, hash, type, bytes, size);
+        if (shared != NULL) return shared;
+    }
+    void * payload = json_parser_alloc(p, size);
+    if (payload == NULL) return NULL;
+    memcpy(payload, bytes, size);
+    if (p->hash_cons) {
+        json_value v = {type, payload};
+        json_cons_insert(p, hash, v);
+    }
+    return payload;
+}
+static uint64_t json_cons_hash_slots(const json_parser* p, json_type type, size_t base) {
+    uint64_t h = json_hash_mix(type, p->stack_top - base);
+    for (size_t i = base; i < p->stack_top; i++) {
+        h = json_hash_mix(h, (uint64_t)(uintptr_t)p->stack[i].key);
+        h = json_hash_mix(h, p->stack[i].value.type);
+        h = json_hash_mix(h, (uint64_t)(uintptr_t)p->stack[i].value.value);
+    }
+    return h;
+}
+//find a container identical to the children on the scratch stack above base
+static void * json_cons_find_container(json_parser* p, uint64_t hash, json_type type, size_t base) {
+    if (p->cons_capacity == 0) return NULL;
+    json_index count = (json_index)(p->stack_top - base);
+    size_t i = hash & (p->cons_capacity - 1);
+    for (; p->cons_slots[i].value.value != NULL; i = (i + 1) & (p->cons_capacity - 1)) {
+        json_cons_entry* e = &p->cons_slots[i];
+        if (e->hash != hash || e->value.type != type) continue;
+        char** keys = NULL;
+        json_value* values;
+        if (type == JSON_OBJECT) {
+            json_object* o = (json_object *)e->value.value;
+            if (o->last_index + 1 != count) continue;
+            keys = o->keys;
+            values = o->values;
+        }
+        else {
+            json_array* a = (json_array *)e->value.value;
+            if (a->last_index + 1 != count) continue;
+            values = a->values;
+        }
+        json_index k = 0;
+        for (; k < count; k++) {
+            const json_parser_slot* slot = &p->stack[base + k];
+            if ((keys != NULL && keys[k] != slot->key) || !json_same(values[k], slot->value)) break;
+        }
+        if (k == count) return e->value.value;
+    }
+    return NULL;
+}
+
+void json_parser_init(json_parser* p) {
+    memset(p, 0x00, sizeof(json_parser));
+}
+void json_parser_reset(json_parser* p) {
+    for (json_arena_chunk* chunk = p->arena_head; chunk != NULL; chunk = chunk->next)
+        chunk->used = 0;
+    p->arena_current = p->arena_head;
+    p->stack_top = 0;
+    p->hash_consed = false;
+    if (p->intern_count > 0) {
+        memset(p->intern_slots, 0x00, sizeof(char *) * p->intern_capacity);
+        p->intern_count = 0;
+    }
+    if (p->cons_count > 0) {
+        memset(p->cons_slots, 0x00, sizeof(json_cons_entry) * p->cons_capacity);
+        p->cons_count = 0;
+    }
+    if (p->shape_count > 0) {
+        memset(p->shape_slots, 0x00, sizeof(json_shape *) * p->shape_capacity);
+        p->shape_count = 0;
+    }
+}
+void json_parser_free(json_parser* p) {
+    json_arena_chunks_release(p->pool, p->arena_head);
+    free(p->stack);
+    free(p->strbuf.data);
+    free(p->intern_slots);
+    free(p->cons_slots);
+    free(p->shape_slots);
+    memset(p, 0x00, sizeof(json_parser));
+}
+//bytes of arena memory handed out for the current document
+size_t json_parser_memory_usage(const json_parser* p) {
+    size_t used = 0;
+    for (const json_arena_chunk* chunk = p->arena_head; chunk != NULL; chunk = chunk->next)
+        used += chunk->used;
+    return used;
+}
+json_value json_parser_parse(json_parser* p, const char* json_message) {
+    json_parser_reset(p);
+    if (p->heap_nodes) p->hash_cons = false;
+    return json_parse_value(p, &json_message);
+}
+json_document json_parser_detach(json_parser* p, json_value root) {
+    json_document d = {root, NULL, p->pool};
+    if (p->heap_nodes) {
+        fprintf(stderr, "json_parser_detach error: heap_nodes documents are not in the arena, json_free() them\n");
+        d.root = undefined_json;
+        return d;
+    }
+    //chunks the document uses go to the handle, empty ones stay with the parser
+    json_arena_chunk** tail = &d.chunks;
+    json_arena_chunk* kept = NULL;
+    json_arena_chunk* chunk = p->arena_head;
+    while (chunk != NULL) {
+        json_arena_chunk* next = chunk->next;
+        if (chunk->used > 0) {
+            *tail = chunk;
+            tail = &chunk->next;
+        }
+        else {
+            chunk->next = kept;
+            kept = chunk;
+        }
+        chunk = next;
+    }
+    *tail = NULL;
+    p->arena_head = kept;
+    p->arena_size = 0;
+    for (chunk = kept; chunk != NULL; chunk = chunk->next)
+        p->arena_size += chunk->size;
+    //the key, shape and cons tables point into the moved chunks
+    json_parser_reset(p);
+    return d;
+}
+void json_document_free(json_document* d) {
+    json_arena_chunks_release(d->pool, d->chunks);
+    d->chunks = NULL;
+    d->root = undefined_json;
+}
+void json_arena_pool_init(json_arena_pool* pool) {
+    memset(pool, 0x00, sizeof(json_arena_pool));
+}
+void json_arena_pool_free(json_arena_pool* pool) {
+    json_arena_chunk* lists[2] = {pool->free_chunks, pool->returned};
+    for (int i = 0; i < 2; i++) {
+        json_arena_chunk* chunk = lists[i];
+        while (chunk != NULL) {
+            json_arena_chunk* next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+    }
+    memset(pool, 0x00, sizeof(json_arena_pool));
+}
+json_value json_parser_materialize(json_parser* p, json_value raw) {
+    if (raw.type != JSON_RAW || raw.value == NULL) return raw;
+    const json_raw* span = (json_raw *)raw.value;
+    const char* json_message = span->begin;
+    const char* lazy_key = p->lazy_key;
+    p->lazy_key = NULL;
+    json_value v = json_parse_value(p, &json_message);
+    p->lazy_key = lazy_key;
+    return v;
+}
+
+/*
+ * strict validation
+ * one pass over the text without building anything. open containers are kept on a heap
+ * stack of '{' / '[' bytes, so deeply nested input does not grow the C stack.
+ */
+static const char* json_validate_space(const char* s, const char* end) {
+    while (s < end && (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r')) s++;
+    return s;
+}
+//in : "test" (at the opening quote)
+//out: after the closing quote, or at the offending character
+static bool json_validate_string(const char** json_message, const char* end) {
+    const char* s = *json_message;
+    if (s == end || *s != '\"') return false;
+    for (s++; s < end; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '\"') {
+            *json_message = s + 1;
+            return true;
+        }
+        if (c < 0x20) break;
+        if (c != '\\') continue;
+        if (++s == end) break;
+        if (*s == 'u') {
+            int i = 0;
+            while (i < 4 && s + 1 < end && isxdigit((unsigned char)s[1])) {
+                s++;
+                i++;
+            }
+            if (i < 4) break;
+        }
+        else if (*s == '\0' || strchr("\"\\/bfnrt", *s) == NULL) break;
+    }
+    *json_message = s;
+    return false;
+}
+//-?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+static bool json_validate_number(const char** json_message, const char* end) {
+    const char* s = *json_message;
+    bool ok = true;
+    if (s < end && *s == '-') s++;
+    if (s < end && *s == '0') s++;
+    else if (s < end && isdigit((unsigned char)*s)) while (s < end && isdigit((unsigned char)*s)) s++;
+    else ok = false;
+    if (ok && s < end && *s == '.') {
+        s++;
+        ok = s < end && isdigit((unsigned char)*s);
+        while (s < end && isdigit((unsigned char)*s)) s++;
+    }
+    if (ok && s < end && (*s == 'e' || *s == 'E')) {
+        s++;
+        if (s < end && (*s == '+' || *s == '-')) s++;
+        ok = s < end && isdigit((unsigned char)*s);
+        while (s < end && isdigit((unsigned char)*s)) s++;
+    }
+    *json_message = s;
+    return ok;
+}
+//a member key and its colon
+static bool json_validate_key(const char** json_message, const char* end) {
+    *json_message = json_validate_space(*json_message, end);
+    if (!json_validate_string(json_message, end)) return false;
+    *json_message = json_validate_space(*json_message, end);
+    if (*json_message == end || **json_message != ':') return false;
+    (*json_message)++;
+    return true;
+}
+static bool json_validate_document(const char** json_message, const char* end, char** stack, size_t* capacity) {
+    static const char* const literals[] = {"true", "false", "null"};
+    size_t depth = 0;
+    while (true) {
+        //a value
+        const char* s = json_validate_space(*json_message, end);
+        *json_message = s;
+        if (s == end) return false;
+        if (*s == '{' || *s == '[') {
+            char close = *s == '{' ? '}' : ']';
+            *json_message = json_validate_space(s + 1, end);
+            if (*json_message < end && **json_message == close) (*json_message)++;
+            else {
+                if (depth == *capacity) {
+                    size_t grown_capacity = *capacity ? *capacity * 2 : 64;
+                    char* grown = (char *)realloc(*stack, grown_capacity);
+                    if (grown == NULL) {
+                        fprintf(stderr, "json_validate error: malloc error\n");
+                        return false;
+                    }
+                    *stack = grown;
+                    *capacity = grown_capacity;
+                }
+                (*stack)[depth++] = *s;
+                if (*s == '{' && !json_validate_key(json_message, end)) return false;
+                continue;
+            }
+        }
+        else if (*s == '\"') {
+            if (!json_validate_string(json_message, end)) return false;
+        }
+        else if (*s == '-' || isdigit((unsigned char)*s)) {
+            if (!json_validate_number(json_message, end)) return false;
+        }
+        else {
+            size_t i = 0;
+            while (i < 3 && ((size_t)(end - s) < strlen(literals[i]) || memcmp(s, literals[i], strlen(literals[i])) != 0)) i++;
+            if (i == 3) return false;
+            *json_message = s + strlen(literals[i]);
+        }
+        //after a value: close containers until a ',' starts the next member
+        while (true) {
+            *json_message = json_validate_space(*json_message, end);
+            if (depth == 0) return *json_message == end;
+            if (*json_message == end) return false;
+            char open = (*stack)[depth - 1];
+            if (**json_message == (open == '{' ? '}' : ']')) {
+                (*json_message)++;
+                depth--;
+                continue;
+            }
+            if (**json_message != ',') return false;
+            (*json_message)++;
+            if (open == '{' && !json_validate_key(json_message, end)) return false;
+            break;
+        }
+    }
+}
+const char* json_validate(const char* json_message, size_t length) {
+    const char* s = json_message;
+    char* stack = NULL;
+    size_t capacity = 0;
+    bool ok = json_validate_document(&s, json_message + length, &stack, &capacity);
+    free(stack);
+    return ok ? NULL : s;
+}
+
+//moves *json_message past one value without building it.
+//in : value,   (leading white space allowed)
+//out: value,
+//          p
+static bool json_skip_value(const char** json_message) {
+    const char* s = *json_message;
+    int depth = 0;
+    do {
+        while (isspace((unsigned char)*s) || (depth > 0 && (*s == ',' || *s == ':'))) s++;
+        switch (*s) {
+        case '\0':
+            fprintf(stderr, "json_skip_value error: json parser meets NULL");
+            *json_message = s;
+            return false;
+        case '\"':
+            for (s++; *s != '\"'; s++) {
+                if (*s == '\0') {
+                    fprintf(stderr, "json_skip_value error: unterminated string");
+                    *json_message = s;
+                    return false;
+                }
+                if (*s == '\\' && s[1] != '\0') s++;
+            }
+            s++;
+            break;
+        case '{':
+        case '[':
+            depth++;
+            s++;
+            break;
+        case '}':
+        case ']':
+            depth--;
+            s++;
+            break;
+        default:
+            //scalar: runs until the next delimiter
+            while (*s != '\0' && *s != ',' && *s != '}' && *s != ']' && !isspace((unsigned char)*s)) s++;
+        }
+    } while (depth > 0);
+    *json_message = s;
+    return true;
+}
+//parses the value of an object member, or records its span when the key is lazy
+static json_value json_parse_member(json_parser* p, const char* key, const char** json_message) {
+    if (p->lazy_key == NULL || key == NULL || strcmp(key, p->lazy_key) != 0)
+        return json_parse_value(p, json_message);
+    json_value v = {JSON_RAW, NULL};
+    while (isspace((unsigned char)**json_message)) (*json_message)++;
+    const char* begin = *json_message;
+    if (!json_skip_value(json_message)) return undefined_json;
+    json_raw* span = (json_raw *)json_parser_alloc(p, sizeof(json_raw));
+    if (span == NULL) return undefined_json;
+    span->begin = begin;
+    span->length = (size_t)(*json_message - begin);
+    v.value = span;
+    return v;
+}
+
+//length of the number token at s
+static size_t json_number_length(const char* s) {
+    const char* e = s;
+    while (isdigit((unsigned char)*e) || *e == '.' || *e == 'e' || *e == 'E' || *e == '+' || *e == '-') e++;
+    return (size_t)(e - s);
+}
+//make room for extra more bytes and the terminating NUL
+static bool json_strbuf_reserve(json_strbuf* b, size_t extra) {
+    if (b->size + extra < b->capacity) return true;
+    size_t capacity = b->capacity ? b->capacity : JSON_STRBUFSIZE;
+    while (b->size + extra >= capacity) capacity *= 2;
+    char* data = (char *)realloc(b->data, capacity);
+    if (data == NULL) {
+        fprintf(stderr, "json_strbuf_reserve error: malloc error\n");
+        return false;
+    }
+    b->data = data;
+    b->capacity = capacity;
+    return true;
+}
+static bool json_strbuf_append(json_strbuf* b, const char* str, size_t len) {
+    if (!json_strbuf_reserve(b, len)) return false;
+    memcpy(b->data + b->size, str, len);
+    b->size += len;
+    return true;
+}
+
+//in : test" (the opening quote is already consumed)
+//out: the unescaped characters in the parser's reusable buffer, NUL terminated.
+//the caller copies them out at exact size (json_parser_string()).
+static char * json_parse_string(json_parser* p, const char** json_message, size_t* out_size) {
+	json_strbuf* b = &p->strbuf;
+	const char* s = *json_message;
+	b->size = 0;
+	while (true) {
+		//plain characters are copied a whole run at a time
+		const char* run = s;
+		while (*s != '\"' && *s != '\\' && *s != '\0') s++;
+		if (!json_strbuf_append(b, run, (size_t)(s - run))) return NULL;
+		if (*s == '\"') {
+			*json_message = s + 1;
+			b->data[b->size] = '\0';
+			*out_size = b->size;
+			return b->data;
+		}
+		if (*s == '\0' || s[1] == '\0') {
+			*json_message = s + (*s != '\0');
+			fprintf(stderr, "json_string_to_value error: unterminated string\n");
+			return NULL;
+		}
+		char escape = s[1];
+		char ch = 0;
+		switch(escape){
+			case '\"': ch = '\"'; break;
+			case '\\': ch = '\\'; break;
+			case '/': ch = '/'; break;
+			case 'b': ch = '\b'; break;
+			case 'f': ch = '\f'; break;
+			case 'n': ch = '\n'; break;
+			case 'r': ch = '\r'; break;
+			case 't': ch = '\t'; break;
+			//Parsing unicodes are not implemented: the escape is kept as is
+			case 'u':
+				if (!json_strbuf_append(b, "\\u", 2)) return NULL;
+				break;
+			default:
+				fprintf(stderr, "json_string_to_value error: parse errer at escape string '\\%c'\n", escape);
+		}
+		if (ch != 0 && !json_strbuf_append(b, &ch, 1)) return NULL;
+		s += 2;
+	}
+}
+
+static json_value json_parse_value(json_parser* p, const char** json_message) {
     char c;
     char temp[64] = "";
     json_value jsonv;
     jsonv.type = JSON_UNDEFINED;
     jsonv.value = NULL;
 
-    while (c = *((*json_message)++)) {
+    while ((c = *((*json_message)++))) {
         switch (c) {
         //in : {something}
         //   : c   		//c and *json_message are same position
@@ -209,7 +1151,7 @@ json_value json_string_to_value(const char** json_message) {
         case '{':
             (*json_message)--;
             jsonv.type = JSON_OBJECT;
-            jsonv.value = json_create_object(json_message);
+            jsonv.value = json_parse_object(p, json_message);
             return jsonv;
         case '}':
             printf("parse error : unexpected token '}'\n");
@@ -221,7 +1163,7 @@ json_value json_string_to_value(const char** json_message) {
         case '[':
             (*json_message)--;
             jsonv.type = JSON_ARRAY;
-            jsonv.value = json_create_array(json_message);
+            jsonv.value = json_parse_array(p, json_message);
             return jsonv;
         case ']':
             printf("parse error : unexpected token ']'\n");
@@ -233,77 +1175,16 @@ json_value json_string_to_value(const char** json_message) {
         case '\"':
         {
             jsonv.type = JSON_STRING;
-			char* str = (char*)malloc(sizeof(char) * JSON_STRBUFSIZE);
-			int size = 0;
+			//the string is built in the parser's reusable buffer and copied out at exact size
+			size_t size = 0;
+			char* str = json_parse_string(p, json_message, &size);
 			if (str == NULL) {
-				printf("string malloc error;\n");
+				jsonv.type = JSON_UNDEFINED;
 				return jsonv;
 			}
-
-			//TODO : string process
-			while (true) {
-				char ch = *((*json_message)++);
-				switch(ch){
-					case '\\':
-					{
-						char escape = *((*json_message)++);
-						switch(escape){
-							case '\"': str[size] = '\"'; break;
-							case '\\': str[size] = '\\'; break;
-							case '/': str[size] = '/'; break;
-							case 'b': str[size] = '\b'; break;
-							case 'f': str[size] = '\f'; break;
-							case 'n': str[size] = '\n'; break;
-							case 'r': str[size] = '\r'; break;
-							case 't': str[size] = '\t'; break;
-							//Parsing unicodes are not implemented
-							case 'u':{
-								str[size++] = '\\';
-								str[size] = 'u';
-								break;
-							}
-							/*
-							//TODO : Implement parsing unicodes;
-							case 'u':{
-								char chs[4] = {0,};
-								for(int i=0; i<4; i++){
-									chs[i] = tolower(*((*json_message)++));
-									printf("chs[%d] : %c(ascii:%d)\n", i, chs[i], chs[i]);
-									if(chs[i] >= 'a' && chs[i] <= 'f') chs[i] = chs[i] - 'a';
-									else if(chs[i] >= '0' && chs[i] <= '9') chs[i] = chs[i] - '0';
-									else{
-										fprintf(stderr, "json_string_to_value error: parse errer at escape string '\\u'\n");
-										break;
-									}
-								}
-								str[size++] = chs[0]*16+chs[1];
-								str[size] = chs[2]*16+chs[3]; //size will be increased at the end of while
-								break;
-							}
-							*/
-							default:
-								fprintf(stderr, "json_string_to_value error: parse errer at escape string '\\%c'\n", escape);
-						}
-						break;
-					}
-					case '\"':
-						str[size] = '\0';
-						goto JSON_STRBREAK;
-					default:
-						str[size] = ch;
-				}
-				size++;
-				if((size+1) % JSON_STRBUFSIZE == 0){
-					str = (char *)realloc(str, sizeof(char) * JSON_STRBUFSIZE * (1 + (size+1)/JSON_STRBUFSIZE));
-					printf("realloced : %s\n", str);
-					if(str == NULL){
-						printf("string malloc error;\n");
-						return jsonv;
-					}
-				}
-			}
-JSON_STRBREAK:
-			jsonv.value = str;
+			//inline, interned (hash_cons) or an exact-size arena copy
+			jsonv = json_parser_string(p, str, size);
+			if (jsonv.type == JSON_UNDEFINED) printf("string malloc error;\n");
             return jsonv;
         }
         default:
@@ -317,7 +1198,11 @@ JSON_STRBREAK:
                 const char* startptr = (*json_message) - 1;
                 while (isalpha(*((*json_message)++)));
                 (*json_message)--;
-                int size = (*json_message - startptr);
+                size_t size = (size_t)(*json_message - startptr);
+                if (size >= sizeof(temp)) {
+                    fprintf(stderr, "json_string_to_value error: token is too long\n");
+                    return jsonv;
+                }
                 memcpy(temp, startptr, sizeof(char) * size);
                 temp[size] = '\0';
                 if (strcasecmp(temp, "null") == 0) {
@@ -326,9 +1211,8 @@ JSON_STRBREAK:
                 }
                 if (strcasecmp(temp, "false") == 0 || strcasecmp(temp, "true") == 0) {
                     jsonv.type = JSON_BOOLEAN;
-                    jsonv.value = malloc(sizeof(bool));
-                    if (strcasecmp(temp, "false") == 0) *((bool *)jsonv.value) = false;
-                    else *((bool *)jsonv.value) = true;
+                    bool b = strcasecmp(temp, "false") != 0;
+                    jsonv.value = json_parser_scalar(p, JSON_BOOLEAN, &b, sizeof(bool));
                     return jsonv;
                 }
                 printf("BOOLEAN or NULL error\n");
@@ -338,33 +1222,39 @@ JSON_STRBREAK:
             //return : number(integer or double)
             if (isdigit(c) || c == '-' || c == '+' || c == '.') {
                 const char* startptr = (*json_message) - 1;
-                while (true) {
-                    char ch = *((*json_message)++);
-                    if ((isdigit(ch) || ch == '.' || ch=='e' || ch=='E' || ch=='+' || ch == '-') == false)
-                        break;
+                size_t size = json_number_length(startptr);
+                *json_message = startptr + size;
+                if (size >= sizeof(temp)) {
+                    fprintf(stderr, "json_string_to_value error: token is too long\n");
+                    return jsonv;
+                }
+                bool is_double = memchr(startptr, '.', size) || memchr(startptr, 'e', size) || memchr(startptr, 'E', size);
+                if (p->lazy_numbers && !p->heap_nodes && !p->hash_cons) {
+                    //hash_cons needs canonical payloads, so it always converts
+                    jsonv.type = (json_type)(JSON_NUMBER | (is_double ? JSON_DOUBLE : JSON_INTEGER) | JSON_RAW);
+                    jsonv.value = (void *)startptr;
+                    return jsonv;
                 }
-                (*json_message)--;
-                int size = (*json_message - startptr);
                 memcpy(temp, startptr, sizeof(char) * size);
                 temp[size] = '\0';
 				
-				if(strchr(temp, '.') || strchr(temp, 'e') || strchr(temp, 'E')){
+				if(is_double){
 					jsonv.type = (json_type) (JSON_NUMBER|JSON_DOUBLE);
-					jsonv.value = malloc(sizeof(double));
+					double d = atof(temp);
+					jsonv.value = json_parser_scalar(p, jsonv.type, &d, sizeof(double));
 					if (jsonv.value == NULL) {
 						printf("malloc error!\n");
 						return jsonv;
 					}
-					*((double*)jsonv.value) = atof(temp);
 					//printf("temp : %s\n type:%x read : double %f\n", temp, jsonv.type,  *((double *)jsonv.value));
 				} else{
 					jsonv.type = (json_type) (JSON_NUMBER|JSON_INTEGER);
-					jsonv.value = malloc(sizeof(long long int));
+					long long int n = atoll(temp);
+					jsonv.value = json_parser_scalar(p, jsonv.type, &n, sizeof(long long int));
 					if (jsonv.value == NULL) {
 						printf("malloc error!\n");
 						return jsonv;
 					}
-					*((long long int*)jsonv.value) = atoll(temp);
 					//printf("temp : %s\n type:%x read : integer %lld\n", temp, jsonv.type,  *((long long int *)jsonv.value));
 				}
                 return jsonv;
@@ -372,126 +1262,562 @@ JSON_STRBREAK:
         }
         }
     }
+	//leave the NUL for the callers, which stop on it as well
+	(*json_message)--;
 	fprintf(stderr, "json_string_to_value error: json parser meets NULL");
 	return jsonv;
 }
 
-json_value json_create(const char* json_message) {
-    return json_string_to_value(&json_message);
+/*
+ * shapes
+ * keys are interned, so a key sequence is identified by its key pointers. the shapes
+ * live in the arena and the table is cleared by json_parser_reset() like the interned keys.
+ */
+static uint64_t json_shape_last_id = 0;
+static uint64_t json_shape_hash_slots(const json_parser* p, size_t base) {
+    uint64_t h = p->stack_top - base;
+    for (size_t i = base; i < p->stack_top; i++)
+        h = json_hash_mix(h, (uint64_t)(uintptr_t)p->stack[i].key);
+    return h;
 }
-json_array* json_create_array(const char** json_message) {
-    json_array* jsona = (json_array *)malloc(sizeof(json_array));
+static bool json_shape_reserve(json_parser* p) {
+    if ((p->shape_count + 1) * 2 <= p->shape_capacity) return true;
+    size_t capacity = p->shape_capacity ? p->shape_capacity * 2 : 256;
+    json_shape** slots = (json_shape **)calloc(capacity, sizeof(json_shape *));
+    if (slots == NULL) {
+        fprintf(stderr, "json_shape_reserve error: malloc error\n");
+        return false;
+    }
+    for (size_t i = 0; i < p->shape_capacity; i++) {
+        json_shape* shape = p->shape_slots[i];
+        if (shape == NULL) continue;
+        size_t j = shape->hash & (capacity - 1);
+        while (slots[j] != NULL) j = (j + 1) & (capacity - 1);
+        slots[j] = shape;
+    }
+    free(p->shape_slots);
+    p->shape_slots = slots;
+    p->shape_capacity = capacity;
+    return true;
+}
+//the shape of the keys pushed since base, created on first use
+static json_shape* json_parser_shape(json_parser* p, size_t base) {
+    json_index count = (json_index)(p->stack_top - base);
+    if (p->heap_nodes) {
+        json_shape* shape = (json_shape *)malloc(sizeof(json_shape) + sizeof(char *) * (size_t)count);
+        if (shape == NULL) return NULL;
+        shape->id = shape->hash = 0;
+        shape->count = count;
+        for (json_index k = 0; k < count; k++)
+            shape->keys[k] = p->stack[base + k].key;
+        return shape;
+    }
+    uint64_t hash = json_shape_hash_slots(p, base);
+    if (!json_shape_reserve(p)) return NULL;
+    size_t i = hash & (p->shape_capacity - 1);
+    for (; p->shape_slots[i] != NULL; i = (i + 1) & (p->shape_capacity - 1)) {
+        json_shape* shape = p->shape_slots[i];
+        if (shape->hash != hash || shape->count != count) continue;
+        json_index k = 0;
+        while (k < count && shape->keys[k] == p->stack[base + k].key) k++;
+        if (k == count) return shape;
+    }
+    json_shape* shape = (json_shape *)json_parser_alloc(p, sizeof(json_shape) + sizeof(char *) * (size_t)count);
+    if (shape == NULL) return NULL;
+    shape->id = __atomic_add_fetch(&json_shape_last_id, 1, __ATOMIC_RELAXED);
+    shape->hash = hash;
+    shape->count = count;
+    for (json_index k = 0; k < count; k++)
+        shape->keys[k] = p->stack[base + k].key;
+    p->shape_slots[i] = shape;
+    p->shape_count++;
+    return shape;
+}
+
+//move the children pushed since base from the scratch stack into exact-size storage
+static json_array* json_parser_pop_array(json_parser* p, json_array* jsona, size_t base) {
+    json_index count = (json_index)(p->stack_top - base);
+    if (count > 0) {
+        jsona->values = (json_value *)json_parser_alloc(p, sizeof(json_value) * (size_t)count);
+        if (jsona->values == NULL) {
+            p->stack_top = base;
+            return jsona;
+        }
+        for (json_index i = 0; i < count; i++)
+            jsona->values[i] = p->stack[base + i].value;
+    }
+    jsona->capacity = count;
+    jsona->last_index = count - 1;
+    p->stack_top = base;
+    return jsona;
+}
+static json_object* json_parser_pop_object(json_parser* p, json_object* jsono, size_t base) {
+    json_index count = (json_index)(p->stack_top - base);
+    if (count > 0) {
+        json_shape* shape = json_parser_shape(p, base);
+        jsono->keys = shape != NULL ? shape->keys : NULL;
+        jsono->values = (json_value *)json_parser_alloc(p, sizeof(json_value) * (size_t)count);
+        if (jsono->keys == NULL || jsono->values == NULL) {
+            p->stack_top = base;
+            return jsono;
+        }
+        for (json_index i = 0; i < count; i++)
+            jsono->values[i] = p->stack[base + i].value;
+    }
+    jsono->capacity = count;
+    jsono->last_index = count - 1;
+    p->stack_top = base;
+    return jsono;
+}
+
+//in hash_cons mode a closed container that already exists is replaced by the
+//canonical copy and everything allocated for it is handed back to the arena
+static json_array* json_parser_close_array(json_parser* p, json_array* jsona, size_t base, json_arena_mark mark) {
+    if (!p->hash_cons) return json_parser_pop_array(p, jsona, base);
+    p->hash_consed = true;
+    uint64_t hash = json_cons_hash_slots(p, JSON_ARRAY, base);
+    json_array* shared = (json_array *)json_cons_find_container(p, hash, JSON_ARRAY, base);
+    if (shared != NULL) {
+        p->stack_top = base;
+        json_parser_rewind(p, mark);
+        return shared;
+    }
+    json_parser_pop_array(p, jsona, base);
+    json_value v = {JSON_ARRAY, jsona};
+    json_cons_insert(p, hash, v);
+    return jsona;
+}
+static json_object* json_parser_close_object(json_parser* p, json_object* jsono, size_t base, json_arena_mark mark) {
+    if (!p->hash_cons) return json_parser_pop_object(p, jsono, base);
+    p->hash_consed = true;
+    uint64_t hash = json_cons_hash_slots(p, JSON_OBJECT, base);
+    json_object* shared = (json_object *)json_cons_find_container(p, hash, JSON_OBJECT, base);
+    if (shared != NULL) {
+        p->stack_top = base;
+        json_parser_rewind(p, mark);
+        return shared;
+    }
+    json_parser_pop_object(p, jsono, base);
+    json_value v = {JSON_OBJECT, jsono};
+    json_cons_insert(p, hash, v);
+    return jsono;
+}
+
+size_t json_parser_open(json_parser* p) {
+    return p->stack_top;
+}
+bool json_parser_append(json_parser* p, const char* key, json_value v) {
+    char* k = NULL;
+    if (key != NULL) {
+        size_t size = strlen(key);
+        if (p->heap_nodes) {
+            k = (char *)malloc(size + 1);
+            if (k != NULL) memcpy(k, key, size + 1);
+        }
+        else k = json_parser_intern(p, key, size);
+        if (k == NULL) return false;
+    }
+    return json_parser_push(p, k, v);
+}
+json_value json_parser_close(json_parser* p, json_type type, size_t base) {
+    json_value v = {type, NULL};
+    json_arena_mark mark = json_parser_mark(p);
+    if (type == JSON_ARRAY) {
+        json_array* jsona = (json_array *)json_parser_alloc(p, sizeof(json_array));
+        if (jsona != NULL) {
+            memset(jsona, 0x00, sizeof(json_array));
+            jsona->last_index = -1;
+            v.value = json_parser_close_array(p, jsona, base, mark);
+        }
+    }
+    else if (type == JSON_OBJECT) {
+        json_object* jsono = (json_object *)json_parser_alloc(p, sizeof(json_object));
+        if (jsono != NULL) {
+            memset(jsono, 0x00, sizeof(json_object));
+            jsono->last_index = -1;
+            v.value = json_parser_close_object(p, jsono, base, mark);
+        }
+    }
+    if (v.value == NULL) {
+        p->stack_top = base;
+        return undefined_json;
+    }
+    return v;
+}
+json_value json_parser_string(json_parser* p, const char* str, size_t len) {
+    json_value v = {JSON_STRING, NULL};
+    if (json_parser_inline(p, &v, str, len)) return v;
+    if (p->hash_cons) v.value = json_parser_intern(p, str, len);
+    else {
+        v.value = json_parser_alloc(p, len + 1);
+        if (v.value != NULL) {
+            memcpy(v.value, str, len);
+            ((char *)v.value)[len] = '\0';
+        }
+    }
+    return v.value != NULL ? v : undefined_json;
+}
+
+/*
+ * mutation
+ */
+static bool json_parser_mutable(json_parser* p, json_value v, json_type type, const char* func) {
+    if (v.type != type || v.value == NULL) {
+        fprintf(stderr, "%s error: the value is not %s (type : %s)\n", func, type == JSON_OBJECT ? "an object" : "an array", json_type_to_string(v.type));
+        return false;
+    }
+    //how the document was built, not the current flag: hash_cons may have been turned off since
+    if (p->hash_consed) {
+        fprintf(stderr, "%s error: a hash-consed document shares its subtrees and cannot be modified\n", func);
+        return false;
+    }
+    return true;
+}
+//make room for one more value. arena arrays move to a block twice as large (the old one
+//is reclaimed by json_parser_reset()), heap arrays are realloc'd
+static bool json_parser_reserve_values(json_parser* p, json_value** values, json_index count, json_index* capacity) {
+    if (count < *capacity) return true;
+    json_index grown = *capacity >= JSON_INIT_CAPACITY ? *capacity * 2 : JSON_INIT_CAPACITY;
+    json_value* block;
+    if (p->heap_nodes) block = (json_value *)realloc(*values, sizeof(json_value) * (size_t)grown);
+    else {
+        block = (json_value *)json_parser_alloc(p, sizeof(json_value) * (size_t)grown);
+        if (block != NULL && count > 0) memcpy(block, *values, sizeof(json_value) * (size_t)count);
+    }
+    if (block == NULL) {
+        fprintf(stderr, "json_parser_reserve_values error: malloc error\n");
+        return false;
+    }
+    *values = block;
+    *capacity = grown;
+    return true;
+}
+//give o the shape of its keys without keys[skip] (skip < 0 keeps all) and with extra appended
+static bool json_object_reshape(json_parser* p, json_object* o, json_index skip, char* extra) {
+    size_t base = p->stack_top;
+    bool ok = true;
+    for (json_index i = 0; ok && i <= o->last_index; i++)
+        if (i != skip) ok = json_parser_push(p, o->keys[i], undefined_json);
+    if (ok && extra != NULL) ok = json_parser_push(p, extra, undefined_json);
+    json_shape* shape = NULL;
+    if (ok && p->stack_top > base) {
+        shape = json_parser_shape(p, base);
+        ok = shape != NULL;
+    }
+    p->stack_top = base;
+    if (!ok) return false;
+    //a heap object owns its shape, an arena shape stays in the table for other objects
+    if (p->heap_nodes) free(json_object_shape(o));
+    o->keys = shape != NULL ? shape->keys : NULL;
+    return true;
+}
+bool json_object_set(json_parser* p, json_value object, const char* key, json_value v) {
+    if (!json_parser_mutable(p, object, JSON_OBJECT, "json_object_set")) return false;
+    json_object* o = (json_object *)object.value;
+    for (json_index i = 0; i <= o->last_index; i++) {
+        if (strcmp(o->keys[i], key) == 0) {
+            if (p->heap_nodes) json_free(o->values[i]);
+            o->values[i] = v;
+            return true;
+        }
+    }
+    if (!json_parser_reserve_values(p, &o->values, o->last_index + 1, &o->capacity)) return false;
+    size_t size = strlen(key);
+    char* k;
+    if (p->heap_nodes) {
+        k = (char *)malloc(size + 1);
+        if (k != NULL) memcpy(k, key, size + 1);
+    }
+    else k = json_parser_intern(p, key, size);
+    if (k == NULL) return false;
+    if (!json_object_reshape(p, o, -1, k)) {
+        if (p->heap_nodes) free(k);
+        return false;
+    }
+    o->values[++o->last_index] = v;
+    return true;
+}
+bool json_object_delete(json_parser* p, json_value object, const char* key) {
+    if (!json_parser_mutable(p, object, JSON_OBJECT, "json_object_delete")) return false;
+    json_object* o = (json_object *)object.value;
+    json_index slot = 0;
+    while (slot <= o->last_index && strcmp(o->keys[slot], key) != 0) slot++;
+    if (slot > o->last_index) {
+        fprintf(stderr, "json_object_delete error: no value corresponding to the key(%s)\n", key);
+        return false;
+    }
+    char* removed_key = o->keys[slot];
+    json_value removed = o->values[slot];
+    if (!json_object_reshape(p, o, slot, NULL)) return false;
+    memmove(&o->values[slot], &o->values[slot + 1], sizeof(json_value) * (size_t)(o->last_index - slot));
+    o->last_index--;
+    if (p->heap_nodes) {
+        free(removed_key);
+        json_free(removed);
+    }
+    return true;
+}
+bool json_array_push(json_parser* p, json_value array, json_value v) {
+    if (!json_parser_mutable(p, array, JSON_ARRAY, "json_array_push")) return false;
+    json_array* a = (json_array *)array.value;
+    if (!json_parser_reserve_values(p, &a->values, a->last_index + 1, &a->capacity)) return false;
+    a->values[++a->last_index] = v;
+    return true;
+}
+bool json_array_insert(json_parser* p, json_value array, json_index index, json_value v) {
+    if (!json_parser_mutable(p, array, JSON_ARRAY, "json_array_insert")) return false;
+    json_array* a = (json_array *)array.value;
+    if (index < 0 || index > a->last_index + 1) {
+        fprintf(stderr, "json_array_insert error: out of index\n");
+        return false;
+    }
+    if (!json_parser_reserve_values(p, &a->values, a->last_index + 1, &a->capacity)) return false;
+    memmove(&a->values[index + 1], &a->values[index], sizeof(json_value) * (size_t)(a->last_index + 1 - index));
+    a->values[index] = v;
+    a->last_index++;
+    return true;
+}
+bool json_array_set(json_parser* p, json_value array, json_index index, json_value v) {
+    if (!json_parser_mutable(p, array, JSON_ARRAY, "json_array_set")) return false;
+    json_array* a = (json_array *)array.value;
+    if (index < 0 || index > a->last_index) {
+        fprintf(stderr, "json_array_set error: out of index\n");
+        return false;
+    }
+    if (p->heap_nodes) json_free(a->values[index]);
+    a->values[index] = v;
+    return true;
+}
+bool json_array_delete(json_parser* p, json_value array, json_index index) {
+    if (!json_parser_mutable(p, array, JSON_ARRAY, "json_array_delete")) return false;
+    json_array* a = (json_array *)array.value;
+    if (index < 0 || index > a->last_index) {
+        fprintf(stderr, "json_array_delete error: out of index\n");
+        return false;
+    }
+    json_value removed = a->values[index];
+    memmove(&a->values[index], &a->values[index + 1], sizeof(json_value) * (size_t)(a->last_index - index));
+    a->last_index--;
+    if (p->heap_nodes) json_free(removed);
+    return true;
+}
+
+static json_array* json_parse_array(json_parser* p, const char** json_message) {
+    json_arena_mark mark = json_parser_mark(p);
+    json_array* jsona = (json_array *)json_parser_alloc(p, sizeof(json_array));
     memset(jsona, 0x00, sizeof(json_array));
-    jsona->last_index = 0;
+    jsona->last_index = -1;
+    size_t base = p->stack_top;
     char c;
     int stack = 0;
-    while (c = *((*json_message)++)) {
+    while ((c = *((*json_message)++))) {
         switch (c) {
         case '[':
             if (stack == 0) stack++;
             else {
                 (*json_message)--;
-                jsona->values[jsona->last_index] = json_string_to_value(json_message);
-                jsona->last_index++;
+                if (!json_parser_push(p, NULL, json_parse_value(p, json_message)))
+                    return json_parser_pop_array(p, jsona, base);
             }
             break;
         case ']':
-            jsona->last_index--;
-            return jsona;
+            return json_parser_close_array(p, jsona, base, mark);
         default:
             if (isalpha(c) || isdigit(c) || c == '[' || c == '{' || c == '\"' || c == '-' || c=='+' || c=='.') {
                 (*json_message)--; 
-                jsona->values[jsona->last_index] = json_string_to_value(json_message);
-                jsona->last_index++;
+                if (!json_parser_push(p, NULL, json_parse_value(p, json_message)))
+                    return json_parser_pop_array(p, jsona, base);
             }
         }
     }
+	(*json_message)--;
 	fprintf(stderr, "json_create_array error: json parser meets NULL");
-	return jsona;
+	return json_parser_pop_array(p, jsona, base);
 }
-json_object* json_create_object(const char** json_message) {
-    json_object* jsono = (json_object*)malloc(sizeof(json_object));
+static json_object* json_parse_object(json_parser* p, const char** json_message) {
+    json_arena_mark mark = json_parser_mark(p);
+    json_object* jsono = (json_object*)json_parser_alloc(p, sizeof(json_object));
     memset(jsono, 0x00, sizeof(json_object));
-    jsono->last_index = 0;
+    jsono->last_index = -1;
+    size_t base = p->stack_top;
     int stack = 0;
     int keyorvalue = JSON_KEY;
+    char* key = NULL;
     char c;
-    while (c = *((*json_message)++)) {
+    while ((c = *((*json_message)++))) {
         switch (c) {
         case '{':
             if (stack == 0) stack++;
             else {
                 if (keyorvalue == JSON_KEY) {
                     printf("key cannot be an Object\n");
-                    return jsono;
+                    return json_parser_pop_object(p, jsono, base);
                 }
                 (*json_message)--;
-                jsono->values[jsono->last_index] = json_string_to_value(json_message);
-                jsono->last_index++;
+                if (!json_parser_push(p, key, json_parse_member(p, key, json_message)))
+                    return json_parser_pop_object(p, jsono, base);
                 keyorvalue = JSON_KEY;
             }
             break;
         case '}':
-            jsono->last_index--;
-            return jsono;
+            return json_parser_close_object(p, jsono, base, mark);
         default:
             if (isalpha(c) || isdigit(c) || c == '[' || c == '{' || c == '\"' || c == '-' || c=='+' || c=='.') {
                 (*json_message)--;
                 if (keyorvalue == JSON_KEY) {
-                    json_value v = json_string_to_value(json_message);
-                    if (v.type != JSON_STRING) {
+                    if (c != '\"') {
                         printf("Key MUST be a string");
-                        return jsono;
+                        return json_parser_pop_object(p, jsono, base);
+                    }
+                    (*json_message)++;
+                    size_t size = 0;
+                    char* str = json_parse_string(p, json_message, &size);
+                    if (str == NULL) return json_parser_pop_object(p, jsono, base);
+                    if (p->heap_nodes) {
+                        key = (char *)malloc(size + 1);
+                        if (key != NULL) memcpy(key, str, size + 1);
+                    }
+                    else {
+                        //arena documents share a single copy of each distinct key
+                        key = json_parser_intern(p, str, size);
                     }
-                    jsono->keys[jsono->last_index] = (char *)(v.value);
                     keyorvalue = JSON_VALUE;
                 }
                 else {
-                    jsono->values[jsono->last_index] = json_string_to_value(json_message);
-                    jsono->last_index++;
+                    if (!json_parser_push(p, key, json_parse_member(p, key, json_message)))
+                        return json_parser_pop_object(p, jsono, base);
                     keyorvalue = JSON_KEY;
                 }
             }
         }
     }
+	(*json_message)--;
 	fprintf(stderr, "json_create_object error: json parser meets NULL");
-	return jsono;
+	return json_parser_pop_object(p, jsono, base);
+}
+
+//the classic entry points parse through a temporary heap_nodes parser
+json_value json_string_to_value(const char** json_message) {
+    json_parser p;
+    json_parser_init(&p);
+    p.heap_nodes = true;
+    json_value v = json_parse_value(&p, json_message);
+    json_parser_free(&p);
+    return v;
+}
+json_value json_create(const char* json_message) {
+    return json_string_to_value(&json_message);
+}
+json_array* json_create_array(const char** json_message) {
+    json_parser p;
+    json_parser_init(&p);
+    p.heap_nodes = true;
+    json_array* jsona = json_parse_array(&p, json_message);
+    json_parser_free(&p);
+    return jsona;
+}
+json_object* json_create_object(const char** json_message) {
+    json_parser p;
+    json_parser_init(&p);
+    p.heap_nodes = true;
+    json_object* jsono = json_parse_object(&p, json_message);
+    json_parser_free(&p);
+    return jsono;
 }
 
 long long int json_to_longlongint(json_value v){
 	if( ! (v.type & JSON_NUMBER)){
-		fprintf(stderr, "json_to_longlongint error: the type of the json_value is not the type of JSON_NUMBER");
+		json_read_error("json_to_longlongint error: the type of the json_value is not the type of JSON_NUMBER");
 		return 0;
 	}
+	if( v.type & JSON_RAW ){
+		if( v.type & JSON_INTEGER ) return strtoll((const char *)v.value, NULL, 10);
+		return (long long int)strtod((const char *)v.value, NULL);
+	}
 	if( v.type & JSON_INTEGER ) return *((long long int *)(v.value));
 	if( v.type & JSON_DOUBLE ) return (long long int)*((double *)(v.value));
-	fprintf(stderr, "json_to_longlongint error: unknown numeric type");
+	json_read_error("json_to_longlongint error: unknown numeric type");
 	return 0;
 }
 double json_to_double(json_value v){
 	if( ! (v.type & JSON_NUMBER)){
-		fprintf(stderr, "json_to_double error: the type of the json_value is not the type of JSON_NUMBER");
+		json_read_error("json_to_double error: the type of the json_value is not the type of JSON_NUMBER");
 		return 0;
 	}
+	if( v.type & JSON_RAW ){
+		if( v.type & JSON_INTEGER ) return (double)strtoll((const char *)v.value, NULL, 10);
+		return strtod((const char *)v.value, NULL);
+	}
 	if( v.type & JSON_INTEGER ) return (double)*((long long int *)(v.value));
 	if( v.type & JSON_DOUBLE ) return *((double *)(v.value));
-	fprintf(stderr, "json_to_double error: unknown numeric type");
+	json_read_error("json_to_double error: unknown numeric type");
 	return 0;
 }
+size_t json_number_token(json_value v, const char** begin){
+	if( (v.type & (JSON_NUMBER|JSON_RAW)) != (JSON_NUMBER|JSON_RAW) ) return 0;
+	*begin = (const char *)v.value;
+	return json_number_length(*begin);
+}
 bool json_to_bool(json_value v){
 	if( ! (v.type & JSON_BOOLEAN) ){
-		fprintf(stderr, "json_to_bool error: the type of the json_value is not the type of JSON_BOOLEAN");
+		json_read_error("json_to_bool error: the type of the json_value is not the type of JSON_BOOLEAN");
 		return false;
 	}
 	return *((bool *)(v.value));
 }
 char * json_to_string(json_value v){
 	if( ! (v.type & JSON_STRING) ){
-		fprintf(stderr, "json_to_string error: the type of the json_value is not the type of JSON_STRING");
+		json_read_error("json_to_string error: the type of the json_value is not the type of JSON_STRING");
+		return NULL;
+	}
+	if(v.type & JSON_INLINE){
+		json_read_error("json_to_string error: an inline string cannot be returned from a copy, use json_string_of()");
 		return NULL;
 	}
 	return (char *)(v.value);
 }
+const char * json_string_of(const json_value* v){
+	if(v == NULL) return NULL;
+	if(v->type == (JSON_STRING|JSON_INLINE)) return (const char *)&v->value;
+	if(v->type == JSON_STRING) return (const char *)v->value;
+	return NULL;
+}
+//structural equality. nodes shared by hash-consing compare in O(1)
+bool json_equal(json_value a, json_value b){
+	if(json_same(a, b)) return true;
+	//the same text may be inline in one document and not in another
+	if(json_is_string(a) && json_is_string(b)) return strcmp(json_string_of(&a), json_string_of(&b)) == 0;
+	//a lazy number equals a converted one of the same kind
+	if((a.type & JSON_NUMBER) && (b.type & JSON_NUMBER) && a.value != NULL && b.value != NULL){
+		if((a.type & JSON_INTEGER) != (b.type & JSON_INTEGER)) return false;
+		if(a.type & JSON_INTEGER) return json_to_longlongint(a) == json_to_longlongint(b);
+		return json_to_double(a) == json_to_double(b);
+	}
+	if(a.type != b.type || a.value == NULL || b.value == NULL) return false;
+	if(a.type == JSON_BOOLEAN) return *((bool *)a.value) == *((bool *)b.value);
+	if(a.type == JSON_RAW){
+		const json_raw* x = (json_raw *)a.value;
+		const json_raw* y = (json_raw *)b.value;
+		return x->length == y->length && memcmp(x->begin, y->begin, x->length) == 0;
+	}
+	if(a.type == JSON_ARRAY){
+		const json_array* x = (json_array *)a.value;
+		const json_array* y = (json_array *)b.value;
+		if(x->last_index != y->last_index) return false;
+		for(json_index i=0; i<=x->last_index; i++)
+			if(!json_equal(x->values[i], y->values[i])) return false;
+		return true;
+	}
+	if(a.type == JSON_OBJECT){
+		const json_object* x = (json_object *)a.value;
+		const json_object* y = (json_object *)b.value;
+		if(x->last_index != y->last_index) return false;
+		for(json_index i=0; i<=x->last_index; i++)
+			if(strcmp(x->keys[i], y->keys[i]) != 0 || !json_equal(x->values[i], y->values[i])) return false;
+		return true;
+	}
+	return false;
+}
 bool json_is_null(json_value v){
 	return v.type == JSON_NULL;
 }
@@ -499,17 +1825,21 @@ json_type json_get_type(json_value v){
 	return v.type;
 }
 
-const char * const json_type_to_string(int type){
+const char * json_type_to_string(int type){
 	switch(type){
 		case JSON_UNDEFINED: return "undefined";
 		case JSON_NUMBER: return "number";
 		case JSON_NUMBER|JSON_INTEGER: return "number(integer)";
 		case JSON_NUMBER|JSON_DOUBLE: return "number(double)";
+		case JSON_NUMBER|JSON_INTEGER|JSON_RAW: return "number(integer, lazy)";
+		case JSON_NUMBER|JSON_DOUBLE|JSON_RAW: return "number(double, lazy)";
 		case JSON_STRING: return "string";
+		case JSON_STRING|JSON_INLINE: return "string(inline)";
 		case JSON_BOOLEAN: return "boolean";
 		case JSON_ARRAY: return "array";
 		case JSON_OBJECT: return "object";
 		case JSON_NULL: return "null";
+		case JSON_RAW: return "raw";
 		default: return "undefined";
 	}
 }
@@ -518,15 +1848,22 @@ void json_fprint_value(FILE * outfp, const json_value v, int tab) {
     if (v.type == JSON_UNDEFINED) fprintf(outfp, "undefined");
     if (v.type == (JSON_NUMBER|JSON_INTEGER)) fprintf(outfp, "%lld", *((long long int *)(v.value)));
     if (v.type == (JSON_NUMBER|JSON_DOUBLE)) fprintf(outfp, "%f", *((double *)(v.value)));
+    if ((v.type & (JSON_NUMBER|JSON_RAW)) == (JSON_NUMBER|JSON_RAW)) {
+        //a lazy number is written as the token it was parsed from
+        const char* token = NULL;
+        size_t length = json_number_token(v, &token);
+        fprintf(outfp, "%.*s", (int)length, token);
+    }
     if (v.type == JSON_ARRAY) json_fprint_array(outfp, (json_array *)(v.value), tab);
-    if (v.type == JSON_STRING) fprintf(outfp, "\"%s\"", ((char *)(v.value)));
+    if (json_is_string(v)) fprintf(outfp, "\"%s\"", json_string_of(&v));
     if (v.type == JSON_BOOLEAN) fprintf(outfp, *((bool *)(v.value))?"true":"false");
     if (v.type == JSON_OBJECT) {json_fprint_object(outfp, ((json_object*)(v.value)), tab); }
     if (v.type == JSON_NULL) fprintf(outfp, "null");
+    if (v.type == JSON_RAW) fprintf(outfp, "%.*s", (int)((json_raw *)(v.value))->length, ((json_raw *)(v.value))->begin);
 }
 void json_fprint_array(FILE * outfp, const json_array* json, int tab) {
     fprintf(outfp, "[");
-    for (int i = 0; i <= json->last_index; i++) {
+    for (json_index i = 0; i <= json->last_index; i++) {
         json_fprint_value(outfp, json->values[i], tab);
         if(json->last_index != i)
             fprintf(outfp, ", ");
@@ -536,8 +1873,8 @@ void json_fprint_array(FILE * outfp, const json_array* json, int tab) {
 void json_fprint_object(FILE * outfp, const json_object* json, int tab) {
     fprintf(outfp, "{\n");
     tab++;
-    for (int i = 0; i <= json->last_index; i++) {
-        for (int i = 0; i < tab; i++) fprintf(outfp, "\t");
+    for (json_index i = 0; i <= json->last_index; i++) {
+        for (int t = 0; t < tab; t++) fprintf(outfp, "\t");
         fprintf(outfp, "\"%s\": ", json->keys[i]);
         json_fprint_value(outfp, json->values[i], tab);
         if(json->last_index != i)
@@ -575,18 +1912,18 @@ void json_stacktrace_print(FILE * fp, const json_small_stack * const jss){
 	fprintf(fp, "(%s)", json_type_to_string(jss->type[0]));
 
 	for(int i=1; i<=jss->top; i++){
-		if(jss->type[i-1] == JSON_ARRAY) fprintf(fp, "(%s)[%d]", json_type_to_string(jss->type[i]), (int)jss->stacktrace[i-1]);
+		if(jss->type[i-1] == JSON_ARRAY) fprintf(fp, "(%s)[%lld]", json_type_to_string(jss->type[i]), (long long)(intptr_t)jss->stacktrace[i-1]);
 		else if(jss->type[i-1] == JSON_OBJECT){ 
-			if((int)jss->stacktrace[i-1] <= MAX_INDEX && (int)jss->stacktrace[i-1] >= 0) fprintf(fp, "(%s)[%d]", json_type_to_string(jss->type[i]), (int)jss->stacktrace[i-1]);
-			else fprintf(fp, "->(%s)%s", json_type_to_string(jss->type[i]), jss->stacktrace[i-1]);
+			if((intptr_t)jss->stacktrace[i-1] <= MAX_INDEX && (intptr_t)jss->stacktrace[i-1] >= 0) fprintf(fp, "(%s)[%lld]", json_type_to_string(jss->type[i]), (long long)(intptr_t)jss->stacktrace[i-1]);
+			else fprintf(fp, "->(%s)%s", json_type_to_string(jss->type[i]), (const char *)jss->stacktrace[i-1]);
 		}
 		else fprintf(fp, "->(%s)", json_type_to_string(jss->type[i]));
 	}
 
-	if(jss->type[jss->top] == JSON_ARRAY) fprintf(fp, "(%s)[%d]", json_type_to_string(JSON_UNDEFINED), (int)jss->stacktrace[jss->top]);
+	if(jss->type[jss->top] == JSON_ARRAY) fprintf(fp, "(%s)[%lld]", json_type_to_string(JSON_UNDEFINED), (long long)(intptr_t)jss->stacktrace[jss->top]);
 	else if(jss->type[jss->top] == JSON_OBJECT){ 
-		if((int)jss->stacktrace[jss->top] <= MAX_INDEX && (int)jss->stacktrace[jss->top] >= 0) fprintf(fp, "(%s)[%d]", json_type_to_string(JSON_UNDEFINED), (int)jss->stacktrace[jss->top]);
-		else fprintf(fp, "->(%s)%s", json_type_to_string(JSON_UNDEFINED), jss->stacktrace[jss->top]);
+		if((intptr_t)jss->stacktrace[jss->top] <= MAX_INDEX && (intptr_t)jss->stacktrace[jss->top] >= 0) fprintf(fp, "(%s)[%lld]", json_type_to_string(JSON_UNDEFINED), (long long)(intptr_t)jss->stacktrace[jss->top]);
+		else fprintf(fp, "->(%s)%s", json_type_to_string(JSON_UNDEFINED), (const char *)jss->stacktrace[jss->top]);
 	}
 	else fprintf(fp, "->(%s)", json_type_to_string(JSON_UNDEFINED));
 	
@@ -594,7 +1931,7 @@ void json_stacktrace_print(FILE * fp, const json_small_stack * const jss){
 
 void json_free(json_value jsonv) {
     int t = jsonv.type;
-	if (t == JSON_NUMBER || t == JSON_STRING || t == JSON_BOOLEAN) {
+	if (((t & JSON_NUMBER) && !(t & JSON_RAW)) || t == JSON_STRING || t == JSON_BOOLEAN || t == JSON_RAW) {
 		free(jsonv.value);
     }
     else if (t == JSON_ARRAY) {
@@ -609,16 +1946,19 @@ void json_free(json_value jsonv) {
 }
 void json_free_array(json_array* jsona) {
     if (jsona == NULL) return;
-    for (int i = 0; i <= jsona->last_index; i++)
+    for (json_index i = 0; i <= jsona->last_index; i++)
         json_free(jsona->values[i]);
+    free(jsona->values);
     free(jsona);
 }
 void json_free_object(json_object* jsono) {
     if (jsono == NULL) return;
-    for (int i = 0; i <= jsono->last_index; i++) {
+    for (json_index i = 0; i <= jsono->last_index; i++) {
         free(jsono->keys[i]);
         json_free(jsono->values[i]);
     }
+    free(json_object_shape(jsono));
+    free(jsono->values);
     free(jsono);
 }
 
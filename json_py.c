@@ -0,0 +1,550 @@
+/*
+ * json_py.c
+ * CPython extension module "json_c": the json_c.c parser for python programs.
+ * a document is parsed once into the C arena and exposed through lazy proxies:
+ *  - json_c.Object behaves like a read-only dict (collections.abc.Mapping)
+ *  - json_c.Array behaves like a read-only list (collections.abc.Sequence)
+ *  - both compare equal to the dict / list json.loads would return
+ *  - malformed or truncated text raises ValueError, as in json.loads
+ *  - strings, numbers, booleans and null become the usual python objects on access
+ * no python object exists for a node until the node is touched, so walking a small
+ * part of a huge AST only pays for that part.
+ * the same proxies can also be served straight from a json_bp.c archive (load_bp),
+ * skipping the json text entirely.
+ *
+ *   json_c.loads(text)   parse a str / bytes
+ *   json_c.load(path)    parse a file
+ *   json_c.load_bp(path) map a balanced-parentheses archive written by analyzer --write-bp
+ *
+ * build:
+ *   gcc -O2 -shared -fPIC $(python3-config --includes) json_py.c -o json_c$(python3-config --extension-suffix)
+ */
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "json_c.c"
+#include "json_bp.c"
+#include <fcntl.h>
+
+//one parsed document, shared by all proxies created from it
+typedef struct json_py_document_s {
+    PyObject_HEAD
+    json_parser parser;
+    char* text;                       //the parsed message (tree documents)
+    json_bp* bp;                      //or the archive (load_bp documents)
+} json_py_document;
+
+//a container node. tree documents use node, archive documents use bp_node
+typedef struct json_py_node_s {
+    PyObject_HEAD
+    json_py_document* doc;
+    void* node;                       //json_object* / json_array*
+    json_bp_node bp_node;
+    json_bp_node* children;           //archive arrays: child positions, filled on first indexing
+    Py_ssize_t child_count;
+} json_py_node;
+
+static PyTypeObject json_py_document_type;
+static PyTypeObject json_py_object_type;
+static PyTypeObject json_py_array_type;
+
+static void json_py_document_dealloc(json_py_document* self) {
+    json_parser_free(&self->parser);
+    free(self->text);
+    if (self->bp != NULL) {
+        json_bp_free(self->bp);
+        free(self->bp);
+    }
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject* json_py_node_new(PyTypeObject* type, json_py_document* doc, void* node, json_bp_node bp_node) {
+    json_py_node* self = PyObject_New(json_py_node, type);
+    if (self == NULL) return NULL;
+    Py_INCREF(doc);
+    self->doc = doc;
+    self->node = node;
+    self->bp_node = bp_node;
+    self->children = NULL;
+    self->child_count = -1;
+    return (PyObject *)self;
+}
+static void json_py_node_dealloc(json_py_node* self) {
+    Py_DECREF(self->doc);
+    free(self->children);
+    PyObject_Free(self);
+}
+
+/*
+ * value conversion
+ */
+static PyObject* json_py_from_value(json_py_document* doc, json_value v) {
+    switch ((int)v.type) {
+    case JSON_OBJECT: return json_py_node_new(&json_py_object_type, doc, v.value, 0);
+    case JSON_ARRAY: return json_py_node_new(&json_py_array_type, doc, v.value, 0);
+    case JSON_STRING: return PyUnicode_FromString((const char *)v.value);
+    case JSON_STRING|JSON_INLINE: return PyUnicode_FromString(json_string_of(&v));
+    case JSON_NUMBER|JSON_INTEGER: return PyLong_FromLongLong(*((long long int *)v.value));
+    case JSON_NUMBER|JSON_DOUBLE: return PyFloat_FromDouble(*((double *)v.value));
+    case JSON_NUMBER|JSON_INTEGER|JSON_RAW: return PyLong_FromLongLong(json_to_longlongint(v));
+    case JSON_NUMBER|JSON_DOUBLE|JSON_RAW: return PyFloat_FromDouble(json_to_double(v));
+    case JSON_BOOLEAN: return PyBool_FromLong(*((bool *)v.value));
+    default: Py_RETURN_NONE;
+    }
+}
+//copies the key or text of an archive node. returns a malloc'd buffer or NULL
+static char* json_py_bp_string(const json_bp* bp, json_bp_node x, bool key) {
+    char small[1];
+    int64_t len = key ? json_bp_key(bp, x, small, sizeof(small)) : json_bp_text(bp, x, small, sizeof(small));
+    if (len < 0) return NULL;
+    char* buf = (char *)malloc((size_t)len + 1);
+    if (buf == NULL) return NULL;
+    if (key) json_bp_key(bp, x, buf, (size_t)len + 1);
+    else json_bp_text(bp, x, buf, (size_t)len + 1);
+    return buf;
+}
+static PyObject* json_py_from_bp(json_py_document* doc, json_bp_node x) {
+    json_bp_kind kind = json_bp_get_kind(doc->bp, x);
+    switch (kind) {
+    case JSON_BP_OBJECT: return json_py_node_new(&json_py_object_type, doc, NULL, x);
+    case JSON_BP_ARRAY: return json_py_node_new(&json_py_array_type, doc, NULL, x);
+    case JSON_BP_TRUE: Py_RETURN_TRUE;
+    case JSON_BP_FALSE: Py_RETURN_FALSE;
+    case JSON_BP_NULL: Py_RETURN_NONE;
+    default: break;
+    }
+    char* text = json_py_bp_string(doc->bp, x, false);
+    if (text == NULL) return PyErr_NoMemory();
+    PyObject* result;
+    if (kind == JSON_BP_INTEGER) result = PyLong_FromString(text, NULL, 10);
+    else if (kind == JSON_BP_DOUBLE) result = PyFloat_FromDouble(strtod(text, NULL));
+    else result = PyUnicode_FromString(text);
+    free(text);
+    return result;
+}
+
+/*
+ * Object: read-only mapping
+ */
+static Py_ssize_t json_py_object_length(json_py_node* self) {
+    if (self->doc->bp == NULL) return (Py_ssize_t)(((json_object *)self->node)->last_index + 1);
+    Py_ssize_t n = 0;
+    for (json_bp_node c = json_bp_first_child(self->doc->bp, self->bp_node); c != JSON_BP_NONE; c = json_bp_next_sibling(self->doc->bp, c)) n++;
+    return n;
+}
+//finds the member named key. returns a new reference, NULL with no error set when missing
+static PyObject* json_py_object_lookup(json_py_node* self, PyObject* key) {
+    if (!PyUnicode_Check(key)) return NULL;
+    Py_ssize_t size;
+    const char* k = PyUnicode_AsUTF8AndSize(key, &size);
+    if (k == NULL) return NULL;
+    if (self->doc->bp == NULL) {
+        const json_object* o = (json_object *)self->node;
+        for (json_index i = 0; i <= o->last_index; i++)
+            if (strcmp(o->keys[i], k) == 0) return json_py_from_value(self->doc, o->values[i]);
+        return NULL;
+    }
+    char* buf = (char *)malloc((size_t)size + 2);
+    if (buf == NULL) return PyErr_NoMemory();
+    for (json_bp_node c = json_bp_first_child(self->doc->bp, self->bp_node); c != JSON_BP_NONE; c = json_bp_next_sibling(self->doc->bp, c)) {
+        //a key of a different length cannot fit exactly
+        if (json_bp_key(self->doc->bp, c, buf, (size_t)size + 2) == size && memcmp(buf, k, (size_t)size) == 0) {
+            free(buf);
+            return json_py_from_bp(self->doc, c);
+        }
+    }
+    free(buf);
+    return NULL;
+}
+static PyObject* json_py_object_subscript(json_py_node* self, PyObject* key) {
+    PyObject* v = json_py_object_lookup(self, key);
+    if (v == NULL && !PyErr_Occurred()) PyErr_SetObject(PyExc_KeyError, key);
+    return v;
+}
+static int json_py_object_contains(json_py_node* self, PyObject* key) {
+    PyObject* v = json_py_object_lookup(self, key);
+    if (v == NULL) return PyErr_Occurred() ? -1 : 0;
+    Py_DECREF(v);
+    return 1;
+}
+static PyObject* json_py_object_get(json_py_node* self, PyObject* args) {
+    PyObject* key;
+    PyObject* fallback = Py_None;
+    if (!PyArg_ParseTuple(args, "O|O:get", &key, &fallback)) return NULL;
+    PyObject* v = json_py_object_lookup(self, key);
+    if (v == NULL && !PyErr_Occurred()) {
+        Py_INCREF(fallback);
+        return fallback;
+    }
+    return v;
+}
+//builds keys / values / items lists in member order. what: 0 keys, 1 values, 2 items
+static PyObject* json_py_object_list(json_py_node* self, int what) {
+    PyObject* list = PyList_New(0);
+    if (list == NULL) return NULL;
+    json_bp_node c = self->doc->bp != NULL ? json_bp_first_child(self->doc->bp, self->bp_node) : JSON_BP_NONE;
+    const json_object* o = (json_object *)self->node;
+    for (json_index i = 0; self->doc->bp != NULL ? c != JSON_BP_NONE : i <= o->last_index; i++) {
+        PyObject* key = NULL;
+        PyObject* value = NULL;
+        if (what != 1) {
+            if (self->doc->bp == NULL) key = PyUnicode_FromString(o->keys[i]);
+            else {
+                char* k = json_py_bp_string(self->doc->bp, c, true);
+                key = k != NULL ? PyUnicode_FromString(k) : PyErr_NoMemory();
+                free(k);
+            }
+        }
+        if (what != 0) value = self->doc->bp == NULL ? json_py_from_value(self->doc, o->values[i]) : json_py_from_bp(self->doc, c);
+        PyObject* item = what == 0 ? key : what == 1 ? value : (key && value ? PyTuple_Pack(2, key, value) : NULL);
+        if (what == 2) {
+            Py_XDECREF(key);
+            Py_XDECREF(value);
+        }
+        if (item == NULL || PyList_Append(list, item) < 0) {
+            Py_XDECREF(item);
+            Py_DECREF(list);
+            return NULL;
+        }
+        Py_DECREF(item);
+        if (self->doc->bp != NULL) c = json_bp_next_sibling(self->doc->bp, c);
+    }
+    return list;
+}
+static PyObject* json_py_object_keys(json_py_node* self, PyObject* unused) { (void)unused; return json_py_object_list(self, 0); }
+static PyObject* json_py_object_values(json_py_node* self, PyObject* unused) { (void)unused; return json_py_object_list(self, 1); }
+static PyObject* json_py_object_items(json_py_node* self, PyObject* unused) { (void)unused; return json_py_object_list(self, 2); }
+static PyObject* json_py_object_iter(json_py_node* self) {
+    PyObject* keys = json_py_object_list(self, 0);
+    if (keys == NULL) return NULL;
+    PyObject* it = PyObject_GetIter(keys);
+    Py_DECREF(keys);
+    return it;
+}
+
+//== / != against dict and other Objects. the members are compared through a shallow dict,
+//so nested views compare with their own richcompare
+static PyObject* json_py_object_richcompare(json_py_node* self, PyObject* other, int op) {
+    if ((op != Py_EQ && op != Py_NE) || (!PyDict_Check(other) && !PyObject_TypeCheck(other, &json_py_object_type)))
+        Py_RETURN_NOTIMPLEMENTED;
+    PyObject* items[2] = {NULL, NULL};
+    PyObject* dicts[2] = {(PyObject *)self, other};
+    PyObject* result = NULL;
+    for (int i = 0; i < 2; i++) {
+        if (PyDict_Check(dicts[i])) {
+            Py_INCREF(dicts[i]);
+            items[i] = dicts[i];
+            continue;
+        }
+        PyObject* pairs = json_py_object_list((json_py_node *)dicts[i], 2);
+        items[i] = pairs != NULL ? PyDict_New() : NULL;
+        if (items[i] != NULL && PyDict_MergeFromSeq2(items[i], pairs, 1) < 0) Py_CLEAR(items[i]);
+        Py_XDECREF(pairs);
+        if (items[i] == NULL) break;
+    }
+    if (items[0] != NULL && items[1] != NULL) result = PyObject_RichCompare(items[0], items[1], op);
+    Py_XDECREF(items[0]);
+    Py_XDECREF(items[1]);
+    return result;
+}
+
+static PyMappingMethods json_py_object_as_mapping = {
+    (lenfunc)json_py_object_length,
+    (binaryfunc)json_py_object_subscript,
+    NULL,
+};
+static PySequenceMethods json_py_object_as_sequence = {
+    .sq_contains = (objobjproc)json_py_object_contains,
+};
+static PyMethodDef json_py_object_methods[] = {
+    {"get", (PyCFunction)json_py_object_get, METH_VARARGS, "get(key[, default]) -> value"},
+    {"keys", (PyCFunction)json_py_object_keys, METH_NOARGS, "list of member keys"},
+    {"values", (PyCFunction)json_py_object_values, METH_NOARGS, "list of member values"},
+    {"items", (PyCFunction)json_py_object_items, METH_NOARGS, "list of (key, value) pairs"},
+    {NULL, NULL, 0, NULL}
+};
+static PyTypeObject json_py_object_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "json_c.Object",
+    .tp_basicsize = sizeof(json_py_node),
+    .tp_dealloc = (destructor)json_py_node_dealloc,
+    .tp_as_mapping = &json_py_object_as_mapping,
+    .tp_as_sequence = &json_py_object_as_sequence,
+    .tp_iter = (getiterfunc)json_py_object_iter,
+    .tp_richcompare = (richcmpfunc)json_py_object_richcompare,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_MAPPING,
+    .tp_doc = "read-only view of a json object",
+    .tp_methods = json_py_object_methods,
+};
+
+/*
+ * Array: read-only sequence
+ */
+//archive arrays remember their children so indexing is O(1) after the first access
+static bool json_py_array_children(json_py_node* self) {
+    if (self->child_count >= 0) return true;
+    Py_ssize_t n = 0, capacity = 0;
+    for (json_bp_node c = json_bp_first_child(self->doc->bp, self->bp_node); c != JSON_BP_NONE; c = json_bp_next_sibling(self->doc->bp, c)) {
+        if (n == capacity) {
+            capacity = capacity ? capacity * 2 : 8;
+            json_bp_node* grown = (json_bp_node *)realloc(self->children, sizeof(json_bp_node) * (size_t)capacity);
+            if (grown == NULL) {
+                PyErr_NoMemory();
+                return false;
+            }
+            self->children = grown;
+        }
+        self->children[n++] = c;
+    }
+    self->child_count = n;
+    return true;
+}
+static Py_ssize_t json_py_array_length(json_py_node* self) {
+    if (self->doc->bp == NULL) return (Py_ssize_t)(((json_array *)self->node)->last_index + 1);
+    return json_py_array_children(self) ? self->child_count : -1;
+}
+static PyObject* json_py_array_item(json_py_node* self, Py_ssize_t i) {
+    Py_ssize_t n = json_py_array_length(self);
+    if (n < 0) return NULL;
+    if (i < 0 || i >= n) {
+        PyErr_SetString(PyExc_IndexError, "json_c.Array index out of range");
+        return NULL;
+    }
+    if (self->doc->bp == NULL) return json_py_from_value(self->doc, ((json_array *)self->node)->values[i]);
+    return json_py_from_bp(self->doc, self->children[i]);
+}
+static PyObject* json_py_array_subscript(json_py_node* self, PyObject* key) {
+    if (PyIndex_Check(key)) {
+        Py_ssize_t i = PyNumber_AsSsize_t(key, PyExc_IndexError);
+        if (i == -1 && PyErr_Occurred()) return NULL;
+        if (i < 0) i += json_py_array_length(self);
+        return json_py_array_item(self, i);
+    }
+    if (PySlice_Check(key)) {
+        Py_ssize_t start, stop, step;
+        if (PySlice_Unpack(key, &start, &stop, &step) < 0) return NULL;
+        Py_ssize_t count = PySlice_AdjustIndices(json_py_array_length(self), &start, &stop, step);
+        PyObject* list = PyList_New(count);
+        if (list == NULL) return NULL;
+        for (Py_ssize_t k = 0; k < count; k++) {
+            PyObject* item = json_py_array_item(self, start + k * step);
+            if (item == NULL) {
+                Py_DECREF(list);
+                return NULL;
+            }
+            PyList_SET_ITEM(list, k, item);
+        }
+        return list;
+    }
+    PyErr_SetString(PyExc_TypeError, "json_c.Array indices must be integers or slices");
+    return NULL;
+}
+
+//comparisons against list and other Arrays, element by element like list
+static PyObject* json_py_array_richcompare(json_py_node* self, PyObject* other, int op) {
+    if (!PyList_Check(other) && !PyObject_TypeCheck(other, &json_py_array_type)) Py_RETURN_NOTIMPLEMENTED;
+    PyObject* lists[2] = {(PyObject *)self, other};
+    PyObject* items[2] = {NULL, NULL};
+    PyObject* result = NULL;
+    for (int i = 0; i < 2; i++) {
+        if (PyList_Check(lists[i])) {
+            Py_INCREF(lists[i]);
+            items[i] = lists[i];
+        }
+        else {
+            Py_ssize_t n = json_py_array_length((json_py_node *)lists[i]);
+            PyObject* slice = n >= 0 ? PySlice_New(NULL, NULL, NULL) : NULL;
+            items[i] = slice != NULL ? json_py_array_subscript((json_py_node *)lists[i], slice) : NULL;
+            Py_XDECREF(slice);
+        }
+        if (items[i] == NULL) break;
+    }
+    if (items[0] != NULL && items[1] != NULL) result = PyObject_RichCompare(items[0], items[1], op);
+    Py_XDECREF(items[0]);
+    Py_XDECREF(items[1]);
+    return result;
+}
+
+static PySequenceMethods json_py_array_as_sequence = {
+    .sq_length = (lenfunc)json_py_array_length,
+    .sq_item = (ssizeargfunc)json_py_array_item,
+};
+static PyMappingMethods json_py_array_as_mapping = {
+    (lenfunc)json_py_array_length,
+    (binaryfunc)json_py_array_subscript,
+    NULL,
+};
+static PyTypeObject json_py_array_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "json_c.Array",
+    .tp_basicsize = sizeof(json_py_node),
+    .tp_dealloc = (destructor)json_py_node_dealloc,
+    .tp_as_sequence = &json_py_array_as_sequence,
+    .tp_as_mapping = &json_py_array_as_mapping,
+    .tp_richcompare = (richcmpfunc)json_py_array_richcompare,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_SEQUENCE,
+    .tp_doc = "read-only view of a json array",
+};
+
+static PyTypeObject json_py_document_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "json_c.Document",
+    .tp_basicsize = sizeof(json_py_document),
+    .tp_dealloc = (destructor)json_py_document_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "parsed json document backing Object and Array views",
+};
+
+/*
+ * module functions
+ */
+static json_py_document* json_py_document_new(void) {
+    json_py_document* doc = PyObject_New(json_py_document, &json_py_document_type);
+    if (doc == NULL) return NULL;
+    json_parser_init(&doc->parser);
+    //values are copied into python objects on access, so short strings can stay inline
+    //and numbers are only converted when they are read (doc->text lives as long as the document)
+    doc->parser.inline_strings = true;
+    doc->parser.lazy_numbers = true;
+    doc->parser.huge_page_threshold = JSON_ARENA_HUGE_PAGE_THRESHOLD;
+    doc->text = NULL;
+    doc->bp = NULL;
+    return doc;
+}
+//parses the size bytes of text owned by doc and returns the root value.
+//like json.loads, anything but one complete value (and white space) is a ValueError
+static PyObject* json_py_parse(json_py_document* doc, size_t size) {
+    json_value root = undefined_json;
+    const char* error;
+    Py_BEGIN_ALLOW_THREADS
+    error = json_validate(doc->text, size);
+    if (error == NULL) root = json_parser_parse(&doc->parser, doc->text);
+    Py_END_ALLOW_THREADS
+    if (error != NULL) {
+        Py_ssize_t offset = (Py_ssize_t)(error - doc->text);
+        Py_DECREF(doc);
+        PyErr_Format(PyExc_ValueError, "json_c: invalid json at offset %zd", offset);
+        return NULL;
+    }
+    if (root.type == JSON_UNDEFINED) {
+        Py_DECREF(doc);
+        PyErr_SetString(PyExc_ValueError, "json_c: cannot parse the document");
+        return NULL;
+    }
+    PyObject* result = json_py_from_value(doc, root);
+    Py_DECREF(doc);
+    return result;
+}
+static PyObject* json_py_loads(PyObject* module, PyObject* arg) {
+    (void)module;
+    const char* text;
+    Py_ssize_t size;
+    if (PyUnicode_Check(arg)) text = PyUnicode_AsUTF8AndSize(arg, &size);
+    else if (PyBytes_AsStringAndSize(arg, (char **)&text, &size) < 0) text = NULL;
+    if (text == NULL) return NULL;
+    json_py_document* doc = json_py_document_new();
+    if (doc == NULL) return NULL;
+    doc->text = (char *)malloc((size_t)size + 1);
+    if (doc->text == NULL) {
+        Py_DECREF(doc);
+        return PyErr_NoMemory();
+    }
+    memcpy(doc->text, text, (size_t)size);
+    doc->text[size] = '\0';
+    return json_py_parse(doc, (size_t)size);
+}
+static PyObject* json_py_load(PyObject* module, PyObject* args) {
+    (void)module;
+    const char* path;
+    if (!PyArg_ParseTuple(args, "s:load", &path)) return NULL;
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) return PyErr_SetFromErrnoWithFilename(PyExc_OSError, path);
+    json_py_document* doc = json_py_document_new();
+    if (doc == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+    //off_t, so files past 2 GB are not truncated (Python.h builds with 64-bit file offsets)
+    fseeko(fp, 0, SEEK_END);
+    off_t size = ftello(fp);
+    fseeko(fp, 0, SEEK_SET);
+    if (size < 0 || (uint64_t)size >= (uint64_t)PY_SSIZE_T_MAX) {
+        fclose(fp);
+        Py_DECREF(doc);
+        PyErr_Format(PyExc_OSError, "json_c: cannot get the size of %s", path);
+        return NULL;
+    }
+    doc->text = (char *)malloc((size_t)size + 1);
+    if (doc->text == NULL) {
+        fclose(fp);
+        Py_DECREF(doc);
+        return PyErr_NoMemory();
+    }
+    size_t read_size = fread(doc->text, 1, (size_t)size, fp);
+    doc->text[read_size] = '\0';
+    fclose(fp);
+    return json_py_parse(doc, read_size);
+}
+static PyObject* json_py_load_bp(PyObject* module, PyObject* args) {
+    (void)module;
+    const char* path;
+    if (!PyArg_ParseTuple(args, "s:load_bp", &path)) return NULL;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return PyErr_SetFromErrnoWithFilename(PyExc_OSError, path);
+    json_py_document* doc = json_py_document_new();
+    if (doc == NULL) {
+        close(fd);
+        return NULL;
+    }
+    //mapped, so processes loading the same archive (or forked after loading it) share its pages
+    doc->bp = (json_bp *)malloc(sizeof(json_bp));
+    bool ok = doc->bp != NULL && json_bp_map(doc->bp, fd);
+    close(fd);
+    if (!ok) {
+        free(doc->bp);
+        doc->bp = NULL;
+        Py_DECREF(doc);
+        PyErr_Format(PyExc_ValueError, "json_c: %s is not a json_bp archive", path);
+        return NULL;
+    }
+    PyObject* result = json_py_from_bp(doc, json_bp_root(doc->bp));
+    Py_DECREF(doc);
+    return result;
+}
+
+static PyMethodDef json_py_methods[] = {
+    {"loads", (PyCFunction)json_py_loads, METH_O, "loads(text) -> Object / Array / scalar"},
+    {"load", (PyCFunction)json_py_load, METH_VARARGS, "load(path) -> Object / Array / scalar"},
+    {"load_bp", (PyCFunction)json_py_load_bp, METH_VARARGS, "load_bp(path) -> views over a json_bp archive"},
+    {NULL, NULL, 0, NULL}
+};
+static struct PyModuleDef json_py_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "json_c",
+    .m_doc = "json_c.c parser with lazy dict/list views",
+    .m_size = -1,
+    .m_methods = json_py_methods,
+};
+
+PyMODINIT_FUNC PyInit_json_c(void) {
+    if (PyType_Ready(&json_py_document_type) < 0 || PyType_Ready(&json_py_object_type) < 0 || PyType_Ready(&json_py_array_type) < 0)
+        return NULL;
+    PyObject* m = PyModule_Create(&json_py_module);
+    if (m == NULL) return NULL;
+    Py_INCREF(&json_py_object_type);
+    Py_INCREF(&json_py_array_type);
+    PyModule_AddObject(m, "Object", (PyObject *)&json_py_object_type);
+    PyModule_AddObject(m, "Array", (PyObject *)&json_py_array_type);
+    //register the views so isinstance(x, Mapping / Sequence) holds
+    PyObject* abc = PyImport_ImportModule("collections.abc");
+    if (abc != NULL) {
+        PyObject* mapping = PyObject_GetAttrString(abc, "Mapping");
+        PyObject* sequence = PyObject_GetAttrString(abc, "Sequence");
+        if (mapping != NULL) Py_XDECREF(PyObject_CallMethod(mapping, "register", "O", (PyObject *)&json_py_object_type));
+        if (sequence != NULL) Py_XDECREF(PyObject_CallMethod(sequence, "register", "O", (PyObject *)&json_py_array_type));
+        Py_XDECREF(mapping);
+        Py_XDECREF(sequence);
+        Py_DECREF(abc);
+    }
+    PyErr_Clear();
+    return m;
+}